@@ -0,0 +1,142 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic
+#include <new> // for placement new
+
+#include "EpochReclamation.h"
+#include "ThreadCachedNodeAllocator.h"
+
+// A lock-free multi-producer, multi-consumer FIFO queue.
+//
+// This is the Michael-Scott queue: a singly-linked chain of nodes like
+// LinkedList's, always headed by a sentinel node. pushBack links a new node
+// after the tail with a compare-and-swap; popFront swings head_ to the
+// sentinel's successor, which then becomes the new sentinel. Unlinked
+// sentinels are freed through EpochReclamation, and node storage comes from
+// the thread-cached node pool, so neither operation calls malloc in the
+// steady state.
+//
+// Items are copied out by popFront before the node is unlinked, so T must be
+// copyable, and its copy constructor may run concurrently on the same
+// source item from several consumers.
+template <typename T>
+class ConcurrentLinkedQueue {
+public:
+
+  class Node {
+  public:
+    // The next node in the queue, or nullptr if this is the last node.
+    std::atomic<Node*> next;
+    // Whether data holds an item. (The initial sentinel doesn't.)
+    bool hasData;
+    // Storage for the data item, constructed by pushBack.
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    Node() : next(nullptr), hasData(false) {}
+
+    T& data() { return *reinterpret_cast<T*>(storage); }
+  };
+
+  ConcurrentLinkedQueue() {
+    Node* sentinel = new (NodePool::allocate()) Node();
+    head_.store(sentinel, std::memory_order_relaxed);
+    tail_.store(sentinel, std::memory_order_relaxed);
+  }
+
+  ConcurrentLinkedQueue(const ConcurrentLinkedQueue&) = delete;
+  ConcurrentLinkedQueue& operator=(const ConcurrentLinkedQueue&) = delete;
+
+  // No other thread may be using the queue while it is destroyed.
+  ~ConcurrentLinkedQueue() {
+    // The sentinel still holds the copy of the last popped item, which is
+    // destroyed with it, as when a sentinel is retired.
+    Node* cur = head_.load(std::memory_order_relaxed);
+    while (cur) {
+      Node* next = cur->next.load(std::memory_order_relaxed);
+      destroyNode(cur);
+      cur = next;
+    }
+  }
+
+  // Push a copy of the new data item onto the back of the queue.
+  void pushBack(const T& newData) {
+    Node* newNode = new (NodePool::allocate()) Node();
+    try {
+      new (newNode->storage) T(newData);
+    }
+    catch (...) {
+      NodePool::deallocate(newNode);
+      throw;
+    }
+    newNode->hasData = true;
+
+    EpochGuard guard;
+    while (true) {
+      Node* tail = tail_.load(std::memory_order_acquire);
+      Node* next = tail->next.load(std::memory_order_acquire);
+      if (tail != tail_.load(std::memory_order_acquire)) continue;
+      if (next) {
+        // The tail is lagging behind; help move it along.
+        tail_.compare_exchange_weak(tail, next, std::memory_order_release, std::memory_order_relaxed);
+        continue;
+      }
+      if (tail->next.compare_exchange_weak(next, newNode, std::memory_order_release, std::memory_order_relaxed)) {
+        tail_.compare_exchange_strong(tail, newNode, std::memory_order_release, std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+  // Copy the front item into out and remove it. Returns false if the queue
+  // was empty.
+  bool popFront(T& out) {
+    EpochGuard guard;
+    while (true) {
+      Node* head = head_.load(std::memory_order_acquire);
+      Node* tail = tail_.load(std::memory_order_acquire);
+      Node* next = head->next.load(std::memory_order_acquire);
+      if (head != head_.load(std::memory_order_acquire)) continue;
+      if (!next) return false;
+      if (head == tail) {
+        // The tail is lagging behind; help move it along.
+        tail_.compare_exchange_weak(tail, next, std::memory_order_release, std::memory_order_relaxed);
+        continue;
+      }
+      // Read the item before unlinking: once head_ moves on, another
+      // consumer may pop the next node too, but it can't be freed while we
+      // hold the guard.
+      T item = next->data();
+      if (head_.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        out = item;
+        EpochReclamation::retire(head, &retireNode);
+        return true;
+      }
+    }
+  }
+
+  // Whether the queue looked empty at some point during the call.
+  bool empty() const {
+    EpochGuard guard;
+    Node* head = head_.load(std::memory_order_acquire);
+    return head->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+private:
+  using NodePool = NodeCache<sizeof(Node)>;
+
+  static void destroyNode(Node* node) {
+    if (node->hasData) node->data().~T();
+    node->~Node();
+    NodePool::deallocate(node);
+  }
+
+  static void retireNode(void* node) {
+    destroyNode(static_cast<Node*>(node));
+  }
+
+  // head_ and tail_ are on separate cache lines so that producers and
+  // consumers don't invalidate each other's line.
+  alignas(64) std::atomic<Node*> head_;
+  alignas(64) std::atomic<Node*> tail_;
+};
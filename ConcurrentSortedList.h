@@ -0,0 +1,211 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic
+#include <cstddef> // for std::max_align_t
+#include <cstdint> // for std::uintptr_t
+#include <new> // for placement new
+
+#include "EpochReclamation.h"
+#include "ThreadCachedNodeAllocator.h"
+
+// A lock-free sorted singly-linked list, for threads that all insert into
+// the same sorted list with insertOrdered.
+//
+// This is the Harris-Michael list. The low bit of a node's next pointer is
+// a "deleted" mark: erase first sets the mark on the victim's next pointer,
+// which logically removes it and stops anyone from linking a node after it,
+// and then tries to swing the predecessor's next pointer past it. Any thread
+// that walks past a marked node helps unlink it, so an erase that loses the
+// race is finished by someone else. Unlinked nodes are freed through
+// EpochReclamation, and node storage comes from the thread-cached node pool.
+//
+// As with LinkedList::insertOrdered, a new item goes in front of the first
+// item that is greater than it, so equal items keep their insertion order
+// (as far as concurrent insertions have an order). Only operator< is used.
+template <typename T>
+class ConcurrentSortedList {
+public:
+
+  class Node {
+  public:
+    // The next node and the deleted mark of this node, packed together.
+    std::atomic<std::uintptr_t> next;
+    // Storage for the data item. It is constructed before the node is
+    // published and never changes afterwards. (The head sentinel has none.)
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    Node() : next(0) {}
+
+    const T& data() const { return *reinterpret_cast<const T*>(storage); }
+  };
+
+  static_assert(alignof(Node) <= alignof(std::max_align_t), "item alignment not supported by the node pool");
+
+  ConcurrentSortedList() : size_(0) {
+    head_ = new (NodePool::allocate()) Node();
+  }
+
+  ConcurrentSortedList(const ConcurrentSortedList&) = delete;
+  ConcurrentSortedList& operator=(const ConcurrentSortedList&) = delete;
+
+  // No other thread may be using the list while it is destroyed. Nodes that
+  // were unlinked are already owned by EpochReclamation; every node still
+  // linked, marked or not, is freed here.
+  ~ConcurrentSortedList() {
+    Node* cur = pointer(head_->next.load(std::memory_order_relaxed));
+    while (cur) {
+      Node* next = pointer(cur->next.load(std::memory_order_relaxed));
+      destroyNode(cur);
+      cur = next;
+    }
+    head_->~Node();
+    NodePool::deallocate(head_);
+  }
+
+  // Insert a copy of the new data item in front of the first item that is
+  // greater than it, or at the end if there is none.
+  void insertOrdered(const T& newData) {
+    Node* newNode = new (NodePool::allocate()) Node();
+    try {
+      new (newNode->storage) T(newData);
+    }
+    catch (...) {
+      NodePool::deallocate(newNode);
+      throw;
+    }
+
+    EpochGuard guard;
+    while (true) {
+      Window w = find([&](const T& item) { return !(newData < item); });
+      std::uintptr_t expected = address(w.cur);
+      newNode->next.store(expected, std::memory_order_relaxed);
+      if (w.prev->next.compare_exchange_strong(expected, address(newNode),
+                                               std::memory_order_release, std::memory_order_relaxed)) {
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+  // Remove the first item that is equal to the given one. Returns false if
+  // there was no such item.
+  bool erase(const T& item) {
+    EpochGuard guard;
+    while (true) {
+      Window w = find([&](const T& other) { return other < item; });
+      if (!w.cur || item < w.cur->data()) return false;
+
+      // Logically delete the node by marking its next pointer.
+      std::uintptr_t succ = w.cur->next.load(std::memory_order_acquire);
+      if (isMarked(succ)) continue;
+      if (!w.cur->next.compare_exchange_strong(succ, succ | MARK,
+                                               std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        continue;
+      }
+      size_.fetch_sub(1, std::memory_order_relaxed);
+
+      // Then try to unlink it; if that fails, a later find will.
+      std::uintptr_t expected = address(w.cur);
+      if (w.prev->next.compare_exchange_strong(expected, succ,
+                                               std::memory_order_release, std::memory_order_relaxed)) {
+        EpochReclamation::retire(w.cur, &retireNode);
+      }
+      else {
+        find([&](const T& other) { return other < item; });
+      }
+      return true;
+    }
+  }
+
+  // Whether an item equal to the given one is in the list. This only reads,
+  // and never helps unlink deleted nodes.
+  bool contains(const T& item) const {
+    EpochGuard guard;
+    Node* cur = pointer(head_->next.load(std::memory_order_acquire));
+    while (cur) {
+      std::uintptr_t succ = cur->next.load(std::memory_order_acquire);
+      if (!(cur->data() < item)) {
+        if (item < cur->data()) return false;
+        if (!isMarked(succ)) return true;
+      }
+      cur = pointer(succ);
+    }
+    return false;
+  }
+
+  // Calls visit(item) for each item in order. Items inserted or erased
+  // during the traversal may or may not be visited, but the visited items
+  // are always in sorted order.
+  template <typename Visitor>
+  void forEach(Visitor visit) const {
+    EpochGuard guard;
+    Node* cur = pointer(head_->next.load(std::memory_order_acquire));
+    while (cur) {
+      std::uintptr_t succ = cur->next.load(std::memory_order_acquire);
+      if (!isMarked(succ)) visit(cur->data());
+      cur = pointer(succ);
+    }
+  }
+
+  // The number of items, exact whenever no operation is in progress.
+  int size() const { return size_.load(std::memory_order_relaxed); }
+
+  bool empty() const { return size() == 0; }
+
+private:
+  using NodePool = NodeCache<sizeof(Node)>;
+
+  static constexpr std::uintptr_t MARK = 1;
+
+  static bool isMarked(std::uintptr_t link) { return link & MARK; }
+  static Node* pointer(std::uintptr_t link) { return reinterpret_cast<Node*>(link & ~MARK); }
+  static std::uintptr_t address(Node* node) { return reinterpret_cast<std::uintptr_t>(node); }
+
+  // cur is the first unmarked node for which advance(item) was false, or
+  // nullptr, and prev is the node that linked to it.
+  struct Window {
+    Node* prev;
+    Node* cur;
+  };
+
+  // Walk from the head past every item for which advance(item) is true,
+  // unlinking any deleted nodes on the way. Must be called inside a guard.
+  template <typename Advance>
+  Window find(Advance advance) {
+  retry:
+    Node* prev = head_;
+    Node* cur = pointer(prev->next.load(std::memory_order_acquire));
+    while (cur) {
+      std::uintptr_t succ = cur->next.load(std::memory_order_acquire);
+      if (isMarked(succ)) {
+        // Fails if prev was deleted too, or something was linked after it.
+        std::uintptr_t expected = address(cur);
+        if (!prev->next.compare_exchange_strong(expected, succ & ~MARK,
+                                                std::memory_order_acq_rel, std::memory_order_acquire)) {
+          goto retry;
+        }
+        EpochReclamation::retire(cur, &retireNode);
+        cur = pointer(succ);
+        continue;
+      }
+      if (!advance(cur->data())) break;
+      prev = cur;
+      cur = pointer(succ);
+    }
+    return Window{prev, cur};
+  }
+
+  static void destroyNode(Node* node) {
+    reinterpret_cast<T*>(node->storage)->~T();
+    node->~Node();
+    NodePool::deallocate(node);
+  }
+
+  static void retireNode(void* node) {
+    destroyNode(static_cast<Node*>(node));
+  }
+
+  Node* head_;
+  std::atomic<int> size_;
+};
@@ -0,0 +1,121 @@
+
+#pragma once
+
+#include <cstdint> // for std::uint64_t
+#include <ostream> // for std::ostream
+#include <utility> // for std::move
+
+// An item wrapper that counts what algorithms do with their items, for
+// analysing the list algorithms on real inputs without changing them:
+//
+//   LinkedList<Counted<int>> list = ...;
+//   CountedOps ops = measureCountedOps([&] { sorted = list.mergeSortRecursive(); });
+//   // ops.comparisons, ops.copies, ...
+//
+// Counted<T> holds a T and behaves like it under the comparison operators,
+// copies and moves, adding one to the calling thread's counts for each.
+// Constructing a Counted<T> from a plain T is not counted; that is making
+// an item, not moving one.
+//
+// The counts are per thread, so concurrent algorithms are only seen from
+// the thread that measures.
+
+struct CountedOps {
+  // <, <=, >, >=, == and != between items.
+  std::uint64_t comparisons = 0;
+  std::uint64_t copies = 0;
+  std::uint64_t moves = 0;
+  std::uint64_t copyAssignments = 0;
+  std::uint64_t moveAssignments = 0;
+
+  CountedOps operator-(const CountedOps& other) const {
+    CountedOps diff;
+    diff.comparisons = comparisons - other.comparisons;
+    diff.copies = copies - other.copies;
+    diff.moves = moves - other.moves;
+    diff.copyAssignments = copyAssignments - other.copyAssignments;
+    diff.moveAssignments = moveAssignments - other.moveAssignments;
+    return diff;
+  }
+};
+
+// The running counts for the calling thread. They are never reset; use
+// measureCountedOps, or take the difference of two snapshots.
+inline CountedOps& countedOps() {
+  static thread_local CountedOps ops;
+  return ops;
+}
+
+// Runs f() and returns the operations on Counted items it did on this
+// thread.
+template <typename F>
+CountedOps measureCountedOps(F f) {
+  CountedOps before = countedOps();
+  f();
+  return countedOps() - before;
+}
+
+template <typename T>
+class Counted {
+public:
+  Counted() : value_() {}
+  Counted(const T& value) : value_(value) {}
+
+  Counted(const Counted& other) : value_(other.value_) {
+    countedOps().copies++;
+  }
+
+  Counted(Counted&& other) : value_(std::move(other.value_)) {
+    countedOps().moves++;
+  }
+
+  Counted& operator=(const Counted& other) {
+    value_ = other.value_;
+    countedOps().copyAssignments++;
+    return *this;
+  }
+
+  Counted& operator=(Counted&& other) {
+    value_ = std::move(other.value_);
+    countedOps().moveAssignments++;
+    return *this;
+  }
+
+  const T& value() const { return value_; }
+
+  friend bool operator<(const Counted& a, const Counted& b) {
+    compared();
+    return a.value_ < b.value_;
+  }
+  friend bool operator<=(const Counted& a, const Counted& b) {
+    compared();
+    return a.value_ <= b.value_;
+  }
+  friend bool operator>(const Counted& a, const Counted& b) {
+    compared();
+    return a.value_ > b.value_;
+  }
+  friend bool operator>=(const Counted& a, const Counted& b) {
+    compared();
+    return a.value_ >= b.value_;
+  }
+  friend bool operator==(const Counted& a, const Counted& b) {
+    compared();
+    return a.value_ == b.value_;
+  }
+  friend bool operator!=(const Counted& a, const Counted& b) {
+    compared();
+    return a.value_ != b.value_;
+  }
+
+  // Prints like the wrapped item, so that lists of counted items print the
+  // same as lists of plain ones.
+  friend std::ostream& operator<<(std::ostream& os, const Counted& item) {
+    return os << item.value_;
+  }
+
+private:
+  static void compared() { countedOps().comparisons++; }
+
+  T value_;
+};
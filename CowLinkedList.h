@@ -0,0 +1,129 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic
+#include <ostream> // for std::ostream
+
+#include "LinkedList.h"
+
+// An opt-in copy-on-write wrapper around LinkedList<T, Alloc>.
+//
+// Copying a LinkedList copies every node, even though most copies are only
+// ever read. A CowLinkedList instead keeps its list in a shared control
+// block with a reference count: a copy just points at the same block, and
+// the nodes are cloned by the first mutating call on a copy whose block is
+// shared. Reads never clone.
+//
+// The reference count is atomic, so copies of one CowLinkedList can be read
+// and mutated on different threads. As with LinkedList, one CowLinkedList
+// object must not be used by two threads at once if either of them mutates.
+//
+// The list can be read directly with get(), or through the forwarding
+// functions below. The mutating functions forward to the LinkedList after
+// making sure this object is the block's only owner.
+template <typename T, typename Alloc = HeapNodeAllocator>
+class CowLinkedList {
+public:
+  using ListType = LinkedList<T, Alloc>;
+
+  // Default constructor: The list will be empty.
+  CowLinkedList() : shared_(new Shared()) {}
+
+  // Wrap a copy of an existing list. This is the only deep copy made until
+  // something is mutated.
+  explicit CowLinkedList(const ListType& list) : shared_(new Shared(list)) {}
+
+  // Copies share the other list's nodes, in O(1) time.
+  CowLinkedList(const CowLinkedList& other) : shared_(other.shared_) {
+    shared_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  CowLinkedList& operator=(const CowLinkedList& other) {
+    Shared* old = shared_;
+    other.shared_->refs.fetch_add(1, std::memory_order_relaxed);
+    shared_ = other.shared_;
+    release(old);
+    return *this;
+  }
+
+  ~CowLinkedList() {
+    release(shared_);
+  }
+
+  // Read access to the list. The reference stays valid until this object
+  // is mutated or destroyed.
+  const ListType& get() const { return shared_->list; }
+
+  // Write access to the list, cloning it first if it is shared. Don't keep
+  // the reference across a copy of this object: the copy would see later
+  // changes made through it.
+  ListType& edit() {
+    if (shared_->refs.load(std::memory_order_acquire) != 1) {
+      Shared* clone = new Shared(shared_->list);
+      release(shared_);
+      shared_ = clone;
+    }
+    return shared_->list;
+  }
+
+  // Whether other copies currently share this list's nodes.
+  bool isShared() const { return shared_->refs.load(std::memory_order_acquire) != 1; }
+
+  // ---- Reads: these never clone. ----
+
+  int size() const { return get().size(); }
+  bool empty() const { return get().empty(); }
+  const T& front() const { return get().front(); }
+  const T& back() const { return get().back(); }
+  bool isSorted() const { return get().isSorted(); }
+  std::ostream& print(std::ostream& os) const { return get().print(os); }
+
+  bool equals(const CowLinkedList& other) const {
+    return shared_ == other.shared_ || get().equals(other.get());
+  }
+  bool operator==(const CowLinkedList& other) const { return equals(other); }
+  bool operator!=(const CowLinkedList& other) const { return !equals(other); }
+
+  // ---- Writes: these clone the list first if it is shared. ----
+
+  void pushFront(const T& newData) { edit().pushFront(newData); }
+  void pushBack(const T& newData) { edit().pushBack(newData); }
+  void popFront() { edit().popFront(); }
+  void popBack() { edit().popBack(); }
+  void insertOrdered(const T& newData) { edit().insertOrdered(newData); }
+
+  // Clearing a shared list doesn't need a clone: this object just lets go
+  // of the shared block and starts a new, empty one.
+  void clear() {
+    if (isShared()) {
+      Shared* fresh = new Shared(ListType(shared_->list.allocator()));
+      release(shared_);
+      shared_ = fresh;
+    }
+    else {
+      shared_->list.clear();
+    }
+  }
+
+private:
+  struct Shared {
+    std::atomic<int> refs;
+    ListType list;
+
+    Shared() : refs(1) {}
+    explicit Shared(const ListType& other) : refs(1), list(other) {}
+  };
+
+  static void release(Shared* shared) {
+    if (shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete shared;
+    }
+  }
+
+  Shared* shared_;
+};
+
+template <typename T, typename Alloc>
+std::ostream& operator<<(std::ostream& os, const CowLinkedList<T, Alloc>& list) {
+  return list.print(os);
+}
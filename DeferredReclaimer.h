@@ -0,0 +1,255 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic
+#include <condition_variable> // for std::condition_variable
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <deque> // for std::deque
+#include <mutex> // for std::mutex, std::unique_lock
+#include <thread> // for std::thread
+
+// Deferred deallocation of whole node chains.
+//
+// Destroying a long LinkedList frees every node on the calling thread. When
+// a DeferredNodeReclaimer is active on a thread (see ScopedDeferredFree
+// below), LinkedList::clear() and therefore ~LinkedList instead detach the
+// node chain in O(1) and submit it here. The chain is then freed either by a
+// background thread, or a bounded number of nodes at a time whenever the
+// owner calls reclaimSome().
+//
+// The item type's destructor will run on whichever thread does the freeing,
+// so it must not depend on running on the thread that built the list.
+class DeferredNodeReclaimer {
+public:
+  enum class Mode {
+    // A dedicated thread frees chains as soon as they are submitted.
+    Background,
+    // Nothing is freed until the owner calls reclaimSome() or drain().
+    Incremental
+  };
+
+  enum class Backpressure {
+    // Wait for the background thread to make room. (Only meaningful in
+    // Background mode; in Incremental mode this behaves like FreeInline.)
+    Block,
+    // Free the submitted chain on the calling thread right away.
+    FreeInline
+  };
+
+  // Destroys one node and returns the next one in the chain.
+  using FreeStep = void* (*)(void* node);
+
+  struct Stats {
+    std::size_t pendingChains;
+    std::size_t pendingNodes;
+    std::size_t pendingBytes;
+    std::uint64_t submittedChains;
+    std::uint64_t reclaimedNodes;
+    std::uint64_t inlineFreedNodes;
+    std::uint64_t blockedSubmits;
+  };
+
+  static constexpr std::size_t DEFAULT_MAX_PENDING_NODES = std::size_t(1) << 24;
+  static constexpr std::size_t DEFAULT_MIN_CHAIN_NODES = 64;
+
+  // maxPendingNodes bounds the queue. Lists shorter than minChainNodes are
+  // cheap enough to free directly and are never deferred.
+  explicit DeferredNodeReclaimer(Mode mode,
+                                 std::size_t maxPendingNodes = DEFAULT_MAX_PENDING_NODES,
+                                 Backpressure backpressure = Backpressure::Block,
+                                 std::size_t minChainNodes = DEFAULT_MIN_CHAIN_NODES)
+    : mode_(mode), backpressure_(backpressure), maxPendingNodes_(maxPendingNodes),
+      minChainNodes_(minChainNodes), stopping_(false),
+      pendingChains_(0), pendingNodes_(0), pendingBytes_(0), submittedChains_(0),
+      reclaimedNodes_(0), inlineFreedNodes_(0), blockedSubmits_(0) {
+    if (mode_ == Mode::Background) {
+      worker_ = std::thread([this] { backgroundLoop(); });
+    }
+  }
+
+  DeferredNodeReclaimer(const DeferredNodeReclaimer&) = delete;
+  DeferredNodeReclaimer& operator=(const DeferredNodeReclaimer&) = delete;
+
+  // Everything still pending is freed before the reclaimer goes away.
+  ~DeferredNodeReclaimer() {
+    if (worker_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+      }
+      workCv_.notify_all();
+      worker_.join();
+    }
+    drain();
+  }
+
+  std::size_t minChainNodes() const { return minChainNodes_; }
+
+  // Take ownership of a detached chain of nodeCount nodes starting at head.
+  void submit(void* head, std::size_t nodeCount, std::size_t bytes, FreeStep step) {
+    if (!head) return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (pendingNodes_ > 0 && pendingNodes_ + nodeCount > maxPendingNodes_) {
+      if (mode_ == Mode::Background && backpressure_ == Backpressure::Block) {
+        blockedSubmits_++;
+        spaceCv_.wait(lock, [&] {
+          return pendingNodes_ == 0 || pendingNodes_ + nodeCount <= maxPendingNodes_;
+        });
+      }
+      else {
+        lock.unlock();
+        freeSome(head, nodeCount, step);
+        inlineFreedNodes_ += nodeCount;
+        return;
+      }
+    }
+
+    queue_.push_back(Chain{head, nodeCount, bytes, step});
+    pendingChains_++;
+    pendingNodes_ += nodeCount;
+    pendingBytes_ += bytes;
+    submittedChains_++;
+    lock.unlock();
+    workCv_.notify_one();
+  }
+
+  // Free at most maxNodes pending nodes on the calling thread, oldest chain
+  // first. Returns the number of nodes freed.
+  std::size_t reclaimSome(std::size_t maxNodes) {
+    std::size_t freed = 0;
+    while (freed < maxNodes) {
+      Chain chain;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) break;
+        chain = queue_.front();
+        queue_.pop_front();
+      }
+
+      std::size_t budget = maxNodes - freed;
+      std::size_t count = chain.nodes < budget ? chain.nodes : budget;
+      chain.head = freeSome(chain.head, count, chain.step);
+      freed += count;
+
+      std::size_t freedBytes = (count == chain.nodes) ? chain.bytes : count * (chain.bytes / chain.nodes);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingNodes_ -= count;
+        pendingBytes_ -= freedBytes;
+        if (count < chain.nodes) {
+          // Put the rest of this chain back for the next call.
+          chain.nodes -= count;
+          chain.bytes -= freedBytes;
+          queue_.push_front(chain);
+        }
+        else {
+          pendingChains_--;
+        }
+      }
+      reclaimedNodes_ += count;
+      spaceCv_.notify_all();
+    }
+    return freed;
+  }
+
+  // Free everything that is pending on the calling thread.
+  void drain() {
+    while (reclaimSome(DRAIN_BATCH_NODES) > 0) {}
+  }
+
+  Stats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s;
+    s.pendingChains = pendingChains_;
+    s.pendingNodes = pendingNodes_;
+    s.pendingBytes = pendingBytes_;
+    s.submittedChains = submittedChains_;
+    s.reclaimedNodes = reclaimedNodes_;
+    s.inlineFreedNodes = inlineFreedNodes_;
+    s.blockedSubmits = blockedSubmits_;
+    return s;
+  }
+
+private:
+  struct Chain {
+    void* head;
+    std::size_t nodes;
+    std::size_t bytes;
+    FreeStep step;
+  };
+
+  // The background thread frees in batches of this many nodes so that the
+  // pending counters, and any blocked submitters, see steady progress.
+  static constexpr std::size_t DRAIN_BATCH_NODES = 4096;
+
+  static void* freeSome(void* node, std::size_t count, FreeStep step) {
+    for (std::size_t i = 0; i < count && node; i++) {
+      node = step(node);
+    }
+    return node;
+  }
+
+  void backgroundLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      workCv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) return;
+      lock.unlock();
+      reclaimSome(DRAIN_BATCH_NODES);
+      lock.lock();
+    }
+  }
+
+  const Mode mode_;
+  const Backpressure backpressure_;
+  const std::size_t maxPendingNodes_;
+  const std::size_t minChainNodes_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable workCv_;
+  std::condition_variable spaceCv_;
+  std::deque<Chain> queue_;
+  bool stopping_;
+  std::thread worker_;
+
+  // Guarded by mutex_.
+  std::size_t pendingChains_;
+  std::size_t pendingNodes_;
+  std::size_t pendingBytes_;
+  std::uint64_t submittedChains_;
+
+  std::atomic<std::uint64_t> reclaimedNodes_;
+  std::atomic<std::uint64_t> inlineFreedNodes_;
+  // Guarded by mutex_.
+  std::uint64_t blockedSubmits_;
+};
+
+// The reclaimer that lists destroyed on this thread should hand their nodes
+// to, or nullptr to free them directly.
+inline DeferredNodeReclaimer*& activeNodeReclaimer() {
+  static thread_local DeferredNodeReclaimer* reclaimer = nullptr;
+  return reclaimer;
+}
+
+// While one of these is in scope, lists cleared or destroyed on this thread
+// defer freeing their nodes to the given reclaimer. This also covers the
+// temporary lists inside merge and the sort algorithms.
+class ScopedDeferredFree {
+public:
+  explicit ScopedDeferredFree(DeferredNodeReclaimer& reclaimer)
+    : previous_(activeNodeReclaimer()) {
+    activeNodeReclaimer() = &reclaimer;
+  }
+
+  ~ScopedDeferredFree() {
+    activeNodeReclaimer() = previous_;
+  }
+
+  ScopedDeferredFree(const ScopedDeferredFree&) = delete;
+  ScopedDeferredFree& operator=(const ScopedDeferredFree&) = delete;
+
+private:
+  DeferredNodeReclaimer* previous_;
+};
@@ -0,0 +1,231 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic, std::atomic_thread_fence
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <mutex> // for std::mutex, std::lock_guard
+#include <new> // for placement new
+#include <stdexcept> // for std::runtime_error
+#include <vector> // for std::vector
+
+// Epoch-based memory reclamation for the lock-free containers.
+//
+// A lock-free container can't free a node as soon as it unlinks it, because
+// other threads may still be reading it. Instead, every access to shared
+// nodes happens inside an EpochGuard, and unlinked nodes are handed to
+// EpochReclamation::retire(). There is a global epoch counter; a thread
+// entering a guard announces the epoch it saw. The epoch can only advance
+// once every thread inside a guard has seen the current value, so a node
+// retired in epoch e can't be reachable by any reader once the global epoch
+// has reached e + 2, and is then freed.
+//
+// Retired nodes are kept in per-thread lists. A thread that exits passes its
+// list to a shared orphan list, which other threads free later.
+class EpochReclamation {
+public:
+  // Frees one retired object.
+  using Deleter = void (*)(void* ptr);
+
+  // The most threads that can be inside a guard at the same time.
+  static constexpr std::size_t MAX_THREADS = 512;
+
+  // Pin the calling thread to the current epoch. Guards can nest.
+  static void enter() {
+    ThreadRecord& rec = threadRecord();
+    if (rec.nesting++ == 0) {
+      Domain& d = domain();
+      std::uint64_t epoch = d.globalEpoch.load(std::memory_order_relaxed);
+      rec.slot->epoch.store(epoch, std::memory_order_relaxed);
+      // The announcement must be visible before any shared node is read.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  static void exit() {
+    ThreadRecord& rec = threadRecord();
+    if (--rec.nesting == 0) {
+      rec.slot->epoch.store(IDLE, std::memory_order_release);
+    }
+  }
+
+  // Schedule ptr to be passed to deleter once no thread can still see it.
+  static void retire(void* ptr, Deleter deleter) {
+    ThreadRecord& rec = threadRecord();
+    Domain& d = domain();
+    rec.retired.push_back(Retired{ptr, deleter, d.globalEpoch.load(std::memory_order_acquire)});
+    // Count retires rather than checking the list length, so that a reader
+    // stuck in a guard (which stops the list from shrinking) doesn't make
+    // every retire rescan the whole list.
+    if (++rec.retiresSinceCollect >= COLLECT_INTERVAL) {
+      collect(rec);
+    }
+  }
+
+  // Try to advance the epoch and free whatever has become safe. Threads
+  // that retire nodes do this automatically every so often; calling it is
+  // only needed to flush before measuring or shutting down.
+  static void collect() {
+    collect(threadRecord());
+  }
+
+  // Objects retired by this thread and not yet freed.
+  static std::size_t pendingOnThisThread() {
+    return threadRecord().retired.size();
+  }
+
+  static std::uint64_t currentEpoch() {
+    return domain().globalEpoch.load(std::memory_order_acquire);
+  }
+
+private:
+  static constexpr std::uint64_t IDLE = 0;
+  static constexpr std::size_t COLLECT_INTERVAL = 128;
+
+  struct Retired {
+    void* ptr;
+    Deleter deleter;
+    std::uint64_t epoch;
+  };
+
+  // One per thread, on its own cache line so announcements don't contend.
+  struct alignas(64) Slot {
+    std::atomic<std::uint64_t> epoch;
+    std::atomic<bool> inUse;
+  };
+
+  struct Domain {
+    std::atomic<std::uint64_t> globalEpoch;
+    // One past the highest slot index ever claimed, to keep scans short.
+    std::atomic<std::size_t> slotsUsed;
+    Slot slots[MAX_THREADS];
+    std::mutex orphanMutex;
+    std::vector<Retired> orphans;
+
+    Domain() : globalEpoch(1), slotsUsed(0) {
+      for (Slot& slot : slots) {
+        slot.epoch.store(IDLE, std::memory_order_relaxed);
+        slot.inUse.store(false, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  // Never destroyed: thread records may outlive static destructors. (The
+  // storage is static rather than from operator new, which doesn't honor
+  // the slots' cache line alignment before C++17.)
+  static Domain& domain() {
+    alignas(Domain) static unsigned char storage[sizeof(Domain)];
+    static Domain* d = new (storage) Domain();
+    return *d;
+  }
+
+  struct ThreadRecord {
+    Slot* slot;
+    int nesting;
+    std::size_t retiresSinceCollect;
+    std::vector<Retired> retired;
+
+    ThreadRecord() : slot(nullptr), nesting(0), retiresSinceCollect(0) {
+      Domain& d = domain();
+      for (std::size_t i = 0; i < MAX_THREADS; i++) {
+        Slot& candidate = d.slots[i];
+        bool expected = false;
+        if (!candidate.inUse.load(std::memory_order_relaxed) &&
+            candidate.inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+          slot = &candidate;
+          std::size_t used = d.slotsUsed.load(std::memory_order_relaxed);
+          while (used < i + 1 && !d.slotsUsed.compare_exchange_weak(used, i + 1, std::memory_order_acq_rel)) {}
+          break;
+        }
+      }
+      if (!slot) throw std::runtime_error("EpochReclamation: too many threads");
+    }
+
+    // Nothing is freed here: the deleters may need other thread-local state
+    // (such as a node cache) that has already been destroyed. Whatever this
+    // thread retired is left to the other threads.
+    ~ThreadRecord() {
+      Domain& d = domain();
+      if (!retired.empty()) {
+        std::lock_guard<std::mutex> lock(d.orphanMutex);
+        d.orphans.insert(d.orphans.end(), retired.begin(), retired.end());
+      }
+      slot->epoch.store(IDLE, std::memory_order_release);
+      slot->inUse.store(false, std::memory_order_release);
+    }
+  };
+
+  static ThreadRecord& threadRecord() {
+    static thread_local ThreadRecord rec;
+    return rec;
+  }
+
+  // Advance the global epoch if every pinned thread has seen it.
+  static std::uint64_t tryAdvance() {
+    Domain& d = domain();
+    std::uint64_t epoch = d.globalEpoch.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::size_t used = d.slotsUsed.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < used; i++) {
+      Slot& slot = d.slots[i];
+      if (!slot.inUse.load(std::memory_order_relaxed)) continue;
+      std::uint64_t seen = slot.epoch.load(std::memory_order_acquire);
+      if (seen != IDLE && seen != epoch) return epoch;
+    }
+    if (d.globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel)) {
+      return epoch + 1;
+    }
+    return epoch;
+  }
+
+  // Free the entries of list that were retired at least two epochs ago.
+  static void freeSafe(std::vector<Retired>& list, std::uint64_t epoch) {
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < list.size(); i++) {
+      if (list[i].epoch + 2 <= epoch) {
+        list[i].deleter(list[i].ptr);
+      }
+      else {
+        list[kept++] = list[i];
+      }
+    }
+    list.resize(kept);
+  }
+
+  // This is safe to call inside a guard: while this thread is pinned to
+  // epoch e the global epoch can't pass e + 1, so nothing it retired during
+  // the guard (or could still see) is old enough to be freed.
+  static void collect(ThreadRecord& rec) {
+    rec.retiresSinceCollect = 0;
+    std::uint64_t epoch = tryAdvance();
+    // A deleter may itself retire something, so work on a detached list.
+    std::vector<Retired> mine;
+    mine.swap(rec.retired);
+    freeSafe(mine, epoch);
+    if (rec.retired.empty()) rec.retired.swap(mine);
+    else rec.retired.insert(rec.retired.end(), mine.begin(), mine.end());
+
+    Domain& d = domain();
+    std::vector<Retired> orphans;
+    {
+      std::lock_guard<std::mutex> lock(d.orphanMutex);
+      orphans.swap(d.orphans);
+    }
+    if (!orphans.empty()) {
+      freeSafe(orphans, epoch);
+      std::lock_guard<std::mutex> lock(d.orphanMutex);
+      d.orphans.insert(d.orphans.end(), orphans.begin(), orphans.end());
+    }
+  }
+};
+
+// Keeps the calling thread pinned to an epoch for its lifetime. Pointers to
+// shared nodes may only be followed while a guard is alive.
+class EpochGuard {
+public:
+  EpochGuard() { EpochReclamation::enter(); }
+  ~EpochGuard() { EpochReclamation::exit(); }
+
+  EpochGuard(const EpochGuard&) = delete;
+  EpochGuard& operator=(const EpochGuard&) = delete;
+};
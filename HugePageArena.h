@@ -0,0 +1,169 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uintptr_t
+#include <cstdlib> // for std::malloc, std::free
+#include <cstdio> // for std::FILE, std::fopen, std::fgets, std::sscanf
+#include <new> // for std::bad_alloc
+#include <vector> // for std::vector
+
+#include <sys/mman.h> // for mmap, munmap, madvise
+
+#include "NodeAllocators.h"
+
+// Huge-page backed node arenas (Linux).
+//
+// Large lists spread their nodes over many 4 KiB pages, and traversals then
+// spend much of their time on dTLB misses. HugePageBlockSource maps arena
+// blocks in whole 2 MiB huge pages: first it tries explicit huge pages
+// (MAP_HUGETLB, which needs pages reserved in /proc/sys/vm/nr_hugepages),
+// then it falls back to an aligned ordinary mapping with
+// madvise(MADV_HUGEPAGE) so that transparent huge pages can back it. If the
+// kernel grants neither, the arena still works on ordinary pages. The small
+// blocks an arena starts out with are not worth a huge page and come from
+// malloc.
+
+static constexpr std::size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+
+// Process-wide counts of what HugePageBlockSource asked for and got.
+struct HugePageStats {
+  // Blocks that were mapped with MAP_HUGETLB, and the huge pages they hold.
+  std::atomic<std::size_t> hugetlbBlocks;
+  std::atomic<std::size_t> hugetlbPages;
+  // Blocks that fell back to madvise(MADV_HUGEPAGE), and their size.
+  std::atomic<std::size_t> transparentBlocks;
+  std::atomic<std::size_t> transparentBytes;
+  // Blocks for which even madvise failed (e.g. THP disabled entirely).
+  std::atomic<std::size_t> plainBlocks;
+};
+
+inline HugePageStats& hugePageStats() {
+  static HugePageStats stats = {};
+  return stats;
+}
+
+class HugePageBlockSource {
+public:
+  static constexpr std::size_t defaultBlockBytes = HUGE_PAGE_BYTES;
+
+  // With tryHugeTlb false, only transparent huge pages are attempted.
+  explicit HugePageBlockSource(bool tryHugeTlb = true) : tryHugeTlb_(tryHugeTlb) {}
+
+  void* allocateBlock(std::size_t& bytes) {
+    if (bytes < HUGE_PAGE_BYTES) {
+      void* block = std::malloc(bytes);
+      if (!block) throw std::bad_alloc();
+      return block;
+    }
+
+    bytes = (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    HugePageStats& stats = hugePageStats();
+
+#ifdef MAP_HUGETLB
+    if (tryHugeTlb_) {
+      void* block = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (block != MAP_FAILED) {
+        stats.hugetlbBlocks++;
+        stats.hugetlbPages += bytes / HUGE_PAGE_BYTES;
+        return block;
+      }
+    }
+#endif
+
+    // Over-map by one huge page so the block can start on a huge page
+    // boundary, then unmap the slack on either side.
+    std::size_t mappedBytes = bytes + HUGE_PAGE_BYTES;
+    void* mapped = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) throw std::bad_alloc();
+
+    std::uintptr_t start = reinterpret_cast<std::uintptr_t>(mapped);
+    std::uintptr_t aligned = (start + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    if (aligned > start) {
+      munmap(mapped, aligned - start);
+    }
+    std::size_t tail = (start + mappedBytes) - (aligned + bytes);
+    if (tail > 0) {
+      munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+    }
+
+    void* block = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+    if (madvise(block, bytes, MADV_HUGEPAGE) == 0) {
+      stats.transparentBlocks++;
+      stats.transparentBytes += bytes;
+      return block;
+    }
+#endif
+    stats.plainBlocks++;
+    return block;
+  }
+
+  void freeBlock(void* block, std::size_t bytes) {
+    if (bytes < HUGE_PAGE_BYTES) {
+      std::free(block);
+    }
+    else {
+      munmap(block, bytes);
+    }
+  }
+
+private:
+  bool tryHugeTlb_;
+};
+
+using HugePageArenaNodeAllocator = BasicArenaNodeAllocator<HugePageBlockSource>;
+
+// Reports how many bytes are actually backed by huge pages right now,
+// explicit or transparent, in the mappings that hold an arena's blocks,
+// according to /proc/self/smaps. (The kernel may merge a block's mapping
+// with an adjacent one, in which case the neighbor is counted too.)
+// Returns 0 if smaps can't be read.
+template <typename Arena>
+std::size_t hugePageBytesInUse(const Arena& arena) {
+  struct Mapping {
+    std::uintptr_t start;
+    std::uintptr_t end;
+    std::size_t hugeKiB;
+    bool counted;
+  };
+  std::vector<Mapping> mappings;
+
+  std::FILE* smaps = std::fopen("/proc/self/smaps", "r");
+  if (!smaps) return 0;
+  char line[512];
+  while (std::fgets(line, sizeof(line), smaps)) {
+    unsigned long start = 0;
+    unsigned long end = 0;
+    std::size_t kib = 0;
+    if (std::sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+      mappings.push_back(Mapping{start, end, 0, false});
+    }
+    else if (!mappings.empty() &&
+             (std::sscanf(line, "AnonHugePages: %zu kB", &kib) == 1 ||
+              std::sscanf(line, "Private_Hugetlb: %zu kB", &kib) == 1 ||
+              std::sscanf(line, "Shared_Hugetlb: %zu kB", &kib) == 1)) {
+      mappings.back().hugeKiB += kib;
+    }
+  }
+  std::fclose(smaps);
+
+  // Several blocks may share one mapping, so count each mapping once.
+  std::size_t total = 0;
+  arena.forEachBlock([&](const void* block, std::size_t bytes) {
+    std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(block);
+    for (Mapping& m : mappings) {
+      if (addr >= m.start && addr < m.end) {
+        if (!m.counted) {
+          total += m.hugeKiB * 1024;
+          m.counted = true;
+        }
+        break;
+      }
+    }
+  });
+  return total;
+}
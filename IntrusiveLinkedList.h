@@ -0,0 +1,345 @@
+
+#pragma once
+
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::string
+
+// An intrusive doubly-linked list: instead of copying each item into a
+// separately allocated Node, the items carry their own links in a hook
+// member, and the list only ever rewires those links. Nothing is allocated,
+// copied or destroyed by the list, so the caller keeps ownership of the
+// items and must keep them alive while they are linked.
+//
+// Usage:
+//
+//   struct Record {
+//     int key;
+//     IntrusiveListHook<Record> hook;
+//     bool operator<(const Record& other) const { return key < other.key; }
+//   };
+//
+//   IntrusiveLinkedList<Record, &Record::hook> list;
+//   Record a, b;
+//   list.pushBack(a);
+//   list.insertOrdered(b);
+//
+// An item can be in as many lists at once as it has hooks.
+
+template <typename T>
+class IntrusiveListHook {
+public:
+  // The next item in the list, or nullptr if this is the last item.
+  T* next;
+  // The previous item in the list, or nullptr if this is the first item.
+  T* prev;
+
+  IntrusiveListHook() : next(nullptr), prev(nullptr) {}
+
+  // Copying an item doesn't copy its place in a list.
+  IntrusiveListHook(const IntrusiveListHook&) : next(nullptr), prev(nullptr) {}
+  IntrusiveListHook& operator=(const IntrusiveListHook&) { return *this; }
+};
+
+template <typename T, IntrusiveListHook<T> T::*Hook>
+class IntrusiveLinkedList {
+private:
+  T* head_;
+  // The last item in the list, or nullptr if the list is empty.
+  T* tail_;
+
+  int size_;
+
+  static IntrusiveListHook<T>& hook(T* item) { return item->*Hook; }
+  static const IntrusiveListHook<T>& hook(const T* item) { return item->*Hook; }
+
+  // Returns the item at front and advances front along the next links.
+  // Used by merge and mergeSort.
+  static T* takeFront(T*& front) {
+    T* item = front;
+    front = hook(item).next;
+    return item;
+  }
+
+public:
+
+  static constexpr char LIST_GENERAL_BUG_MESSAGE[] = "[Error] Probable causes: wrong head_ or tail_ pointer, or some next or prev pointer not updated, or wrong size_";
+
+  IntrusiveLinkedList() : head_(nullptr), tail_(nullptr), size_(0) {}
+
+  // A list doesn't own its items, and an item can only be in one list per
+  // hook, so lists can't be copied.
+  IntrusiveLinkedList(const IntrusiveLinkedList&) = delete;
+  IntrusiveLinkedList& operator=(const IntrusiveLinkedList&) = delete;
+
+  // The items are simply unlinked; they are not destroyed.
+  ~IntrusiveLinkedList() {
+    clear();
+  }
+
+  T* getHeadPtr() { return head_; }
+  T* getTailPtr() { return tail_; }
+  const T* getHeadPtr() const { return head_; }
+  const T* getTailPtr() const { return tail_; }
+
+  // The item after the given one, or nullptr at the end of the list.
+  static T* next(T* item) { return hook(item).next; }
+  static const T* next(const T* item) { return hook(item).next; }
+
+  int size() const { return size_; }
+
+  bool empty() const { return !head_; }
+
+  T& front() {
+    if (!head_) throw std::runtime_error("front() called on empty IntrusiveLinkedList");
+    return *head_;
+  }
+
+  T& back() {
+    if (!tail_) throw std::runtime_error("back() called on empty IntrusiveLinkedList");
+    return *tail_;
+  }
+
+  // Link the item in at the front of the list.
+  void pushFront(T& item) {
+    T* newItem = &item;
+    hook(newItem).prev = nullptr;
+    hook(newItem).next = head_;
+    if (head_) {
+      hook(head_).prev = newItem;
+    }
+    else {
+      tail_ = newItem;
+    }
+    head_ = newItem;
+    size_++;
+  }
+
+  // Link the item in at the back of the list.
+  void pushBack(T& item) {
+    T* newItem = &item;
+    hook(newItem).next = nullptr;
+    hook(newItem).prev = tail_;
+    if (tail_) {
+      hook(tail_).next = newItem;
+    }
+    else {
+      head_ = newItem;
+    }
+    tail_ = newItem;
+    size_++;
+  }
+
+  // Unlink the front item and return it, or return nullptr if empty.
+  T* popFront() {
+    if (!head_) return nullptr;
+    T* oldHead = head_;
+    head_ = hook(oldHead).next;
+    if (head_) {
+      hook(head_).prev = nullptr;
+    }
+    else {
+      tail_ = nullptr;
+    }
+    hook(oldHead).next = nullptr;
+    size_--;
+    return oldHead;
+  }
+
+  // Unlink the back item and return it, or return nullptr if empty.
+  T* popBack() {
+    if (!tail_) return nullptr;
+    T* oldTail = tail_;
+    tail_ = hook(oldTail).prev;
+    if (tail_) {
+      hook(tail_).next = nullptr;
+    }
+    else {
+      head_ = nullptr;
+    }
+    hook(oldTail).prev = nullptr;
+    size_--;
+    return oldTail;
+  }
+
+  // Unlink the given item, which must currently be in this list.
+  void erase(T& item) {
+    T* cur = &item;
+    T* prev = hook(cur).prev;
+    T* next = hook(cur).next;
+    if (prev) hook(prev).next = next;
+    else head_ = next;
+    if (next) hook(next).prev = prev;
+    else tail_ = prev;
+    hook(cur).next = nullptr;
+    hook(cur).prev = nullptr;
+    size_--;
+  }
+
+  // Unlink every item, leaving the list empty.
+  void clear() {
+    T* cur = head_;
+    while (cur) {
+      T* next = hook(cur).next;
+      hook(cur).next = nullptr;
+      hook(cur).prev = nullptr;
+      cur = next;
+    }
+    head_ = nullptr;
+    tail_ = nullptr;
+    size_ = 0;
+  }
+
+  // Assuming the list is sorted, link the item in front of the earliest item
+  // that is greater than it, or at the back if there is none. This is the
+  // same placement as LinkedList::insertOrdered.
+  void insertOrdered(T& item) {
+    T* cur = head_;
+    while (cur && !(item < *cur)) {
+      cur = hook(cur).next;
+    }
+    if (!cur) {
+      pushBack(item);
+      return;
+    }
+    T* newItem = &item;
+    T* prev = hook(cur).prev;
+    hook(newItem).next = cur;
+    hook(newItem).prev = prev;
+    hook(cur).prev = newItem;
+    if (prev) hook(prev).next = newItem;
+    else head_ = newItem;
+    size_++;
+  }
+
+  // Assuming this list and the other list are both sorted, move all of the
+  // other list's items into this one in sorted order, in linear time.
+  // The other list is left empty. When items compare equal, the ones that
+  // were already in this list come first.
+  void merge(IntrusiveLinkedList& other) {
+    if (&other == this || !other.head_) return;
+    int totalSize = size_ + other.size_;
+    T* left = head_;
+    T* right = other.head_;
+    other.head_ = nullptr;
+    other.tail_ = nullptr;
+    other.size_ = 0;
+
+    T* mergedHead = nullptr;
+    T* mergedTail = nullptr;
+    while (left || right) {
+      T* item;
+      if (!right || (left && !(*right < *left))) item = takeFront(left);
+      else item = takeFront(right);
+      hook(item).prev = mergedTail;
+      if (mergedTail) hook(mergedTail).next = item;
+      else mergedHead = item;
+      mergedTail = item;
+    }
+    hook(mergedTail).next = nullptr;
+
+    head_ = mergedHead;
+    tail_ = mergedTail;
+    size_ = totalSize;
+  }
+
+  // Checks whether the list is currently sorted in increasing order.
+  bool isSorted() const {
+    if (size_ < 2) return true;
+    const T* cur = head_;
+    while (hook(cur).next) {
+      const T* next = hook(cur).next;
+      if (*next < *cur) return false;
+      cur = next;
+    }
+    return true;
+  }
+
+  // Sort the list in place with a stable merge sort, in O(n log n) time and
+  // O(1) extra space. Only links are rewritten; no item is moved or copied.
+  //
+  // This is the bottom-up version: it merges runs of width 1, 2, 4, ... along
+  // the next links only, then restores the prev links in one final pass.
+  void mergeSort() {
+    if (size_ < 2) return;
+
+    T* list = head_;
+    for (int width = 1; ; width *= 2) {
+      T* sortedHead = nullptr;
+      T* sortedTail = nullptr;
+      int merges = 0;
+      T* rest = list;
+
+      while (rest) {
+        merges++;
+        // Cut off a left run and a right run of up to width items each.
+        T* left = rest;
+        int leftSize = 0;
+        while (rest && leftSize < width) {
+          rest = hook(rest).next;
+          leftSize++;
+        }
+        T* right = rest;
+        int rightSize = 0;
+        while (rest && rightSize < width) {
+          rest = hook(rest).next;
+          rightSize++;
+        }
+
+        // Merge them onto the end of the sorted output.
+        while (leftSize > 0 || rightSize > 0) {
+          T* item;
+          if (rightSize == 0 || (leftSize > 0 && !(*right < *left))) {
+            item = takeFront(left);
+            leftSize--;
+          }
+          else {
+            item = takeFront(right);
+            rightSize--;
+          }
+          if (sortedTail) hook(sortedTail).next = item;
+          else sortedHead = item;
+          sortedTail = item;
+        }
+      }
+      hook(sortedTail).next = nullptr;
+      list = sortedHead;
+
+      // A single merge on this pass means the whole list is one run.
+      if (merges <= 1) break;
+    }
+
+    head_ = list;
+    T* prev = nullptr;
+    for (T* cur = head_; cur; cur = hook(cur).next) {
+      hook(cur).prev = prev;
+      prev = cur;
+    }
+    tail_ = prev;
+  }
+
+  // Checks whether the size has been correctly updated by member functions,
+  // and otherwise throws an exception. This is for testing only.
+  bool assertCorrectSize() const {
+    int itemCount = 0;
+    for (const T* cur = head_; cur; cur = hook(cur).next) {
+      itemCount++;
+    }
+    if (itemCount != size_) throw std::runtime_error(std::string("Error in assertCorrectSize: ") + LIST_GENERAL_BUG_MESSAGE);
+    return true;
+  }
+
+  // Checks whether the prev links mirror the next links, and otherwise
+  // throws an exception. This is for testing only.
+  bool assertPrevLinks() const {
+    const T* prev = nullptr;
+    for (const T* cur = head_; cur; cur = hook(cur).next) {
+      if (hook(cur).prev != prev) throw std::runtime_error(std::string("Error in assertPrevLinks: ") + LIST_GENERAL_BUG_MESSAGE);
+      prev = cur;
+    }
+    if (tail_ != prev) throw std::runtime_error(std::string("Error in assertPrevLinks: ") + LIST_GENERAL_BUG_MESSAGE);
+    return true;
+  }
+};
+
+template <typename T, IntrusiveListHook<T> T::*Hook>
+constexpr char IntrusiveLinkedList<T, Hook>::LIST_GENERAL_BUG_MESSAGE[];
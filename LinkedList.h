@@ -4,8 +4,26 @@
 #include <stdexcept> // for std::runtime_error
 #include <iostream> // for std::cerr, std::cout
 #include <ostream> // for std::ostream
-
-template <typename T>
+#include <cstddef> // for std::size_t
+#include <new> // for placement new
+#include <type_traits> // for std::is_trivially_destructible, std::is_empty, std::integral_constant
+
+#include "NodeAllocators.h"
+#include "ListTextFormat.h"
+#include "DeferredReclaimer.h"
+#include "ListAllocStats.h"
+#include "ListTrace.h"
+#include "ListOpRecorder.h"
+
+// LINKEDLIST_ALLOC_STATS, LINKEDLIST_TRACE and LINKEDLIST_RECORD compile
+// instrumentation into the member functions below. Build every object of a
+// program with the same set of them: a program that mixes objects built
+// with and without one has two definitions of the same functions, and the
+// linker silently keeps either.
+
+// The Alloc policy decides where the nodes live. By default each node is
+// its own heap allocation; see NodeAllocators.h for the alternatives.
+template <typename T, typename Alloc = HeapNodeAllocator>
 class LinkedList {
 public:
 
@@ -25,16 +43,21 @@ public:
 
     // Argument constructor: Specifies the data that should be copied into
     // the T data member variable.
-    Node(const T& dataArg) : next(nullptr), prev(nullptr), data(dataArg) {}
+    Node(const T& dataArg) : next(nullptr), prev(nullptr), data(dataArg) {
+      list_alloc_stats::itemCopied();
+    }
 
     Node(const Node& other) : next(other.next), prev(other.prev),
-      data(other.data) {}
+      data(other.data) {
+      list_alloc_stats::itemCopied();
+    }
 
     // Copy assignment operator: Please see the note above.
     Node& operator=(const Node& other) {
       next = other.next;
       prev = other.prev;
       data = other.data;
+      list_alloc_stats::itemAssigned();
       return *this;
     }
 
@@ -50,12 +73,66 @@ private:
 
   int size_;
 
+  // The policy object that provides storage for this list's nodes.
+  Alloc alloc_;
+
+  // Snapshots the items of lists it records.
+  friend class ListOpRecorder;
+
+  // Allocate storage from the policy and copy-construct a node in it.
+  Node* createNode(const T& newData) {
+    void* storage = alloc_.template allocate<Node>();
+    try {
+      Node* node = new (storage) Node(newData);
+      list_alloc_stats::nodesAllocated(1, sizeof(Node));
+      return node;
+    }
+    catch (...) {
+      alloc_.template deallocate<Node>(static_cast<Node*>(storage));
+      throw;
+    }
+  }
+
+  // Destroy a node and hand its storage back to the policy.
+  void destroyNode(Node* node) {
+    list_alloc_stats::nodesFreed(1, sizeof(Node));
+    node->~Node();
+    alloc_.template deallocate<Node>(node);
+  }
+
+  // Used by DeferredNodeReclaimer to free a detached chain one node at a
+  // time after this list is gone. That is only possible when any instance
+  // of the allocator policy can free any node, i.e. it has no state.
+  static constexpr bool canDeferFree = !Alloc::releasesInBulk && std::is_empty<Alloc>::value;
+
+  // Calls alloc.reserve<Node>(count) if the policy has it.
+  template <typename A>
+  static auto reserveNodes(A& alloc, std::size_t count, int) -> decltype(alloc.template reserve<Node>(count), void()) {
+    alloc.template reserve<Node>(count);
+  }
+  template <typename A>
+  static void reserveNodes(A&, std::size_t, long) {}
+
+  // print() for item types that ListTextBuffer can format, and for the rest.
+  std::ostream& printItems(std::ostream& os, std::true_type) const;
+  std::ostream& printItems(std::ostream& os, std::false_type) const;
+
+  static void* destroyDetachedNode(void* node) {
+    Node* cur = static_cast<Node*>(node);
+    Node* next = cur->next;
+    cur->~Node();
+    Alloc().template deallocate<Node>(cur);
+    return next;
+  }
+
 public:
 
   static constexpr char LIST_GENERAL_BUG_MESSAGE[] = "[Error] Probable causes: wrong head_ or tail_ pointer, or some next or prev pointer not updated, or wrong size_";
 
   Node* getHeadPtr() { return head_; }
   Node* getTailPtr() { return tail_; }
+  const Node* getHeadPtr() const { return head_; }
+  const Node* getTailPtr() const { return tail_; }
 
   int size() const { return size_; }
 
@@ -107,30 +184,76 @@ public:
   void popFront();
   // Delete the back item of the list.
   void popBack();
+  // Push copies of count items, in order, onto the back of the list. The
+  // allocator is told up front how many nodes are coming (see reserve in
+  // NodeAllocators.h), and the links are set in the same pass that
+  // constructs the nodes.
+  void appendBulk(const T* items, int count);
   
   // Delete all items in the list, leaving it empty.
+  // This makes one forward pass over the nodes without relinking anything.
+  // If the allocator can release all of its storage at once and T has a
+  // trivial destructor, there is nothing to visit and no pass is made.
+  // If a DeferredNodeReclaimer is active on this thread (see
+  // ScopedDeferredFree), a long enough chain is detached in O(1) and handed
+  // to the reclaimer instead.
   void clear() {
-    // As long as there are items left in the list, remove the tail item.
-    while (head_) {
-      popBack();
+    LIST_RECORD_OP(ListOpCode::Clear, *this);
+    LIST_TRACE_SCOPE("clear", size_);
+    DeferredNodeReclaimer* reclaimer = activeNodeReclaimer();
+    if (canDeferFree && reclaimer && static_cast<std::size_t>(size_) >= reclaimer->minChainNodes()) {
+      // As far as the accounting goes, the nodes are freed here.
+      list_alloc_stats::nodesFreed(size_, size_ * sizeof(Node));
+      reclaimer->submit(head_, size_, size_ * sizeof(Node), &destroyDetachedNode);
+      head_ = nullptr;
+      tail_ = nullptr;
+      size_ = 0;
+      return;
+    }
+
+    constexpr bool skipWalk = Alloc::releasesInBulk && std::is_trivially_destructible<T>::value;
+    if (Alloc::releasesInBulk) {
+      list_alloc_stats::nodesFreed(size_, size_ * sizeof(Node));
+    }
+    if (!skipWalk) {
+      Node* cur = head_;
+      while (cur) {
+        Node* next = cur->next;
+        if (Alloc::releasesInBulk) {
+          // The storage goes away with release() below.
+          cur->~Node();
+        }
+        else {
+          destroyNode(cur);
+        }
+        cur = next;
+      }
     }
+    alloc_.release();
 
-    if (0 != size_) throw std::runtime_error(std::string("Error in clear: ") + LIST_GENERAL_BUG_MESSAGE);
+    head_ = nullptr;
+    tail_ = nullptr;
+    size_ = 0;
   }
 
+  // The allocator policy instance used by this list.
+  const Alloc& allocator() const { return alloc_; }
+
   // Two lists are equal if they have the same length
   // and the same data items in each position.
   // This check runs in O(n) time.
-  bool equals(const LinkedList<T>& other) const;
-  bool operator==(const LinkedList<T>& other) const {
+  bool equals(const LinkedList<T, Alloc>& other) const;
+  bool operator==(const LinkedList<T, Alloc>& other) const {
     return equals(other);
   }
-  bool operator!=(const LinkedList<T>& other) const {
+  bool operator!=(const LinkedList<T, Alloc>& other) const {
     return !equals(other);
   }
 
   // Output a string representation of the list.
   // This requires that the data type T supports stream output itself.
+  // Numbers are formatted through a ListTextBuffer when the stream has
+  // default flags, which gives the same text much faster.
   // This is used by the operator<< overload defined in this file.
   std::ostream& print(std::ostream& os) const;
 
@@ -140,37 +263,42 @@ public:
   // This is true if for all adjacent pairs of items A and B in the list: A <= B.
   bool isSorted() const;
 
-  LinkedList<T> insertionSort() const;
+  LinkedList<T, Alloc> insertionSort() const;
 
-  LinkedList<LinkedList<T>> splitHalves() const;
+  LinkedList<LinkedList<T, Alloc>> splitHalves() const;
 
-  LinkedList<LinkedList<T>> explode() const;
+  LinkedList<LinkedList<T, Alloc>> explode() const;
   
   // Assuming this list instance is currently sorted, and the "other" list is
   // also already sorted, then merge returns a new sorted list containing all
   // of the items from both of the original lists, in linear time.
   // (This definition is in a separate file for the homework exercises.)
-  LinkedList<T> merge(const LinkedList<T>& other) const;
+  LinkedList<T, Alloc> merge(const LinkedList<T, Alloc>& other) const;
   
   // This is a wrapper function that calls one of either mergeSortRecursive
   // or mergeSortIterative.
-  LinkedList<T> mergeSort() const;
+  LinkedList<T, Alloc> mergeSort() const;
   
   // The recursive version of the merge sort algorithm, which returns a new
   // list containing the sorted elements of the current list, in O(n log n) time.
-  LinkedList<T> mergeSortRecursive() const;
+  LinkedList<T, Alloc> mergeSortRecursive() const;
 
   // The iterative version of the merge sort algorithm, which returns a new
   // list containing the sorted elements of the current list, in O(n log n) time.
-  LinkedList<T> mergeSortIterative() const;
+  LinkedList<T, Alloc> mergeSortIterative() const;
 
   // Default constructor: The list will be empty.
   LinkedList() : head_(nullptr), tail_(nullptr), size_(0) {}
+
+  // Construct an empty list whose allocator is a copy of the given one.
+  // (Copying an allocator copies its configuration, not its storage.)
+  explicit LinkedList(const Alloc& alloc) : head_(nullptr), tail_(nullptr), size_(0), alloc_(alloc) {}
   
   // The copy assignment operator replicates the content of the other list
   // one element at a time so that pointers between nodes will be correct
   // for this copy of the list.
-  LinkedList<T>& operator=(const LinkedList<T>& other) {
+  LinkedList<T, Alloc>& operator=(const LinkedList<T, Alloc>& other) {
+    LIST_RECORD_OP(ListOpCode::Copy, *this, other);
     // Clear the current list.
     clear();
 
@@ -188,15 +316,16 @@ public:
     return *this;
   }
   
-  // The copy constructor begins by constructing the default LinkedList,
-  // then it does copy assignment from the other list. Please see the
-  // definition of the copy assignment operator.
-  LinkedList(const LinkedList<T>& other) : LinkedList() {
+  // The copy constructor begins by constructing an empty LinkedList with
+  // the same kind of allocator, then it does copy assignment from the other
+  // list. Please see the definition of the copy assignment operator.
+  LinkedList(const LinkedList<T, Alloc>& other) : LinkedList(other.alloc_) {
     *this = other;
   }
 
   // The destructor calls clear to deallocate all of the nodes.
   ~LinkedList() {
+    LIST_RECORD_OP(ListOpCode::Destroy, *this);
     clear();
   }
 
@@ -211,22 +340,23 @@ public:
 
 };
 
-template <typename T>
-std::ostream& operator<<(std::ostream& os, const LinkedList<T>& list) {
+template <typename T, typename Alloc>
+std::ostream& operator<<(std::ostream& os, const LinkedList<T, Alloc>& list) {
   return list.print(os);
 }
 
 // In some versions of C++ we have to redeclare a constant static member
 // at global scope like this to ensure that the linker doesn't give an error.
-template <typename T>
-constexpr char LinkedList<T>::LIST_GENERAL_BUG_MESSAGE[];
+template <typename T, typename Alloc>
+constexpr char LinkedList<T, Alloc>::LIST_GENERAL_BUG_MESSAGE[];
 
 // Push a copy of the new data item onto the front of the list.
-template <typename T>
-void LinkedList<T>::pushFront(const T& newData) {
+template <typename T, typename Alloc>
+void LinkedList<T, Alloc>::pushFront(const T& newData) {
+  LIST_RECORD_OP(ListOpCode::PushFront, *this, &newData);
 
   // allocate a new node
-  Node* newNode = new Node(newData);
+  Node* newNode = createNode(newData);
 
   if (!head_) {
     // If empty, insert as the only item as both head and tail.
@@ -249,11 +379,12 @@ void LinkedList<T>::pushFront(const T& newData) {
 }
 
 // Push a copy of the new data item onto the back of the list.
-template <typename T>
-void LinkedList<T>::pushBack(const T& newData) {
+template <typename T, typename Alloc>
+void LinkedList<T, Alloc>::pushBack(const T& newData) {
+  LIST_RECORD_OP(ListOpCode::PushBack, *this, &newData);
 
   // allocate a new node
-  Node* newNode = new Node(newData);
+  Node* newNode = createNode(newData);
 
   if (!head_) {
     // If empty, insert as the only item as both head and tail.
@@ -275,9 +406,29 @@ void LinkedList<T>::pushBack(const T& newData) {
   size_++;
 }
 
+template <typename T, typename Alloc>
+void LinkedList<T, Alloc>::appendBulk(const T* items, int count) {
+  LIST_RECORD_OP(ListOpCode::AppendBulk, *this, items, count);
+  if (count <= 0) return;
+  reserveNodes(alloc_, static_cast<std::size_t>(count), 0);
+
+  Node* last = tail_;
+  for (int i = 0; i < count; i++) {
+    Node* newNode = createNode(items[i]);
+    newNode->prev = last;
+    if (last) last->next = newNode;
+    else head_ = newNode;
+    last = newNode;
+    // Kept up to date so that the list stays valid if a copy throws.
+    tail_ = newNode;
+    size_++;
+  }
+}
+
 // Delete the front item of the list.
-template <typename T>
-void LinkedList<T>::popFront() {
+template <typename T, typename Alloc>
+void LinkedList<T, Alloc>::popFront() {
+  LIST_RECORD_OP(ListOpCode::PopFront, *this);
 
   // If list is empty, do nothing.
   if (!head_) return;
@@ -286,7 +437,7 @@ void LinkedList<T>::popFront() {
   // item in the list.
   if (!head_->next) {
     // deallocate the only item
-    delete head_;
+    destroyNode(head_);
     // reset list pointers
     head_ = nullptr;
     tail_ = nullptr;
@@ -306,7 +457,7 @@ void LinkedList<T>::popFront() {
   // Now set the new head_'s previous pointer to null.
   head_->prev = nullptr;
   // Deallocate the old head_ item
-  delete oldHead;
+  destroyNode(oldHead);
   // It's a good practice to set pointers to null after you delete them for safety,
   // even if you don't think you're going to dereference the same pointer again.
   oldHead = nullptr;
@@ -316,8 +467,9 @@ void LinkedList<T>::popFront() {
 }
 
 // Delete the back item of the list.
-template <typename T>
-void LinkedList<T>::popBack() {
+template <typename T, typename Alloc>
+void LinkedList<T, Alloc>::popBack() {
+  LIST_RECORD_OP(ListOpCode::PopBack, *this);
 
   // If list is empty, do nothing.
   if (!head_) return;
@@ -326,7 +478,7 @@ void LinkedList<T>::popBack() {
   // item in the list.
   if (!tail_->prev) {
     // deallocate the only item
-    delete tail_;
+    destroyNode(tail_);
     // reset list pointers
     head_ = nullptr;
     tail_ = nullptr;
@@ -346,7 +498,7 @@ void LinkedList<T>::popBack() {
   // Now set the new tail_'s next pointer to null.
   tail_->next = nullptr;
   // Deallocate the old tail_ item
-  delete oldTail;
+  destroyNode(oldTail);
   // It's a good practice to set pointers to null after you delete them for safety,
   // even if you don't think you're going to dereference the same pointer again.
   oldTail = nullptr;
@@ -357,8 +509,8 @@ void LinkedList<T>::popBack() {
 
 // Checks whether the list is currently sorted in increasing order.
 // This is true if for all adjacent pairs of items A and B in the list: A <= B.
-template <typename T>
-bool LinkedList<T>::isSorted() const {
+template <typename T, typename Alloc>
+bool LinkedList<T, Alloc>::isSorted() const {
   // Lists of size 0 or 1 are sorted.
   if (size_ < 2) return true;
 
@@ -388,8 +540,8 @@ bool LinkedList<T>::isSorted() const {
 // Two lists are equal if they have the same length
 // and the same data items in each position.
 // This check runs in O(n) time.
-template <typename T>
-bool LinkedList<T>::equals(const LinkedList<T>& other) const {
+template <typename T, typename Alloc>
+bool LinkedList<T, Alloc>::equals(const LinkedList<T, Alloc>& other) const {
 
   // If the lists are different sizes, they don't have the same contents.
   if (size_ != other.size_) {
@@ -414,10 +566,12 @@ bool LinkedList<T>::equals(const LinkedList<T>& other) const {
   return true;
 }
 
-template <typename T>
-LinkedList<T> LinkedList<T>::insertionSort() const {
+template <typename T, typename Alloc>
+LinkedList<T, Alloc> LinkedList<T, Alloc>::insertionSort() const {
+  LIST_RECORD_OP(ListOpCode::InsertionSort, *this);
+  LIST_TRACE_SCOPE("insertionSort", size_);
   // Make result list
-  LinkedList<T> result;
+  LinkedList<T, Alloc> result(alloc_);
 
   // Walk along the original list and insert the items to the result in order.
   const Node* cur = head_;
@@ -430,8 +584,35 @@ LinkedList<T> LinkedList<T>::insertionSort() const {
 }
 
 
-template <typename T>
-std::ostream& LinkedList<T>::print(std::ostream& os) const {
+template <typename T, typename Alloc>
+std::ostream& LinkedList<T, Alloc>::print(std::ostream& os) const {
+  return printItems(os, std::integral_constant<bool, isFastListText<T>::value>());
+}
+
+template <typename T, typename Alloc>
+std::ostream& LinkedList<T, Alloc>::printItems(std::ostream& os, std::true_type) const {
+  // A stream with custom formatting gets every item through operator<<.
+  if (!ListTextBuffer::matchesStream(os)) return printItems(os, std::false_type());
+
+  // Otherwise the text is built in a buffer and written in large pieces,
+  // under one sentry, which skips a failed stream and flushes a tied one
+  // as operator<< would.
+  std::ostream::sentry sentry(os);
+  if (!sentry) return os;
+  ListTextBuffer& buffer = ListTextBuffer::forThread();
+  int precision = static_cast<int>(os.precision());
+  buffer.append('[');
+  for (Node* cur = head_; cur; cur = cur->next) {
+    if (buffer.full() && !buffer.flushTo(os)) return os;
+    buffer.appendItem(cur->data, precision);
+  }
+  buffer.append(']');
+  buffer.flushTo(os);
+  return os;
+}
+
+template <typename T, typename Alloc>
+std::ostream& LinkedList<T, Alloc>::printItems(std::ostream& os, std::false_type) const {
   // List format will be [(1)(2)(3)], etc.
   os << "[";
 
@@ -447,15 +628,16 @@ std::ostream& LinkedList<T>::print(std::ostream& os) const {
   return os;
 }
 
-template <typename T>
-LinkedList<LinkedList<T>> LinkedList<T>::splitHalves() const {
+template <typename T, typename Alloc>
+LinkedList<LinkedList<T, Alloc>> LinkedList<T, Alloc>::splitHalves() const {
+  LIST_TRACE_SCOPE("splitHalves", size_);
 
   // Prepare a list of lists for the result:
-  LinkedList<LinkedList<T>> halves;
+  LinkedList<LinkedList<T, Alloc>> halves;
   // Prepare a working copy of "*this" object to be split:
-  LinkedList<T> leftHalf = *this;
+  LinkedList<T, Alloc> leftHalf = *this;
   // Prepare an empty right half to fill:
-  LinkedList<T> rightHalf;
+  LinkedList<T, Alloc> rightHalf(alloc_);
 
   if (size_ < 2) {
     halves.pushBack(leftHalf);
@@ -480,15 +662,16 @@ LinkedList<LinkedList<T>> LinkedList<T>::splitHalves() const {
 }
 
 
-template <typename T>
-LinkedList<LinkedList<T>> LinkedList<T>::explode() const {
+template <typename T, typename Alloc>
+LinkedList<LinkedList<T, Alloc>> LinkedList<T, Alloc>::explode() const {
+  LIST_TRACE_SCOPE("explode", size_);
 
-  LinkedList<T> workingCopy = *this;
+  LinkedList<T, Alloc> workingCopy = *this;
 
-  LinkedList< LinkedList<T> > lists;
+  LinkedList< LinkedList<T, Alloc> > lists;
 
   while (!workingCopy.empty()) {
-    LinkedList<T> singletonList;
+    LinkedList<T, Alloc> singletonList(alloc_);
     singletonList.pushBack(workingCopy.front());
     workingCopy.popFront();
     lists.pushBack(singletonList);
@@ -499,8 +682,11 @@ LinkedList<LinkedList<T>> LinkedList<T>::explode() const {
 
 // The recursive version of the merge sort algorithm, which returns a new
 // list containing the sorted elements of the current list, in O(n log n) time.
-template <typename T>
-LinkedList<T> LinkedList<T>::mergeSortRecursive() const {
+template <typename T, typename Alloc>
+LinkedList<T, Alloc> LinkedList<T, Alloc>::mergeSortRecursive() const {
+  LIST_RECORD_OP(ListOpCode::SortRecursive, *this);
+  // The scope also covers the teardown of the halves on the way out.
+  LIST_TRACE_SCOPE("mergeSortRecursive", size_);
 
   if (size_ < 2) {
     // Return a copy of the current list.
@@ -508,10 +694,10 @@ LinkedList<T> LinkedList<T>::mergeSortRecursive() const {
   }
 
   // Split this list into a list of two lists (the left and right halves)
-  LinkedList<LinkedList<T>> halves = splitHalves();
+  LinkedList<LinkedList<T, Alloc>> halves = splitHalves();
 
-  LinkedList<T>& left = halves.front();
-  LinkedList<T>& right = halves.back();
+  LinkedList<T, Alloc>& left = halves.front();
+  LinkedList<T, Alloc>& right = halves.back();
 
   // Relying on the inductive hypothesis that our algorithm successfully
   // sorts a smaller list than the original input, we recurse on each of
@@ -526,8 +712,10 @@ LinkedList<T> LinkedList<T>::mergeSortRecursive() const {
 }
 
 
-template <typename T>
-LinkedList<T> LinkedList<T>::mergeSortIterative() const {
+template <typename T, typename Alloc>
+LinkedList<T, Alloc> LinkedList<T, Alloc>::mergeSortIterative() const {
+  LIST_RECORD_OP(ListOpCode::SortIterative, *this);
+  LIST_TRACE_SCOPE("mergeSortIterative", size_);
 
 
   if (size_ < 2) {
@@ -535,16 +723,16 @@ LinkedList<T> LinkedList<T>::mergeSortIterative() const {
     return *this;
   }
 
-  LinkedList< LinkedList<T> > workQueue = explode();
+  LinkedList< LinkedList<T, Alloc> > workQueue = explode();
 
   while(workQueue.size() > 1) {
     // Remove two lists from the front of the queue.
-    LinkedList<T> left = workQueue.front();
+    LinkedList<T, Alloc> left = workQueue.front();
     workQueue.popFront();
-    LinkedList<T> right = workQueue.front();
+    LinkedList<T, Alloc> right = workQueue.front();
     workQueue.popFront();
     // Merge the two lists.
-    LinkedList<T> merged = left.merge(right);
+    LinkedList<T, Alloc> merged = left.merge(right);
 
     workQueue.pushBack(merged);
   }
@@ -555,8 +743,8 @@ LinkedList<T> LinkedList<T>::mergeSortIterative() const {
 
 // This is a wrapper function that calls one of either mergeSortRecursive
 // or mergeSortIterative.
-template <typename T>
-LinkedList<T> LinkedList<T>::mergeSort() const {
+template <typename T, typename Alloc>
+LinkedList<T, Alloc> LinkedList<T, Alloc>::mergeSort() const {
 
   // As a wrapper function, this should only call one version of mergeSort
   // or the other and return that result.
@@ -566,8 +754,8 @@ LinkedList<T> LinkedList<T>::mergeSort() const {
 
 }
 
-template <typename T>
-bool LinkedList<T>::assertCorrectSize() const {
+template <typename T, typename Alloc>
+bool LinkedList<T, Alloc>::assertCorrectSize() const {
   int itemCount = 0;
   const Node* cur = head_;
   while (cur) {
@@ -578,8 +766,8 @@ bool LinkedList<T>::assertCorrectSize() const {
   else return true;
 }
 
-template <typename T>
-bool LinkedList<T>::assertPrevLinks() const {
+template <typename T, typename Alloc>
+bool LinkedList<T, Alloc>::assertPrevLinks() const {
   // These should end up being the same list, but we'll build one
   // in the forward direction and the other in the reverse direction.
   LinkedList<const Node*> forwardPtrList;
@@ -78,10 +78,11 @@
 
 
 
-template <typename T>
-void LinkedList<T>::insertOrdered(const T& newData) 
+template <typename T, typename Alloc>
+void LinkedList<T, Alloc>::insertOrdered(const T& newData) 
 {
-    Node* newNode = new Node(newData);
+    LIST_RECORD_OP(ListOpCode::InsertOrdered, *this, &newData);
+    Node* newNode = createNode(newData);
     
     if (!head_) 
     {
@@ -200,10 +201,12 @@ void LinkedList<T>::insertOrdered(const T& newData)
 //  ********************************************************************/
 
 
-template <typename T>
-LinkedList<T> LinkedList<T>::merge(const LinkedList<T>& other) const 
+template <typename T, typename Alloc>
+LinkedList<T, Alloc> LinkedList<T, Alloc>::merge(const LinkedList<T, Alloc>& other) const 
 {
-    LinkedList<T> mergedList;
+    LIST_RECORD_OP(ListOpCode::Merge, *this, other);
+    LIST_TRACE_SCOPE("merge", static_cast<long long>(size_) + other.size_);
+    LinkedList<T, Alloc> mergedList(alloc_);
     
     Node* left = head_;
     Node* right = other.head_;
@@ -0,0 +1,293 @@
+
+#pragma once
+
+#include <algorithm> // for std::max
+#include <chrono> // for std::chrono::steady_clock
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t, std::int64_t
+#include <vector> // for std::vector
+
+// Allocation accounting for LinkedList.
+//
+// Built with LINKEDLIST_ALLOC_STATS defined (-DLINKEDLIST_ALLOC_STATS),
+// every LinkedList counts its node allocations and frees, their bytes, and
+// the copy constructions and assignments of items into nodes, and adds
+// them to the collector that is active on the calling thread:
+//
+//   ListAllocStats stats;
+//   {
+//     ScopedListAllocStats collect(stats);
+//     sorted = list.mergeSortRecursive();
+//   }
+//   // stats now covers mergeSortRecursive and all its temporary lists.
+//
+// Without the macro the hooks below are empty inline functions and a
+// collector sees nothing, so there is no cost; ListAllocStats::enabled says
+// which build this is.
+//
+// Item copies are only those LinkedList makes itself when it copies an
+// item into a node; copies inside the item type's own code, or made by
+// callers, are not seen here.
+//
+// A ListMemoryTimeline (below) records the live node bytes over time as
+// well, for plotting how an algorithm's memory use rises and falls.
+
+struct ListAllocStats {
+#ifdef LINKEDLIST_ALLOC_STATS
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+
+  std::uint64_t nodeAllocations = 0;
+  std::uint64_t nodeFrees = 0;
+  std::uint64_t bytesAllocated = 0;
+  std::uint64_t bytesFreed = 0;
+  std::uint64_t itemCopies = 0;
+  std::uint64_t itemAssignments = 0;
+  // The most nodes that were alive at once, counting the nodes that already
+  // existed when collection started as zero.
+  std::uint64_t peakLiveNodes = 0;
+  // Nodes allocated minus nodes freed so far. Negative when more existing
+  // nodes were freed than new ones made.
+  std::int64_t liveNodes = 0;
+  // The same two in bytes, which also weighs nodes of different sizes, such
+  // as the list-of-lists nodes the sorts use.
+  std::uint64_t peakLiveBytes = 0;
+  std::int64_t liveBytes = 0;
+};
+
+// Adds the counts in a scope to a ListAllocStats for as long as it is in
+// scope. Collectors nest: when an inner one ends, its counts are also added
+// to the outer one, so the outer one covers everything in its scope.
+class ScopedListAllocStats {
+public:
+  explicit ScopedListAllocStats(ListAllocStats& stats)
+    : stats_(stats), outer_(active()), outerLiveAtStart_(outer_ ? outer_->stats_.liveNodes : 0),
+      outerLiveBytesAtStart_(outer_ ? outer_->stats_.liveBytes : 0) {
+    active() = this;
+  }
+
+  ~ScopedListAllocStats() {
+    active() = outer_;
+    if (!outer_) return;
+    ListAllocStats& outer = outer_->stats_;
+    outer.nodeAllocations += stats_.nodeAllocations;
+    outer.nodeFrees += stats_.nodeFrees;
+    outer.bytesAllocated += stats_.bytesAllocated;
+    outer.bytesFreed += stats_.bytesFreed;
+    outer.itemCopies += stats_.itemCopies;
+    outer.itemAssignments += stats_.itemAssignments;
+    std::int64_t peak = outerLiveAtStart_ + static_cast<std::int64_t>(stats_.peakLiveNodes);
+    if (peak > 0) outer.peakLiveNodes = std::max(outer.peakLiveNodes, static_cast<std::uint64_t>(peak));
+    outer.liveNodes += stats_.liveNodes;
+    std::int64_t peakBytes = outerLiveBytesAtStart_ + static_cast<std::int64_t>(stats_.peakLiveBytes);
+    if (peakBytes > 0) outer.peakLiveBytes = std::max(outer.peakLiveBytes, static_cast<std::uint64_t>(peakBytes));
+    outer.liveBytes += stats_.liveBytes;
+  }
+
+  ScopedListAllocStats(const ScopedListAllocStats&) = delete;
+  ScopedListAllocStats& operator=(const ScopedListAllocStats&) = delete;
+
+  // The innermost collector on this thread, or nullptr.
+  static ScopedListAllocStats*& active() {
+    static thread_local ScopedListAllocStats* collector = nullptr;
+    return collector;
+  }
+
+  ListAllocStats& stats() { return stats_; }
+
+private:
+  ListAllocStats& stats_;
+  ScopedListAllocStats* outer_;
+  std::int64_t outerLiveAtStart_;
+  std::int64_t outerLiveBytesAtStart_;
+};
+
+// Runs f() with a collector and returns what it counted.
+template <typename F>
+ListAllocStats measureListAllocs(F f) {
+  ListAllocStats stats;
+  {
+    ScopedListAllocStats collect(stats);
+    f();
+  }
+  return stats;
+}
+
+// One point of a ListMemoryTimeline.
+struct ListMemorySample {
+  // Since recording started.
+  double timeMs;
+  std::int64_t liveNodes;
+  std::int64_t liveBytes;
+};
+
+// Live LinkedList nodes and bytes over time, while a
+// ScopedListMemoryTimeline is recording into it:
+//
+//   ListMemoryTimeline timeline;
+//   {
+//     ScopedListMemoryTimeline record(timeline);
+//     sorted = list.mergeSortRecursive();
+//   }
+//   // timeline.samples() traces the sort's memory; peakLiveBytes() is exact.
+//
+// Like ListAllocStats, it counts from zero at the start and needs
+// LINKEDLIST_ALLOC_STATS. A sample is taken whenever the live bytes have
+// moved by at least a step since the last one. The step starts at one byte,
+// and whenever there are more than maxSamples samples, every other one is
+// dropped and the step doubles, so a timeline stays small however long the
+// run. The peaks are kept exactly, whatever the step.
+class ListMemoryTimeline {
+public:
+  static constexpr std::size_t DEFAULT_MAX_SAMPLES = 1024;
+
+  explicit ListMemoryTimeline(std::size_t maxSamples = DEFAULT_MAX_SAMPLES)
+    : maxSamples_(std::max<std::size_t>(maxSamples, 2)) {}
+
+  const std::vector<ListMemorySample>& samples() const { return samples_; }
+  std::uint64_t peakLiveBytes() const { return peakBytes_; }
+  // The live nodes at the time of the byte peak.
+  std::int64_t peakLiveNodes() const { return peakNodes_; }
+  double durationMs() const { return samples_.empty() ? 0 : samples_.back().timeMs; }
+
+  // For ScopedListMemoryTimeline and the hooks.
+  void start() {
+    samples_.clear();
+    liveNodes_ = liveBytes_ = lastSampledBytes_ = 0;
+    peakBytes_ = 0;
+    peakNodes_ = 0;
+    step_ = 1;
+    start_ = std::chrono::steady_clock::now();
+    sample();
+  }
+
+  void changed(std::int64_t nodes, std::int64_t bytes) {
+    liveNodes_ += nodes;
+    liveBytes_ += bytes;
+    if (liveBytes_ > 0 && static_cast<std::uint64_t>(liveBytes_) > peakBytes_) {
+      peakBytes_ = static_cast<std::uint64_t>(liveBytes_);
+      peakNodes_ = liveNodes_;
+    }
+    std::int64_t moved = liveBytes_ - lastSampledBytes_;
+    if (moved >= step_ || -moved >= step_) sample();
+  }
+
+  void sample() {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_;
+    samples_.push_back(ListMemorySample{elapsed.count(), liveNodes_, liveBytes_});
+    lastSampledBytes_ = liveBytes_;
+    if (samples_.size() > maxSamples_) {
+      // Keeps the even samples, and always the newest one.
+      std::size_t kept = 0;
+      for (std::size_t i = 0; i < samples_.size(); i += 2) samples_[kept++] = samples_[i];
+      if (samples_.size() % 2 == 0) samples_[kept++] = samples_.back();
+      samples_.resize(kept);
+      step_ *= 2;
+    }
+  }
+
+private:
+  std::size_t maxSamples_;
+  std::vector<ListMemorySample> samples_;
+  std::int64_t liveNodes_ = 0;
+  std::int64_t liveBytes_ = 0;
+  std::int64_t lastSampledBytes_ = 0;
+  std::int64_t step_ = 1;
+  std::uint64_t peakBytes_ = 0;
+  std::int64_t peakNodes_ = 0;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Records into a ListMemoryTimeline for as long as it is in scope, starting
+// it afresh and taking a last sample at the end. Recorders nest, and every
+// one in the chain sees every change.
+class ScopedListMemoryTimeline {
+public:
+  explicit ScopedListMemoryTimeline(ListMemoryTimeline& timeline) : timeline_(timeline), outer_(active()) {
+    timeline_.start();
+    active() = this;
+  }
+
+  ~ScopedListMemoryTimeline() {
+    timeline_.sample();
+    active() = outer_;
+  }
+
+  ScopedListMemoryTimeline(const ScopedListMemoryTimeline&) = delete;
+  ScopedListMemoryTimeline& operator=(const ScopedListMemoryTimeline&) = delete;
+
+  // The innermost recorder on this thread, or nullptr.
+  static ScopedListMemoryTimeline*& active() {
+    static thread_local ScopedListMemoryTimeline* recorder = nullptr;
+    return recorder;
+  }
+
+  static void changed(std::int64_t nodes, std::int64_t bytes) {
+    for (ScopedListMemoryTimeline* recorder = active(); recorder; recorder = recorder->outer_) {
+      recorder->timeline_.changed(nodes, bytes);
+    }
+  }
+
+private:
+  ListMemoryTimeline& timeline_;
+  ScopedListMemoryTimeline* outer_;
+};
+
+// The hooks LinkedList calls. Only the innermost collector is updated
+// directly; the outer ones catch up when it ends. Every timeline recorder
+// is updated at once.
+namespace list_alloc_stats {
+
+  inline void nodesAllocated(std::size_t count, std::size_t bytes) {
+#ifdef LINKEDLIST_ALLOC_STATS
+    if (ScopedListAllocStats* collector = ScopedListAllocStats::active()) {
+      ListAllocStats& stats = collector->stats();
+      stats.nodeAllocations += count;
+      stats.bytesAllocated += bytes;
+      stats.liveNodes += static_cast<std::int64_t>(count);
+      stats.liveBytes += static_cast<std::int64_t>(bytes);
+      if (stats.liveNodes > 0) {
+        stats.peakLiveNodes = std::max(stats.peakLiveNodes, static_cast<std::uint64_t>(stats.liveNodes));
+      }
+      if (stats.liveBytes > 0) {
+        stats.peakLiveBytes = std::max(stats.peakLiveBytes, static_cast<std::uint64_t>(stats.liveBytes));
+      }
+    }
+    ScopedListMemoryTimeline::changed(static_cast<std::int64_t>(count), static_cast<std::int64_t>(bytes));
+#else
+    (void)count;
+    (void)bytes;
+#endif
+  }
+
+  inline void nodesFreed(std::size_t count, std::size_t bytes) {
+#ifdef LINKEDLIST_ALLOC_STATS
+    if (ScopedListAllocStats* collector = ScopedListAllocStats::active()) {
+      ListAllocStats& stats = collector->stats();
+      stats.nodeFrees += count;
+      stats.bytesFreed += bytes;
+      stats.liveNodes -= static_cast<std::int64_t>(count);
+      stats.liveBytes -= static_cast<std::int64_t>(bytes);
+    }
+    ScopedListMemoryTimeline::changed(-static_cast<std::int64_t>(count), -static_cast<std::int64_t>(bytes));
+#else
+    (void)count;
+    (void)bytes;
+#endif
+  }
+
+  inline void itemCopied() {
+#ifdef LINKEDLIST_ALLOC_STATS
+    if (ScopedListAllocStats* collector = ScopedListAllocStats::active()) collector->stats().itemCopies++;
+#endif
+  }
+
+  inline void itemAssigned() {
+#ifdef LINKEDLIST_ALLOC_STATS
+    if (ScopedListAllocStats* collector = ScopedListAllocStats::active()) collector->stats().itemAssignments++;
+#endif
+  }
+
+}
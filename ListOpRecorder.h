@@ -0,0 +1,745 @@
+
+#pragma once
+
+#include <algorithm> // for std::max
+#include <chrono> // for std::chrono::steady_clock
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t, std::uint32_t, std::uint64_t
+#include <cstdio> // for std::FILE, std::fopen, std::fwrite, std::fread, std::fclose
+#include <cstring> // for std::memcpy, std::memcmp
+#include <memory> // for std::unique_ptr
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::string, std::to_string
+#include <type_traits> // for std::is_integral, std::is_signed, std::decay
+#include <typeinfo> // for std::type_info
+#include <unordered_map> // for std::unordered_map
+#include <utility> // for std::declval
+#include <vector> // for std::vector
+
+// Recording of the operations done on LinkedLists, to a compact binary
+// trace that ListOpReplayer (below) and the lreplay tool can run again
+// against any list type or allocator policy.
+//
+// Built with LINKEDLIST_RECORD defined (-DLINKEDLIST_RECORD), the list
+// operations that change a list or make a new one report themselves to the
+// recorder active on the calling thread: pushBack, pushFront, popBack,
+// popFront, insertOrdered, appendBulk, clear, copy assignment and copy
+// construction, merge, insertionSort, mergeSortRecursive,
+// mergeSortIterative, and destruction. Reads (front, equals, isSorted, ...)
+// are not recorded. Without the macro the hooks are empty.
+//
+//   {
+//     ScopedListOpRecorder<int> record("workload.ops");
+//     runTheWorkload();
+//     record.finish();
+//   }
+//
+// Only lists of the recorder's item type are recorded, which has to be
+// trivially copyable, since items are stored as raw bytes. Only the
+// outermost operation is recorded: a sort is one operation, however many
+// merges it does inside.
+//
+// Lists are told apart by address. A list first seen with items in it gets
+// a snapshot of them, so the replay starts from the same contents. The new
+// list returned by merge or a sort is matched to the list it ends up in,
+// if the next recorded event is on a new list of the same size, which is
+// what "auto s = list.mergeSort();" and "s = a.merge(b);" do; otherwise
+// the result gets a snapshot when it is next used.
+//
+// The trace is a ListOpTraceHeader followed by one record per operation:
+// an opcode byte, then the list ids and list sizes as LEB128 varints, then
+// any items. Items are stored in the byte order of the recording machine.
+
+enum class ListOpCode : std::uint8_t {
+  // The list's whole contents, when it is first seen non-empty.
+  Snapshot = 1,
+  PushBack,
+  PushFront,
+  PopBack,
+  PopFront,
+  InsertOrdered,
+  AppendBulk,
+  Clear,
+  // dst = src, by copy assignment or copy construction.
+  Copy,
+  // A new list dst = a.merge(b).
+  Merge,
+  // A new list dst = a sorted.
+  SortRecursive,
+  SortIterative,
+  InsertionSort,
+  Destroy,
+};
+
+constexpr int LIST_OP_CODES = static_cast<int>(ListOpCode::Destroy) + 1;
+
+inline const char* listOpName(ListOpCode code) {
+  switch (code) {
+    case ListOpCode::Snapshot: return "snapshot";
+    case ListOpCode::PushBack: return "pushBack";
+    case ListOpCode::PushFront: return "pushFront";
+    case ListOpCode::PopBack: return "popBack";
+    case ListOpCode::PopFront: return "popFront";
+    case ListOpCode::InsertOrdered: return "insertOrdered";
+    case ListOpCode::AppendBulk: return "appendBulk";
+    case ListOpCode::Clear: return "clear";
+    case ListOpCode::Copy: return "copy";
+    case ListOpCode::Merge: return "merge";
+    case ListOpCode::SortRecursive: return "mergeSortRecursive";
+    case ListOpCode::SortIterative: return "mergeSortIterative";
+    case ListOpCode::InsertionSort: return "insertionSort";
+    case ListOpCode::Destroy: return "destroy";
+  }
+  return "unknown";
+}
+
+struct ListOpTraceHeader {
+  // The first 8 bytes of every trace.
+  static const char* magicBytes() { return "LLISTOPS"; }
+  static constexpr std::uint32_t CURRENT_VERSION = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  // sizeof(T) for the item type T of the recorded lists.
+  std::uint32_t elementSize;
+  // How the replay should read the items: 'i' for signed integers, 'u' for
+  // unsigned ones, 'f' for floating point and 'x' for anything else.
+  char itemKind;
+  char reserved[15];
+};
+
+static_assert(sizeof(ListOpTraceHeader) == 32, "ListOpTraceHeader layout changed");
+
+template <typename T>
+constexpr char listOpItemKind() {
+  return std::is_floating_point<T>::value ? 'f'
+       : std::is_integral<T>::value ? (std::is_signed<T>::value ? 'i' : 'u')
+       : 'x';
+}
+
+class ListOpScope;
+
+// Writes the trace for the lists of one item type, on the thread that
+// made it, for as long as it exists. Make one through ScopedListOpRecorder.
+class ListOpRecorder {
+public:
+  ListOpRecorder(const ListOpRecorder&) = delete;
+  ListOpRecorder& operator=(const ListOpRecorder&) = delete;
+
+  ~ListOpRecorder() {
+    active() = outer_;
+    if (file_) {
+      flush();
+      std::fclose(file_);
+    }
+  }
+
+  // Writes out what is buffered and closes the file. Throws if any write
+  // failed. Recording stops here.
+  void finish() {
+    if (!file_) return;
+    active() = outer_;
+    flush();
+    bool ok = !failed_ && std::fclose(file_) == 0;
+    file_ = nullptr;
+    if (!ok) throw std::runtime_error("cannot write list op trace " + path_);
+  }
+
+  std::uint64_t operationsRecorded() const { return operations_; }
+
+  // The innermost recorder on this thread, or nullptr.
+  static ListOpRecorder*& active() {
+    static thread_local ListOpRecorder* recorder = nullptr;
+    return recorder;
+  }
+
+protected:
+  ListOpRecorder(const std::string& path, const std::type_info& itemType, std::uint32_t itemSize, char itemKind)
+    : path_(path), itemType_(itemType), itemSize_(itemSize), outer_(active()) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) throw std::runtime_error("cannot create list op trace " + path);
+    ListOpTraceHeader header = {};
+    std::memcpy(header.magic, ListOpTraceHeader::magicBytes(), sizeof(header.magic));
+    header.version = ListOpTraceHeader::CURRENT_VERSION;
+    header.elementSize = itemSize;
+    header.itemKind = itemKind;
+    putBytes(&header, sizeof(header));
+    active() = this;
+  }
+
+private:
+  friend class ListOpScope;
+
+  static constexpr std::size_t BUFFER_BYTES = 1 << 16;
+
+  // The id of list, giving it one if it is new: the pending result of the
+  // last merge or sort if the size fits, or else a new id and a snapshot.
+  template <typename List>
+  std::uint32_t idOf(const List& list) {
+    auto found = ids_.find(&list);
+    if (found != ids_.end()) return found->second;
+    std::uint32_t id;
+    std::uint64_t size = static_cast<std::uint64_t>(list.size());
+    if (pending_ && pendingSize_ == size) {
+      id = pendingId_;
+      pending_ = false;
+    }
+    else {
+      id = nextId_++;
+      if (size) {
+        putCode(ListOpCode::Snapshot);
+        putVarint(id);
+        putVarint(size);
+        for (auto node = list.head_; node; node = node->next) putBytes(&node->data, itemSize_);
+      }
+    }
+    ids_[&list] = id;
+    return id;
+  }
+
+  // The id of a list whose contents are about to be replaced.
+  template <typename List>
+  std::uint32_t targetIdOf(const List& list) {
+    auto found = ids_.find(&list);
+    if (found != ids_.end()) return found->second;
+    std::uint32_t id = nextId_++;
+    ids_[&list] = id;
+    return id;
+  }
+
+  template <typename List>
+  void recordItemOp(ListOpCode code, const List& list, const void* item) {
+    std::uint32_t id = idOf(list);
+    pending_ = false;
+    putCode(code);
+    putVarint(id);
+    putVarint(static_cast<std::uint64_t>(list.size()));
+    putBytes(item, itemSize_);
+  }
+
+  template <typename List>
+  void recordAppend(const List& list, const void* items, std::uint64_t count) {
+    std::uint32_t id = idOf(list);
+    pending_ = false;
+    putCode(ListOpCode::AppendBulk);
+    putVarint(id);
+    putVarint(static_cast<std::uint64_t>(list.size()));
+    putVarint(count);
+    putBytes(items, static_cast<std::size_t>(count) * itemSize_);
+  }
+
+  template <typename List>
+  void recordListOp(ListOpCode code, const List& list) {
+    if (code == ListOpCode::Destroy) {
+      recordDestroy(list);
+      return;
+    }
+    std::uint32_t id = idOf(list);
+    pending_ = false;
+    std::uint64_t size = static_cast<std::uint64_t>(list.size());
+    if (code == ListOpCode::SortRecursive || code == ListOpCode::SortIterative || code == ListOpCode::InsertionSort) {
+      std::uint32_t result = nextId_++;
+      putCode(code);
+      putVarint(result);
+      putVarint(id);
+      putVarint(size);
+      expectResult(result, size);
+      return;
+    }
+    putCode(code);
+    putVarint(id);
+    putVarint(size);
+  }
+
+  template <typename List>
+  void recordDestroy(const List& list) {
+    std::uint64_t size = static_cast<std::uint64_t>(list.size());
+    auto found = ids_.find(&list);
+    std::uint32_t id;
+    if (found != ids_.end()) {
+      id = found->second;
+      ids_.erase(found);
+    }
+    else if (pending_ && pendingSize_ == size) {
+      // A merge or sort result that was dropped unused.
+      id = pendingId_;
+    }
+    else {
+      // Never recorded, so the replay never made it.
+      return;
+    }
+    pending_ = false;
+    putCode(ListOpCode::Destroy);
+    putVarint(id);
+    putVarint(size);
+  }
+
+  template <typename List>
+  void recordPairOp(ListOpCode code, const List& list, const List& other) {
+    if (code == ListOpCode::Copy) {
+      std::uint32_t src = idOf(other);
+      std::uint32_t dst = targetIdOf(list);
+      pending_ = false;
+      putCode(code);
+      putVarint(dst);
+      putVarint(src);
+      putVarint(static_cast<std::uint64_t>(other.size()));
+      return;
+    }
+    // Merge.
+    std::uint32_t a = idOf(list);
+    std::uint32_t b = idOf(other);
+    pending_ = false;
+    std::uint32_t result = nextId_++;
+    std::uint64_t sizeA = static_cast<std::uint64_t>(list.size());
+    std::uint64_t sizeB = static_cast<std::uint64_t>(other.size());
+    putCode(code);
+    putVarint(result);
+    putVarint(a);
+    putVarint(b);
+    putVarint(sizeA);
+    putVarint(sizeB);
+    expectResult(result, sizeA + sizeB);
+  }
+
+  void expectResult(std::uint32_t id, std::uint64_t size) {
+    pending_ = true;
+    pendingId_ = id;
+    pendingSize_ = size;
+  }
+
+  void putCode(ListOpCode code) {
+    operations_++;
+    putByte(static_cast<std::uint8_t>(code));
+  }
+
+  void putVarint(std::uint64_t value) {
+    while (value >= 0x80) {
+      putByte(static_cast<std::uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    putByte(static_cast<std::uint8_t>(value));
+  }
+
+  void putByte(std::uint8_t byte) {
+    buffer_.push_back(byte);
+    if (buffer_.size() >= BUFFER_BYTES) flush();
+  }
+
+  void putBytes(const void* data, std::size_t bytes) {
+    const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+    buffer_.insert(buffer_.end(), p, p + bytes);
+    if (buffer_.size() >= BUFFER_BYTES) flush();
+  }
+
+  void flush() {
+    if (!buffer_.empty() && std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) failed_ = true;
+    buffer_.clear();
+  }
+
+  std::string path_;
+  const std::type_info& itemType_;
+  std::uint32_t itemSize_;
+  ListOpRecorder* outer_;
+  std::FILE* file_ = nullptr;
+  bool failed_ = false;
+  std::vector<std::uint8_t> buffer_;
+  std::unordered_map<const void*, std::uint32_t> ids_;
+  std::uint32_t nextId_ = 0;
+  bool pending_ = false;
+  std::uint32_t pendingId_ = 0;
+  std::uint64_t pendingSize_ = 0;
+  // How deep in recorded operations this thread is; only depth 0 records.
+  int depth_ = 0;
+  std::uint64_t operations_ = 0;
+};
+
+// Records the operations on lists of T on this thread into the trace at
+// path while in scope.
+template <typename T>
+class ScopedListOpRecorder : public ListOpRecorder {
+public:
+  static_assert(std::is_trivially_copyable<T>::value, "recorded list items are stored as raw bytes");
+
+  explicit ScopedListOpRecorder(const std::string& path)
+    : ListOpRecorder(path, typeid(T), sizeof(T), listOpItemKind<T>()) {}
+};
+
+// What the LinkedList operations create through LIST_RECORD_OP: it records
+// the operation if it is the outermost one on a list of the active
+// recorder's type, and keeps the ones it calls from being recorded.
+class ListOpScope {
+public:
+  template <typename List>
+  ListOpScope(ListOpCode code, const List& list) : recorder_(enter<List>()) {
+    if (recording_) recorder_->recordListOp(code, list);
+  }
+
+  template <typename List, typename T>
+  ListOpScope(ListOpCode code, const List& list, const T* item) : recorder_(enter<List>()) {
+    if (recording_) recorder_->recordItemOp(code, list, item);
+  }
+
+  template <typename List, typename T>
+  ListOpScope(ListOpCode code, const List& list, const T* items, int count) : recorder_(enter<List>()) {
+    if (recording_ && count > 0) recorder_->recordAppend(list, items, static_cast<std::uint64_t>(count));
+  }
+
+  template <typename List>
+  ListOpScope(ListOpCode code, const List& list, const List& other) : recorder_(enter<List>()) {
+    if (recording_) recorder_->recordPairOp(code, list, other);
+  }
+
+  ~ListOpScope() {
+    if (recorder_) recorder_->depth_--;
+  }
+
+  ListOpScope(const ListOpScope&) = delete;
+  ListOpScope& operator=(const ListOpScope&) = delete;
+
+private:
+  template <typename List>
+  ListOpRecorder* enter() {
+    ListOpRecorder* recorder = ListOpRecorder::active();
+    if (!recorder) return nullptr;
+    using Item = typename std::decay<decltype(std::declval<const List&>().front())>::type;
+    recording_ = recorder->depth_ == 0 && recorder->file_ && recorder->itemType_ == typeid(Item);
+    recorder->depth_++;
+    return recorder;
+  }
+
+  bool recording_ = false;
+  ListOpRecorder* recorder_;
+};
+
+#ifdef LINKEDLIST_RECORD
+#define LIST_RECORD_OP(...) ListOpScope listOpScope(__VA_ARGS__)
+#else
+#define LIST_RECORD_OP(...) do {} while (false)
+#endif
+
+// One operation read back from a trace. Which fields mean something
+// depends on the code; see ListOpRecorder.
+struct ListOp {
+  ListOpCode code;
+  // The list operated on, or made by a merge, sort or copy.
+  std::uint32_t dst = 0;
+  // The source lists of a merge (a, b), sort or copy (a).
+  std::uint32_t a = 0;
+  std::uint32_t b = 0;
+  // The sizes of the lists, before the operation: dst's, or a's and b's.
+  std::uint64_t sizeA = 0;
+  std::uint64_t sizeB = 0;
+  // The items of a push, insert, append or snapshot, in ListOpTrace::items.
+  std::size_t itemOffset = 0;
+  std::uint64_t itemCount = 0;
+};
+
+// A whole trace in memory.
+class ListOpTrace {
+public:
+  static ListOpTrace read(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) throw std::runtime_error("cannot open list op trace " + path);
+    std::vector<std::uint8_t> bytes;
+    std::uint8_t chunk[1 << 16];
+    std::size_t got;
+    while ((got = std::fread(chunk, 1, sizeof(chunk), file)) > 0) bytes.insert(bytes.end(), chunk, chunk + got);
+    std::fclose(file);
+
+    ListOpTrace trace;
+    if (bytes.size() < sizeof(ListOpTraceHeader)) throw std::runtime_error("list op trace is too short: " + path);
+    ListOpTraceHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, ListOpTraceHeader::magicBytes(), sizeof(header.magic)) != 0) {
+      throw std::runtime_error("not a list op trace: " + path);
+    }
+    if (header.version != ListOpTraceHeader::CURRENT_VERSION) {
+      throw std::runtime_error("unsupported list op trace version in " + path);
+    }
+    if (header.elementSize == 0) throw std::runtime_error("bad item size in list op trace " + path);
+    trace.elementSize_ = header.elementSize;
+    trace.itemKind_ = header.itemKind;
+
+    Reader reader{bytes, sizeof(header), path};
+    while (reader.at < bytes.size()) {
+      ListOp op;
+      std::size_t opStart = reader.at;
+      std::uint8_t code = reader.byte();
+      if (code < 1 || code >= LIST_OP_CODES) {
+        throw std::runtime_error("bad operation in list op trace " + path + " at byte " + std::to_string(opStart));
+      }
+      op.code = static_cast<ListOpCode>(code);
+      switch (op.code) {
+        case ListOpCode::Snapshot:
+          op.dst = reader.id();
+          op.itemCount = reader.varint();
+          break;
+        case ListOpCode::PushBack:
+        case ListOpCode::PushFront:
+        case ListOpCode::InsertOrdered:
+          op.dst = reader.id();
+          op.sizeA = reader.varint();
+          op.itemCount = 1;
+          break;
+        case ListOpCode::AppendBulk:
+          op.dst = reader.id();
+          op.sizeA = reader.varint();
+          op.itemCount = reader.varint();
+          break;
+        case ListOpCode::PopBack:
+        case ListOpCode::PopFront:
+        case ListOpCode::Clear:
+        case ListOpCode::Destroy:
+          op.dst = reader.id();
+          op.sizeA = reader.varint();
+          break;
+        case ListOpCode::Copy:
+        case ListOpCode::SortRecursive:
+        case ListOpCode::SortIterative:
+        case ListOpCode::InsertionSort:
+          op.dst = reader.id();
+          op.a = reader.id();
+          op.sizeA = reader.varint();
+          break;
+        case ListOpCode::Merge:
+          op.dst = reader.id();
+          op.a = reader.id();
+          op.b = reader.id();
+          op.sizeA = reader.varint();
+          op.sizeB = reader.varint();
+          break;
+      }
+      if (op.itemCount) {
+        std::uint64_t itemBytes = op.itemCount * trace.elementSize_;
+        if (itemBytes / trace.elementSize_ != op.itemCount || itemBytes > bytes.size() - reader.at) {
+          throw std::runtime_error("list op trace " + path + " is truncated");
+        }
+        op.itemOffset = trace.addItems(bytes.data() + reader.at, static_cast<std::size_t>(itemBytes));
+        reader.at += static_cast<std::size_t>(itemBytes);
+      }
+      // The recorder hands out list ids in order of first use, and one
+      // operation names at most three lists, so a higher id means a corrupt
+      // trace (and a replay would make room for that many lists).
+      std::size_t highestId = std::max(op.dst, std::max(op.a, op.b));
+      if (highestId >= trace.listCount_ + 3) {
+        throw std::runtime_error("bad list id in list op trace " + path + " at byte " + std::to_string(opStart));
+      }
+      trace.listCount_ = std::max(trace.listCount_, highestId + 1);
+      trace.ops_.push_back(op);
+    }
+    return trace;
+  }
+
+  std::uint32_t elementSize() const { return elementSize_; }
+  char itemKind() const { return itemKind_; }
+  const std::vector<ListOp>& ops() const { return ops_; }
+  // One more than the highest list id.
+  std::size_t listCount() const { return listCount_; }
+
+  // The i-th item of op, as T.
+  template <typename T>
+  T item(const ListOp& op, std::uint64_t i = 0) const {
+    return itemsOf<T>(op)[i];
+  }
+
+  // The items of op, as an array of T.
+  template <typename T>
+  const T* itemsOf(const ListOp& op) const {
+    return reinterpret_cast<const T*>(reinterpret_cast<const std::uint8_t*>(items_.data()) + op.itemOffset);
+  }
+
+private:
+  struct Reader {
+    const std::vector<std::uint8_t>& bytes;
+    std::size_t at;
+    const std::string& path;
+
+    std::uint8_t byte() {
+      if (at >= bytes.size()) throw std::runtime_error("list op trace " + path + " is truncated");
+      return bytes[at++];
+    }
+
+    std::uint64_t varint() {
+      std::uint64_t value = 0;
+      for (int shift = 0; shift < 64; shift += 7) {
+        std::uint8_t b = byte();
+        value |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return value;
+      }
+      throw std::runtime_error("bad number in list op trace " + path);
+    }
+
+    std::uint32_t id() {
+      std::uint64_t value = varint();
+      if (value > 0xFFFFFFFFu) throw std::runtime_error("bad list id in list op trace " + path);
+      return static_cast<std::uint32_t>(value);
+    }
+  };
+
+  // Copies the items of one operation in, starting on an 8-byte boundary,
+  // and returns their byte offset.
+  std::size_t addItems(const std::uint8_t* data, std::size_t bytes) {
+    std::size_t offset = items_.size() * sizeof(std::uint64_t);
+    items_.resize(items_.size() + (bytes + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+    std::memcpy(reinterpret_cast<std::uint8_t*>(items_.data()) + offset, data, bytes);
+    return offset;
+  }
+
+  std::uint32_t elementSize_ = 0;
+  char itemKind_ = 'x';
+  std::vector<ListOp> ops_;
+  // The items of all operations, in words so that they are aligned.
+  std::vector<std::uint64_t> items_;
+  std::size_t listCount_ = 0;
+};
+
+// Runs a trace against lists of type List holding T, which must match the
+// recorded item type in size and kind. List needs the LinkedList
+// operations that are recorded, plus size().
+//
+//   ListOpTrace trace = ListOpTrace::read("workload.ops");
+//   ListOpReplayer<int, LinkedList<int, ArenaNodeAllocator>> replayer(trace);
+//   replayer.run([](const ListOp& op, std::uint64_t ns) { ... });
+//
+// Every operation is timed on its own with steady_clock. Before each one
+// the list sizes are checked against the recorded ones, and a mismatch
+// throws, since the replay would no longer be the recorded workload.
+template <typename T, typename List>
+class ListOpReplayer {
+public:
+  explicit ListOpReplayer(const ListOpTrace& trace) : trace_(trace) {
+    if (trace.elementSize() != sizeof(T) || trace.itemKind() != listOpItemKind<T>()) {
+      throw std::runtime_error("the trace holds " + std::to_string(trace.elementSize()) + "-byte items of kind '" +
+                               std::string(1, trace.itemKind()) + "', which don't match the replay's item type");
+    }
+  }
+
+  // Replays the whole trace from empty lists, calling observe(op, ns) after
+  // each operation with its time in nanoseconds.
+  template <typename Observer>
+  void run(Observer observe) {
+    lists_.clear();
+    lists_.resize(trace_.listCount());
+    const std::vector<ListOp>& ops = trace_.ops();
+    for (std::size_t i = 0; i < ops.size(); i++) {
+      const ListOp& op = ops[i];
+      List& dst = at(op.dst);
+      std::chrono::steady_clock::time_point start;
+      switch (op.code) {
+        case ListOpCode::Snapshot: {
+          dst.clear();
+          const T* items = trace_.template itemsOf<T>(op);
+          start = std::chrono::steady_clock::now();
+          for (std::uint64_t k = 0; k < op.itemCount; k++) dst.pushBack(items[k]);
+          break;
+        }
+        case ListOpCode::PushBack: {
+          check(i, dst, op.sizeA);
+          T item = trace_.template item<T>(op);
+          start = std::chrono::steady_clock::now();
+          dst.pushBack(item);
+          break;
+        }
+        case ListOpCode::PushFront: {
+          check(i, dst, op.sizeA);
+          T item = trace_.template item<T>(op);
+          start = std::chrono::steady_clock::now();
+          dst.pushFront(item);
+          break;
+        }
+        case ListOpCode::InsertOrdered: {
+          check(i, dst, op.sizeA);
+          T item = trace_.template item<T>(op);
+          start = std::chrono::steady_clock::now();
+          dst.insertOrdered(item);
+          break;
+        }
+        case ListOpCode::AppendBulk:
+          check(i, dst, op.sizeA);
+          start = std::chrono::steady_clock::now();
+          dst.appendBulk(trace_.template itemsOf<T>(op), static_cast<int>(op.itemCount));
+          break;
+        case ListOpCode::PopBack:
+          check(i, dst, op.sizeA);
+          start = std::chrono::steady_clock::now();
+          dst.popBack();
+          break;
+        case ListOpCode::PopFront:
+          check(i, dst, op.sizeA);
+          start = std::chrono::steady_clock::now();
+          dst.popFront();
+          break;
+        case ListOpCode::Clear:
+          check(i, dst, op.sizeA);
+          start = std::chrono::steady_clock::now();
+          dst.clear();
+          break;
+        case ListOpCode::Destroy:
+          check(i, dst, op.sizeA);
+          start = std::chrono::steady_clock::now();
+          lists_[op.dst].reset();
+          break;
+        case ListOpCode::Copy: {
+          const List& src = at(op.a);
+          check(i, src, op.sizeA);
+          start = std::chrono::steady_clock::now();
+          dst = src;
+          break;
+        }
+        case ListOpCode::Merge: {
+          const List& a = at(op.a);
+          const List& b = at(op.b);
+          check(i, a, op.sizeA);
+          check(i, b, op.sizeB);
+          start = std::chrono::steady_clock::now();
+          lists_[op.dst].reset(new List(a.merge(b)));
+          break;
+        }
+        case ListOpCode::SortRecursive: {
+          const List& src = at(op.a);
+          check(i, src, op.sizeA);
+          start = std::chrono::steady_clock::now();
+          lists_[op.dst].reset(new List(src.mergeSortRecursive()));
+          break;
+        }
+        case ListOpCode::SortIterative: {
+          const List& src = at(op.a);
+          check(i, src, op.sizeA);
+          start = std::chrono::steady_clock::now();
+          lists_[op.dst].reset(new List(src.mergeSortIterative()));
+          break;
+        }
+        case ListOpCode::InsertionSort: {
+          const List& src = at(op.a);
+          check(i, src, op.sizeA);
+          start = std::chrono::steady_clock::now();
+          lists_[op.dst].reset(new List(src.insertionSort()));
+          break;
+        }
+      }
+      std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+      observe(op, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    }
+  }
+
+  // The list with the given id as the replay left it, or nullptr.
+  const List* list(std::uint32_t id) const { return id < lists_.size() ? lists_[id].get() : nullptr; }
+
+private:
+  List& at(std::uint32_t id) {
+    if (!lists_[id]) lists_[id].reset(new List());
+    return *lists_[id];
+  }
+
+  static void check(std::size_t index, const List& list, std::uint64_t size) {
+    if (static_cast<std::uint64_t>(list.size()) != size) {
+      throw std::runtime_error("replay diverged from the trace at operation " + std::to_string(index) +
+                               ": a list has " + std::to_string(list.size()) + " items, the trace says " +
+                               std::to_string(size));
+    }
+  }
+
+  const ListOpTrace& trace_;
+  std::vector<std::unique_ptr<List>> lists_;
+};
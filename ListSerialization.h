@@ -0,0 +1,294 @@
+
+#pragma once
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint32_t, std::uint64_t
+#include <cstdio> // for std::FILE, std::fopen, std::fwrite, std::fseek, std::fclose
+#include <cstring> // for std::memcpy, std::memcmp
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::string
+#include <type_traits> // for std::is_trivially_copyable
+#include <utility> // for std::declval
+#include <vector> // for std::vector
+
+#include <fcntl.h> // for open
+#include <sys/mman.h> // for mmap, munmap, madvise
+#include <sys/stat.h> // for fstat
+#include <unistd.h> // for close
+
+#include "LinkedList.h"
+
+// A binary file format for LinkedList<T> with trivially copyable T (Linux).
+//
+// The file is a ListFileHeader followed by the items stored back to back,
+// exactly as they are laid out in memory. So a file is only readable on a
+// machine with the same endianness and the same layout of T; the header
+// records sizeof(T) to catch the most likely mismatch.
+//
+// saveList writes the list through a large buffer in one pass, computing
+// the checksum and the sorted flag on the way. loadList maps the file and
+// appends every item with LinkedList::appendBulk, which sets the links in
+// the same pass and, with an arena policy, allocates all nodes in a single
+// block. MappedListView reads a file in place without allocating at all.
+
+struct ListFileHeader {
+  // The first 8 bytes of every list file.
+  static const char* magicBytes() { return "LLISTBIN"; }
+  static constexpr std::uint32_t CURRENT_VERSION = 1;
+  static constexpr std::uint32_t SORTED_FLAG = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  // sizeof(T) for the T the file was written with.
+  std::uint32_t elementSize;
+  std::uint64_t count;
+  std::uint32_t flags;
+  std::uint32_t reserved;
+  // ListFileChecksum of the item bytes.
+  std::uint64_t checksum;
+  // Pads the header so that the items after it are suitably aligned.
+  std::uint64_t padding[3];
+
+  bool sorted() const { return flags & SORTED_FLAG; }
+};
+
+static_assert(sizeof(ListFileHeader) == 64, "ListFileHeader layout changed");
+
+// A fast 64-bit checksum that can be computed in pieces, as long as every
+// piece but the last is a multiple of 8 bytes long. It catches truncation
+// and corruption; it is not meant to resist tampering.
+class ListFileChecksum {
+public:
+  ListFileChecksum() : hash_(0x9E3779B97F4A7C15ull), bytes_(0) {}
+
+  void update(const void* data, std::size_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    std::size_t words = bytes / 8;
+    for (std::size_t i = 0; i < words; i++) {
+      std::uint64_t word;
+      std::memcpy(&word, p + i * 8, 8);
+      mix(word);
+    }
+    std::size_t rest = bytes % 8;
+    if (rest) {
+      std::uint64_t word = 0;
+      std::memcpy(&word, p + words * 8, rest);
+      mix(word);
+    }
+    bytes_ += bytes;
+  }
+
+  std::uint64_t value() const {
+    std::uint64_t h = hash_ ^ bytes_;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    return h;
+  }
+
+private:
+  void mix(std::uint64_t word) {
+    hash_ = (hash_ ^ word) * 0x100000001B3ull;
+    hash_ = (hash_ << 31) | (hash_ >> 33);
+  }
+
+  std::uint64_t hash_;
+  std::uint64_t bytes_;
+};
+
+namespace list_file_detail {
+
+  // a < b if T has operator<, otherwise the list is never flagged sorted.
+  template <typename T>
+  auto lessThan(const T& a, const T& b, int) -> decltype(bool(a < b)) { return a < b; }
+  template <typename T>
+  bool lessThan(const T&, const T&, long) { return true; }
+
+  template <typename T>
+  auto hasLess(int) -> decltype(bool(std::declval<const T&>() < std::declval<const T&>())) { return true; }
+  template <typename T>
+  bool hasLess(long) { return false; }
+
+  // A read-only mapping of a whole file that has a valid ListFileHeader.
+  class MappedListFile {
+  public:
+    MappedListFile(const std::string& path, std::size_t elementSize) : data_(nullptr), bytes_(0) {
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) throw std::runtime_error("cannot open list file " + path);
+      struct stat st;
+      if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot stat list file " + path);
+      }
+      bytes_ = static_cast<std::size_t>(st.st_size);
+      if (bytes_ < sizeof(ListFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("list file is too short for a header: " + path);
+      }
+      void* data = ::mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (data == MAP_FAILED) throw std::runtime_error("cannot map list file " + path);
+      data_ = static_cast<const char*>(data);
+      // The items are read once, front to back.
+      ::madvise(data, bytes_, MADV_SEQUENTIAL);
+
+      try {
+        validate(path, elementSize);
+      }
+      catch (...) {
+        ::munmap(const_cast<char*>(data_), bytes_);
+        throw;
+      }
+    }
+
+    MappedListFile(const MappedListFile&) = delete;
+    MappedListFile& operator=(const MappedListFile&) = delete;
+
+    ~MappedListFile() {
+      ::munmap(const_cast<char*>(data_), bytes_);
+    }
+
+    const ListFileHeader& header() const { return *reinterpret_cast<const ListFileHeader*>(data_); }
+    const char* items() const { return data_ + sizeof(ListFileHeader); }
+    std::size_t itemBytes() const { return bytes_ - sizeof(ListFileHeader); }
+
+    bool checksumMatches() const {
+      ListFileChecksum checksum;
+      checksum.update(items(), itemBytes());
+      return checksum.value() == header().checksum;
+    }
+
+  private:
+    void validate(const std::string& path, std::size_t elementSize) const {
+      const ListFileHeader& h = header();
+      if (std::memcmp(h.magic, ListFileHeader::magicBytes(), sizeof(h.magic)) != 0) {
+        throw std::runtime_error("not a list file: " + path);
+      }
+      if (h.version != ListFileHeader::CURRENT_VERSION) {
+        throw std::runtime_error("unsupported list file version in " + path);
+      }
+      if (h.elementSize != elementSize) {
+        throw std::runtime_error("list file " + path + " holds items of " + std::to_string(h.elementSize) +
+                                 " bytes, expected " + std::to_string(elementSize));
+      }
+      if (h.count > itemBytes() / elementSize || h.count * elementSize != itemBytes()) {
+        throw std::runtime_error("list file " + path + " is truncated or has trailing data");
+      }
+    }
+
+    const char* data_;
+    std::size_t bytes_;
+  };
+
+}
+
+// Write the list to path, replacing any existing file.
+template <typename T, typename Alloc>
+void saveList(const LinkedList<T, Alloc>& list, const std::string& path) {
+  static_assert(std::is_trivially_copyable<T>::value, "saveList needs a trivially copyable item type");
+
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) throw std::runtime_error("cannot create list file " + path);
+
+  ListFileHeader header = {};
+  std::memcpy(header.magic, ListFileHeader::magicBytes(), sizeof(header.magic));
+  header.version = ListFileHeader::CURRENT_VERSION;
+  header.elementSize = sizeof(T);
+  header.count = static_cast<std::uint64_t>(list.size());
+
+  // The header is written again at the end, once the checksum is known.
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+
+  // Items are gathered into chunks of a multiple of 8 items, so every chunk
+  // but the last is a multiple of 8 bytes for the checksum.
+  constexpr std::size_t CHUNK_ITEMS = 8 * ((1 << 20) / (8 * sizeof(T)) + 1);
+  std::vector<T> chunk;
+  chunk.reserve(CHUNK_ITEMS);
+  ListFileChecksum checksum;
+  bool sorted = list_file_detail::hasLess<T>(0);
+  const T* prev = nullptr;
+
+  for (const auto* cur = list.getHeadPtr(); cur && ok; cur = cur->next) {
+    if (sorted && prev && list_file_detail::lessThan(cur->data, *prev, 0)) sorted = false;
+    prev = &cur->data;
+    chunk.push_back(cur->data);
+    if (chunk.size() == CHUNK_ITEMS || !cur->next) {
+      checksum.update(chunk.data(), chunk.size() * sizeof(T));
+      ok = std::fwrite(chunk.data(), sizeof(T), chunk.size(), file) == chunk.size();
+      chunk.clear();
+    }
+  }
+
+  header.checksum = checksum.value();
+  header.flags = sorted ? ListFileHeader::SORTED_FLAG : 0;
+  ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+  ok = (std::fclose(file) == 0) && ok;
+  if (!ok) throw std::runtime_error("error writing list file " + path);
+}
+
+// Replace the contents of list with the items in the file at path. Throws
+// std::runtime_error if the file is missing, malformed, holds a different
+// item size, or (when verifyChecksum is true) fails its checksum.
+template <typename T, typename Alloc>
+void loadList(const std::string& path, LinkedList<T, Alloc>& list, bool verifyChecksum = true) {
+  static_assert(std::is_trivially_copyable<T>::value, "loadList needs a trivially copyable item type");
+
+  list_file_detail::MappedListFile file(path, sizeof(T));
+  if (verifyChecksum && !file.checksumMatches()) {
+    throw std::runtime_error("checksum mismatch in list file " + path);
+  }
+  if (file.header().count > static_cast<std::uint64_t>(INT32_MAX)) {
+    throw std::runtime_error("list file " + path + " has more items than a LinkedList can hold");
+  }
+  list.clear();
+  list.appendBulk(reinterpret_cast<const T*>(file.items()), static_cast<int>(file.header().count));
+}
+
+// A read-only view of a list file, mapped in place. Nothing is allocated
+// or copied; the items are read straight from the page cache. The view
+// must outlive any pointer or reference taken from it.
+template <typename T>
+class MappedListView {
+public:
+  static_assert(std::is_trivially_copyable<T>::value, "MappedListView needs a trivially copyable item type");
+
+  explicit MappedListView(const std::string& path) : file_(path, sizeof(T)) {}
+
+  std::size_t size() const { return static_cast<std::size_t>(file_.header().count); }
+  bool empty() const { return size() == 0; }
+
+  // The sorted flag recorded when the file was saved.
+  bool isSorted() const { return file_.header().sorted(); }
+
+  bool checksumMatches() const { return file_.checksumMatches(); }
+
+  const T* begin() const { return reinterpret_cast<const T*>(file_.items()); }
+  const T* end() const { return begin() + size(); }
+
+  const T& operator[](std::size_t i) const { return begin()[i]; }
+
+  const T& front() const {
+    if (empty()) throw std::runtime_error("front() called on empty MappedListView");
+    return *begin();
+  }
+
+  const T& back() const {
+    if (empty()) throw std::runtime_error("back() called on empty MappedListView");
+    return end()[-1];
+  }
+
+  // Whether the items are byte for byte the same as the list's, in the same
+  // order.
+  template <typename Alloc>
+  bool equals(const LinkedList<T, Alloc>& list) const {
+    if (static_cast<std::size_t>(list.size()) != size()) return false;
+    const T* item = begin();
+    for (const auto* cur = list.getHeadPtr(); cur; cur = cur->next, item++) {
+      if (std::memcmp(&cur->data, item, sizeof(T)) != 0) return false;
+    }
+    return true;
+  }
+
+private:
+  list_file_detail::MappedListFile file_;
+};
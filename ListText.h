@@ -0,0 +1,240 @@
+
+#pragma once
+
+#include <cerrno> // for errno, ERANGE
+#include <cstddef> // for std::size_t
+#include <cstdlib> // for std::strtod, std::strtof, std::strtold
+#include <cstring> // for std::memcpy
+#include <limits> // for std::numeric_limits
+#include <memory> // for std::unique_ptr
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::string
+#include <type_traits> // for std::is_floating_point, std::is_signed, std::integral_constant
+
+#include <fcntl.h> // for open
+#include <sys/mman.h> // for mmap, munmap, madvise
+#include <sys/stat.h> // for fstat
+#include <unistd.h> // for close
+
+#include "LinkedList.h"
+
+// Reading lists of numbers back from text (Linux).
+//
+// parseList accepts either the format that LinkedList::print writes,
+// "[(1)(2)(3)]", or plain values separated by whitespace such as one per
+// line. Whitespace is allowed around every bracket. The numbers are parsed
+// by hand (floating point with strtod) and gathered into chunks that are
+// appended with LinkedList::appendBulk, so an arena policy gets one block
+// per chunk rather than one allocation per node. loadListText maps a file
+// and parses it in place.
+
+namespace list_text_detail {
+
+  // Walks the text, keeping the start so that errors can give an offset.
+  class TextCursor {
+  public:
+    TextCursor(const char* text, std::size_t length) : begin_(text), cur_(text), end_(text + length) {}
+
+    bool atEnd() const { return cur_ == end_; }
+    char peek() const { return *cur_; }
+    void advance() { cur_++; }
+
+    void skipSpace() {
+      while (cur_ != end_ && isSpace(*cur_)) cur_++;
+    }
+
+    // Skips whitespace, then the expected character.
+    void expect(char c) {
+      skipSpace();
+      if (atEnd() || *cur_ != c) fail(std::string("expected '") + c + "'");
+      cur_++;
+    }
+
+    // The run of characters up to the next whitespace or bracket.
+    const char* tokenEnd() const {
+      const char* p = cur_;
+      while (p != end_ && !isSpace(*p) && *p != '(' && *p != ')' && *p != '[' && *p != ']') p++;
+      return p;
+    }
+
+    const char* position() const { return cur_; }
+    void moveTo(const char* p) { cur_ = p; }
+
+    [[noreturn]] void fail(const std::string& what) const {
+      throw std::runtime_error("list text: " + what + " at offset " + std::to_string(cur_ - begin_));
+    }
+
+    static bool isSpace(char c) {
+      return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+  private:
+    const char* begin_;
+    const char* cur_;
+    const char* end_;
+  };
+
+  template <typename T>
+  T parseNumber(TextCursor& text, std::false_type) {
+    const char* end = text.tokenEnd();
+    const char* p = text.position();
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+      negative = *p == '-';
+      p++;
+    }
+    if (p == end) text.fail("expected a number");
+
+    constexpr unsigned long long MAX = std::numeric_limits<unsigned long long>::max();
+    unsigned long long magnitude = 0;
+    for (; p != end; p++) {
+      unsigned digit = static_cast<unsigned>(*p - '0');
+      if (digit > 9) text.fail("expected a number");
+      if (magnitude > (MAX - digit) / 10) text.fail("number out of range");
+      magnitude = magnitude * 10 + digit;
+    }
+
+    // The unsigned limits of T, worked out without overflowing T itself.
+    unsigned long long largest = static_cast<unsigned long long>(std::numeric_limits<T>::max());
+    unsigned long long smallest = std::is_signed<T>::value ? largest + 1 : 0;
+    if (negative ? magnitude > smallest : magnitude > largest) text.fail("number out of range");
+    text.moveTo(end);
+    return negative ? static_cast<T>(0 - static_cast<long long>(magnitude - 1) - 1) : static_cast<T>(magnitude);
+  }
+
+  inline float toFloating(const char* s, char** end, float*) { return std::strtof(s, end); }
+  inline double toFloating(const char* s, char** end, double*) { return std::strtod(s, end); }
+  inline long double toFloating(const char* s, char** end, long double*) { return std::strtold(s, end); }
+
+  template <typename T>
+  T parseNumber(TextCursor& text, std::true_type) {
+    const char* end = text.tokenEnd();
+    std::size_t length = static_cast<std::size_t>(end - text.position());
+    // strtod needs a terminated string, and the text may not have one.
+    char token[128];
+    if (length == 0 || length >= sizeof(token)) text.fail("expected a number");
+    std::memcpy(token, text.position(), length);
+    token[length] = '\0';
+
+    char* parsedEnd = nullptr;
+    errno = 0;
+    T value = toFloating(token, &parsedEnd, static_cast<T*>(nullptr));
+    if (parsedEnd != token + length) text.fail("expected a number");
+    // Underflow to zero or a denormal is fine; overflow to infinity is not.
+    if (errno == ERANGE && (value > 1 || value < -1)) text.fail("number out of range");
+    text.moveTo(end);
+    return value;
+  }
+
+  template <typename T>
+  T parseItem(TextCursor& text) {
+    text.skipSpace();
+    return parseNumber<T>(text, std::integral_constant<bool, std::is_floating_point<T>::value>());
+  }
+
+  // Collects items and appends them to the list a chunk at a time.
+  template <typename T, typename Alloc>
+  class ChunkedAppender {
+  public:
+    static constexpr std::size_t CHUNK_ITEMS = 1 << 16;
+
+    // Not a std::vector, which has no data() for bool.
+    explicit ChunkedAppender(LinkedList<T, Alloc>& list) : list_(list), chunk_(new T[CHUNK_ITEMS]), count_(0) {}
+
+    void add(const T& item) {
+      chunk_[count_++] = item;
+      if (count_ == CHUNK_ITEMS) flush();
+    }
+
+    void flush() {
+      list_.appendBulk(chunk_.get(), static_cast<int>(count_));
+      count_ = 0;
+    }
+
+  private:
+    LinkedList<T, Alloc>& list_;
+    std::unique_ptr<T[]> chunk_;
+    std::size_t count_;
+  };
+
+  template <typename T, typename Alloc>
+  void parseInto(TextCursor& text, LinkedList<T, Alloc>& list) {
+    ChunkedAppender<T, Alloc> out(list);
+    text.skipSpace();
+    if (!text.atEnd() && text.peek() == '[') {
+      text.advance();
+      for (;;) {
+        text.skipSpace();
+        if (text.atEnd()) text.fail("expected '(' or ']'");
+        if (text.peek() == ']') break;
+        text.expect('(');
+        out.add(parseItem<T>(text));
+        text.expect(')');
+      }
+      text.advance();
+      text.skipSpace();
+      if (!text.atEnd()) text.fail("unexpected text after ']'");
+    }
+    else {
+      while (!text.atEnd()) {
+        out.add(parseItem<T>(text));
+        text.skipSpace();
+      }
+    }
+    out.flush();
+  }
+
+}
+
+// Replace the contents of list with the items in text. Throws
+// std::runtime_error, leaving the list empty, if the text is malformed or
+// a number does not fit in T.
+template <typename T, typename Alloc>
+void parseList(const char* text, std::size_t length, LinkedList<T, Alloc>& list) {
+  static_assert(isFastListText<T>::value, "parseList needs an arithmetic non-character item type");
+  list.clear();
+  list_text_detail::TextCursor cursor(text, length);
+  try {
+    list_text_detail::parseInto(cursor, list);
+  }
+  catch (...) {
+    list.clear();
+    throw;
+  }
+}
+
+template <typename T, typename Alloc>
+void parseList(const std::string& text, LinkedList<T, Alloc>& list) {
+  parseList(text.data(), text.size(), list);
+}
+
+// Replace the contents of list with the items in the text file at path.
+template <typename T, typename Alloc>
+void loadListText(const std::string& path, LinkedList<T, Alloc>& list) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("cannot open list text file " + path);
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("cannot stat list text file " + path);
+  }
+  std::size_t bytes = static_cast<std::size_t>(st.st_size);
+  if (bytes == 0) {
+    ::close(fd);
+    list.clear();
+    return;
+  }
+  void* data = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) throw std::runtime_error("cannot map list text file " + path);
+  ::madvise(data, bytes, MADV_SEQUENTIAL);
+
+  try {
+    parseList(static_cast<const char*>(data), bytes, list);
+  }
+  catch (...) {
+    ::munmap(data, bytes);
+    throw;
+  }
+  ::munmap(data, bytes);
+}
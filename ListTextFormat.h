@@ -0,0 +1,173 @@
+
+#pragma once
+
+#include <cstddef> // for std::size_t
+#include <cstdio> // for std::snprintf
+#include <cstring> // for std::memcpy
+#include <limits> // for std::numeric_limits
+#include <locale> // for std::locale
+#include <memory> // for std::unique_ptr
+#include <ostream> // for std::ostream, std::ios_base
+#include <type_traits> // for std::is_arithmetic, std::is_floating_point, std::is_signed, std::make_unsigned
+
+// Fast text formatting for the arithmetic items of a list.
+//
+// Writing a list through std::ostream costs a virtual call, a sentry and a
+// locale lookup for every "(", every item and every ")". ListTextBuffer
+// renders items into one reusable char buffer instead (integers by hand,
+// floating point with snprintf) and hands the buffer to the stream in large
+// writes. The text is the same as what operator<< produces on a stream with
+// default formatting flags and the classic locale.
+
+namespace list_text_detail {
+
+  // Character types print as characters rather than numbers, so they are
+  // left to the stream.
+  template <typename T>
+  struct isCharacter {
+    static constexpr bool value =
+      std::is_same<T, char>::value || std::is_same<T, signed char>::value ||
+      std::is_same<T, unsigned char>::value || std::is_same<T, wchar_t>::value ||
+      std::is_same<T, char16_t>::value || std::is_same<T, char32_t>::value;
+  };
+
+  // "00" "01" ... "99", so that integers can be written two digits at a time.
+  inline const char* digitPairs() {
+    return
+      "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+      "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+      "8081828384858687888990919293949596979899";
+  }
+
+  // Writes the decimal digits of value so that they end just before end,
+  // and returns where they start.
+  template <typename U>
+  char* writeDigitsBackwards(U value, char* end) {
+    const char* pairs = digitPairs();
+    while (value >= 100) {
+      unsigned pair = static_cast<unsigned>(value % 100) * 2;
+      value /= 100;
+      *--end = pairs[pair + 1];
+      *--end = pairs[pair];
+    }
+    if (value >= 10) {
+      unsigned pair = static_cast<unsigned>(value) * 2;
+      *--end = pairs[pair + 1];
+      *--end = pairs[pair];
+    }
+    else {
+      *--end = static_cast<char>('0' + value);
+    }
+    return end;
+  }
+
+}
+
+// Whether ListTextBuffer can format T by itself.
+template <typename T>
+struct isFastListText {
+  static constexpr bool value = std::is_arithmetic<T>::value && !list_text_detail::isCharacter<T>::value;
+};
+
+class ListTextBuffer {
+public:
+  // The buffer is flushed once it holds this many bytes.
+  static constexpr std::size_t FLUSH_BYTES = 1 << 16;
+  // The longest single item: a long double in %Lg with the largest precision
+  // we let through, plus the brackets around it.
+  static constexpr std::size_t MAX_ITEM_BYTES = 128;
+  static constexpr int MAX_PRECISION = 64;
+
+  ListTextBuffer() : data_(new char[FLUSH_BYTES + MAX_ITEM_BYTES]), size_(0) {}
+
+  ListTextBuffer(const ListTextBuffer&) = delete;
+  ListTextBuffer& operator=(const ListTextBuffer&) = delete;
+
+  // The calling thread's buffer, emptied. It is made once per thread and
+  // reused, so that printing a short list doesn't allocate. Callers must
+  // be done with it before anything else on the thread asks for it.
+  static ListTextBuffer& forThread() {
+    static thread_local ListTextBuffer buffer;
+    buffer.clear();
+    return buffer;
+  }
+
+  const char* data() const { return data_.get(); }
+  std::size_t size() const { return size_; }
+  void clear() { size_ = 0; }
+
+  // Whether the buffer should be flushed before more items are added.
+  bool full() const { return size_ >= FLUSH_BYTES; }
+
+  void append(char c) { data_[size_++] = c; }
+
+  void append(const char* text, std::size_t length) {
+    std::memcpy(data_.get() + size_, text, length);
+    size_ += length;
+  }
+
+  // Appends "(value)". For floating point, precision is the number of
+  // significant digits, as in std::ostream::precision().
+  template <typename T>
+  void appendItem(const T& value, int precision = 6) {
+    static_assert(isFastListText<T>::value, "ListTextBuffer only formats arithmetic non-character types");
+    append('(');
+    appendValue(value, precision, std::is_floating_point<T>());
+    append(')');
+  }
+
+  // Writes out and empties the buffer, straight to the stream buffer. The
+  // caller should hold a std::ostream::sentry for os. Returns false if the
+  // stream failed.
+  bool flushTo(std::ostream& os) {
+    bool ok = size_ == 0 || os.rdbuf()->sputn(data_.get(), size_) == static_cast<std::streamsize>(size_);
+    if (!ok) os.setstate(std::ios_base::badbit);
+    size_ = 0;
+    return ok;
+  }
+
+  // Whether operator<< on os would give the same text as appendItem, i.e.
+  // the stream uses default flags, no field width and the classic locale,
+  // with no digit grouping and '.' as the decimal point.
+  static bool matchesStream(const std::ostream& os) {
+    return os.flags() == (std::ios_base::skipws | std::ios_base::dec) && os.width() == 0 &&
+      os.precision() >= 0 && os.precision() <= MAX_PRECISION && os.getloc() == std::locale::classic();
+  }
+
+private:
+  template <typename T>
+  void appendValue(T value, int, std::false_type) {
+    using U = typename std::make_unsigned<typename std::conditional<std::is_same<T, bool>::value, unsigned, T>::type>::type;
+    char digits[std::numeric_limits<U>::digits10 + 2];
+    char* end = digits + sizeof(digits);
+    U magnitude = static_cast<U>(value);
+    if (isNegative(value, std::is_signed<T>())) {
+      // Negate as unsigned, which is also right for the most negative value.
+      magnitude = static_cast<U>(U() - magnitude);
+      append('-');
+    }
+    char* begin = list_text_detail::writeDigitsBackwards(magnitude, end);
+    append(begin, static_cast<std::size_t>(end - begin));
+  }
+
+  template <typename T>
+  static bool isNegative(T value, std::true_type) { return value < 0; }
+  template <typename T>
+  static bool isNegative(T, std::false_type) { return false; }
+
+  // float and double print the same as a stream prints them, since the
+  // stream also formats both as a double with %.*g.
+  template <typename T>
+  void appendValue(T value, int precision, std::true_type) {
+    int written = std::snprintf(data_.get() + size_, MAX_ITEM_BYTES - 2, "%.*g", precision, static_cast<double>(value));
+    if (written > 0) size_ += static_cast<std::size_t>(written);
+  }
+
+  void appendValue(long double value, int precision, std::true_type) {
+    int written = std::snprintf(data_.get() + size_, MAX_ITEM_BYTES - 2, "%.*Lg", precision, value);
+    if (written > 0) size_ += static_cast<std::size_t>(written);
+  }
+
+  std::unique_ptr<char[]> data_;
+  std::size_t size_;
+};
@@ -0,0 +1,220 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic
+#include <chrono> // for std::chrono::steady_clock
+#include <cstdint> // for std::uint64_t, std::int64_t, std::uint32_t
+#include <cstdio> // for std::snprintf
+#include <fstream> // for std::ofstream
+#include <memory> // for std::unique_ptr, std::shared_ptr
+#include <mutex> // for std::mutex, std::lock_guard
+#include <ostream> // for std::ostream
+#include <string> // for std::string
+#include <vector> // for std::vector
+
+#include <sys/syscall.h> // for SYS_gettid
+#include <unistd.h> // for syscall, getpid
+
+// Tracing of the phases of the list algorithms, as Chrome trace-event JSON
+// that chrome://tracing and ui.perfetto.dev can show as a timeline.
+//
+// Built with LINKEDLIST_TRACE defined (-DLINKEDLIST_TRACE), the sorts,
+// merge, splitHalves, explode and clear mark their start and end with
+// LIST_TRACE_SCOPE, which records a begin and an end event with the list
+// size and the nesting depth on the calling thread. Without the macro,
+// LIST_TRACE_SCOPE is an empty statement and nothing is recorded.
+//
+//   LinkedList<int> sorted = list.mergeSortRecursive();
+//   ListTrace::writeChromeJson("sort.json");
+//
+// Every thread records into its own ring buffer of BUFFER_EVENTS events
+// with plain stores, so recording takes no lock; when a buffer is full the
+// oldest events are overwritten. Write the trace when the traced threads
+// are done; buffers outlive their threads.
+//
+// Lists smaller than minSize() (1024 by default) are not traced, so that a
+// large sort shows its structure without the millions of tiny merges at
+// the bottom of the recursion.
+
+struct ListTraceEvent {
+  const char* name;
+  std::uint64_t timeNs;
+  std::int64_t size;
+  std::uint32_t depth;
+  // 'B' for begin, 'E' for end.
+  char phase;
+};
+
+// One thread's events. Only the owning thread pushes.
+class ListTraceBuffer {
+public:
+  static constexpr std::size_t BUFFER_EVENTS = std::size_t(1) << 16;
+
+  ListTraceBuffer() : events_(new ListTraceEvent[BUFFER_EVENTS]), threadId_(static_cast<std::uint32_t>(::syscall(SYS_gettid))) {}
+
+  void push(const ListTraceEvent& event) {
+    std::uint64_t written = written_.load(std::memory_order_relaxed);
+    events_[written % BUFFER_EVENTS] = event;
+    written_.store(written + 1, std::memory_order_release);
+  }
+
+  // How many events were ever pushed; the last BUFFER_EVENTS of them are
+  // still here.
+  std::uint64_t written() const { return written_.load(std::memory_order_acquire); }
+
+  const ListTraceEvent& event(std::uint64_t index) const { return events_[index % BUFFER_EVENTS]; }
+
+  std::uint32_t threadId() const { return threadId_; }
+
+  void clear() { written_.store(0, std::memory_order_release); }
+
+  // The nesting depth of the traced scopes open on the owning thread.
+  std::uint32_t depth = 0;
+
+private:
+  std::unique_ptr<ListTraceEvent[]> events_;
+  std::atomic<std::uint64_t> written_{0};
+  std::uint32_t threadId_;
+};
+
+class ListTrace {
+public:
+  static bool compiledIn() {
+#ifdef LINKEDLIST_TRACE
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // Tracing can also be switched off at run time; it starts on.
+  static bool enabled() { return flags().enabled.load(std::memory_order_relaxed); }
+  static void setEnabled(bool on) { flags().enabled.store(on, std::memory_order_relaxed); }
+
+  static long long minSize() { return flags().minSize.load(std::memory_order_relaxed); }
+  static void setMinSize(long long size) { flags().minSize.store(size, std::memory_order_relaxed); }
+
+  // The calling thread's buffer, made on first use.
+  static ListTraceBuffer& threadBuffer() {
+    static thread_local std::shared_ptr<ListTraceBuffer> buffer;
+    if (!buffer) {
+      buffer = std::make_shared<ListTraceBuffer>();
+      Registry& registry = ListTrace::registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.buffers.push_back(buffer);
+    }
+    return *buffer;
+  }
+
+  static std::uint64_t nowNs() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  // Drops every recorded event.
+  static void clear() {
+    Registry& registry = ListTrace::registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const std::shared_ptr<ListTraceBuffer>& buffer : registry.buffers) buffer->clear();
+  }
+
+  // Writes all recorded events as a Chrome trace-event JSON object.
+  // Timestamps are in microseconds, as the format wants. An end event
+  // whose begin was overwritten is dropped, since the viewers can't place
+  // it; the count of those is in "otherData".
+  static void writeChromeJson(std::ostream& os) {
+    Registry& registry = ListTrace::registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    long pid = static_cast<long>(::getpid());
+    std::uint64_t dropped = 0;
+    bool first = true;
+    os << "{\"traceEvents\": [";
+    for (const std::shared_ptr<ListTraceBuffer>& buffer : registry.buffers) {
+      std::uint64_t end = buffer->written();
+      std::uint64_t start = end > ListTraceBuffer::BUFFER_EVENTS ? end - ListTraceBuffer::BUFFER_EVENTS : 0;
+      dropped += start;
+      // Begin events seen and not yet ended, to spot end events whose begin
+      // was overwritten.
+      std::int64_t open = 0;
+      for (std::uint64_t i = start; i < end; i++) {
+        const ListTraceEvent& event = buffer->event(i);
+        if (event.phase == 'E' && open == 0) {
+          dropped++;
+          continue;
+        }
+        open += event.phase == 'B' ? 1 : -1;
+        char ts[32];
+        std::snprintf(ts, sizeof(ts), "%.3f", static_cast<double>(event.timeNs) / 1000.0);
+        os << (first ? "\n" : ",\n") << "{\"name\": \"" << event.name << "\", \"cat\": \"list\", \"ph\": \"" << event.phase
+           << "\", \"ts\": " << ts << ", \"pid\": " << pid << ", \"tid\": " << buffer->threadId()
+           << ", \"args\": {\"size\": " << event.size << ", \"depth\": " << event.depth << "}}";
+        first = false;
+      }
+    }
+    os << "\n], \"displayTimeUnit\": \"ns\", \"otherData\": {\"dropped_events\": " << dropped << "}}\n";
+  }
+
+  // Returns false if the file can't be written.
+  static bool writeChromeJson(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+    writeChromeJson(out);
+    return static_cast<bool>(out);
+  }
+
+private:
+  struct Flags {
+    std::atomic<bool> enabled{true};
+    std::atomic<long long> minSize{1024};
+  };
+
+  struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ListTraceBuffer>> buffers;
+  };
+
+  static Flags& flags() {
+    static Flags flags;
+    return flags;
+  }
+
+  static Registry& registry() {
+    static Registry registry;
+    return registry;
+  }
+};
+
+// Records a begin event now and the matching end event when it goes out
+// of scope, if tracing is on and the list is big enough.
+class ListTraceScope {
+public:
+  ListTraceScope(const char* name, long long size) : name_(name), size_(size), buffer_(nullptr) {
+    if (!ListTrace::enabled() || size < ListTrace::minSize()) return;
+    buffer_ = &ListTrace::threadBuffer();
+    buffer_->push(ListTraceEvent{name_, ListTrace::nowNs(), size_, buffer_->depth, 'B'});
+    buffer_->depth++;
+  }
+
+  ~ListTraceScope() {
+    if (!buffer_) return;
+    buffer_->depth--;
+    buffer_->push(ListTraceEvent{name_, ListTrace::nowNs(), size_, buffer_->depth, 'E'});
+  }
+
+  ListTraceScope(const ListTraceScope&) = delete;
+  ListTraceScope& operator=(const ListTraceScope&) = delete;
+
+private:
+  const char* name_;
+  long long size_;
+  ListTraceBuffer* buffer_;
+};
+
+#define LIST_TRACE_CONCAT_INNER(a, b) a##b
+#define LIST_TRACE_CONCAT(a, b) LIST_TRACE_CONCAT_INNER(a, b)
+
+#ifdef LINKEDLIST_TRACE
+#define LIST_TRACE_SCOPE(name, size) ListTraceScope LIST_TRACE_CONCAT(listTraceScope, __LINE__)(name, size)
+#else
+#define LIST_TRACE_SCOPE(name, size) do {} while (false)
+#endif
@@ -0,0 +1,397 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic
+#include <cstddef> // for std::max_align_t
+#include <mutex> // for std::mutex, std::lock, std::unique_lock, std::lock_guard
+#include <new> // for placement new
+#include <shared_mutex> // for std::shared_timed_mutex, std::shared_lock
+#include <thread> // for std::this_thread::yield
+
+#include "LinkedList.h"
+#include "ThreadCachedNodeAllocator.h"
+
+// A thread-safe doubly-linked list with one mutex per node.
+//
+// The list is bracketed by two sentinel nodes, so every real node always has
+// a predecessor and a successor to lock. Element operations lock only the
+// nodes they touch, moving along the list "hand over hand": the next node is
+// locked before the previous one is released, so nothing can be unlinked
+// from under a traversal. That lets insertOrdered, popFront, popBack and
+// readers at different positions run at the same time.
+//
+// To rule out deadlock, nodes are always locked from front to back. The
+// backward operations (pushBack, popBack) start from the tail sentinel, so
+// they only try_lock the nodes in front of it and start over if that fails.
+//
+// Whole-list operations (merge, sort, clear) take the list's structure lock
+// in exclusive mode, which waits for every element operation to finish and
+// then needs no node locks at all. Element operations take it shared.
+//
+// Unlike the lock-free containers, items are only ever accessed under a
+// lock, so T doesn't need to be trivially copyable or safe to copy
+// concurrently.
+template <typename T>
+class LockCoupledList {
+public:
+
+  class Node {
+  public:
+    // The next node, or nullptr in the tail sentinel.
+    Node* next;
+    // The previous node, or nullptr in the head sentinel.
+    Node* prev;
+    // Guards next, prev and the data item.
+    std::mutex mutex;
+    // Storage for the data item. (Sentinels have none.)
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    Node() : next(nullptr), prev(nullptr) {}
+
+    T& data() { return *reinterpret_cast<T*>(storage); }
+  };
+
+  static_assert(alignof(Node) <= alignof(std::max_align_t), "item alignment not supported by the node pool");
+
+  LockCoupledList() : size_(0) {
+    head_ = new (NodePool::allocate()) Node();
+    tail_ = new (NodePool::allocate()) Node();
+    head_->next = tail_;
+    tail_->prev = head_;
+  }
+
+  LockCoupledList(const LockCoupledList&) = delete;
+  LockCoupledList& operator=(const LockCoupledList&) = delete;
+
+  // No other thread may be using the list while it is destroyed.
+  ~LockCoupledList() {
+    clearNodes();
+    freeNode(head_);
+    freeNode(tail_);
+  }
+
+  int size() const { return size_.load(std::memory_order_relaxed); }
+
+  bool empty() const { return size() == 0; }
+
+  void pushFront(const T& newData) {
+    Node* newNode = createNode(newData);
+    std::shared_lock<std::shared_timed_mutex> shared(structure_);
+    std::lock_guard<std::mutex> headLock(head_->mutex);
+    Node* first = head_->next;
+    std::lock_guard<std::mutex> firstLock(first->mutex);
+    linkBetween(newNode, head_, first);
+  }
+
+  void pushBack(const T& newData) {
+    Node* newNode = createNode(newData);
+    std::shared_lock<std::shared_timed_mutex> shared(structure_);
+    while (true) {
+      std::unique_lock<std::mutex> tailLock(tail_->mutex);
+      // tail_->prev can't change while we hold the tail, but locking it now
+      // is against the front-to-back order, so only try.
+      Node* last = tail_->prev;
+      std::unique_lock<std::mutex> lastLock(last->mutex, std::try_to_lock);
+      if (!lastLock.owns_lock()) {
+        tailLock.unlock();
+        std::this_thread::yield();
+        continue;
+      }
+      linkBetween(newNode, last, tail_);
+      return;
+    }
+  }
+
+  // Copy the front item into out and remove it. Returns false if the list
+  // was empty.
+  bool popFront(T& out) {
+    std::shared_lock<std::shared_timed_mutex> shared(structure_);
+    std::lock_guard<std::mutex> headLock(head_->mutex);
+    Node* first = head_->next;
+    if (first == tail_) return false;
+    std::unique_lock<std::mutex> firstLock(first->mutex);
+    Node* second = first->next;
+    std::lock_guard<std::mutex> secondLock(second->mutex);
+    out = first->data();
+    unlink(first);
+    // Nobody else can be waiting for first: they would have to hold head_
+    // or second to reach it.
+    firstLock.unlock();
+    destroyNode(first);
+    return true;
+  }
+
+  // Copy the back item into out and remove it. Returns false if the list
+  // was empty.
+  bool popBack(T& out) {
+    std::shared_lock<std::shared_timed_mutex> shared(structure_);
+    while (true) {
+      std::unique_lock<std::mutex> tailLock(tail_->mutex);
+      Node* last = tail_->prev;
+      if (last == head_) return false;
+      std::unique_lock<std::mutex> lastLock(last->mutex, std::try_to_lock);
+      if (!lastLock.owns_lock()) {
+        tailLock.unlock();
+        std::this_thread::yield();
+        continue;
+      }
+      Node* before = last->prev;
+      std::unique_lock<std::mutex> beforeLock(before->mutex, std::try_to_lock);
+      if (!beforeLock.owns_lock()) {
+        lastLock.unlock();
+        tailLock.unlock();
+        std::this_thread::yield();
+        continue;
+      }
+      out = last->data();
+      unlink(last);
+      lastLock.unlock();
+      destroyNode(last);
+      return true;
+    }
+  }
+
+  // Assuming the list is sorted, insert a copy of the new data item in front
+  // of the first item that is greater than it, or at the back if there is
+  // none. This is the same placement as LinkedList::insertOrdered.
+  void insertOrdered(const T& newData) {
+    Node* newNode = createNode(newData);
+    std::shared_lock<std::shared_timed_mutex> shared(structure_);
+    std::unique_lock<std::mutex> prevLock(head_->mutex);
+    Node* prev = head_;
+    Node* cur = prev->next;
+    std::unique_lock<std::mutex> curLock(cur->mutex);
+    while (cur != tail_ && !(newData < cur->data())) {
+      prevLock = std::move(curLock);
+      prev = cur;
+      cur = cur->next;
+      curLock = std::unique_lock<std::mutex>(cur->mutex);
+    }
+    linkBetween(newNode, prev, cur);
+  }
+
+  // Whether an item equal to the given one is in the list. The list doesn't
+  // need to be sorted.
+  bool contains(const T& item) {
+    return walkUntil([&](const T& other) { return !(item < other) && !(other < item); });
+  }
+
+  // Calls visit(item) for each item from front to back, with the item's node
+  // locked. visit must not call back into the list.
+  template <typename Visitor>
+  void forEach(Visitor visit) {
+    walkUntil([&](const T& item) {
+      visit(item);
+      return false;
+    });
+  }
+
+  // A copy of the current contents, e.g. for splitHalves or printing.
+  LinkedList<T> toLinkedList() {
+    LinkedList<T> result;
+    forEach([&](const T& item) { result.pushBack(item); });
+    return result;
+  }
+
+  // Remove every item. This takes the list exclusively.
+  void clear() {
+    std::lock_guard<std::shared_timed_mutex> exclusive(structure_);
+    clearNodes();
+  }
+
+  // Sort the list in place with a stable merge sort. Only links are
+  // rewritten. This takes the list exclusively.
+  void sort() {
+    std::lock_guard<std::shared_timed_mutex> exclusive(structure_);
+    Node* first = detachChain();
+    if (!first) return;
+
+    // Bottom-up: merge runs of width 1, 2, 4, ... along the next links.
+    for (int width = 1; ; width *= 2) {
+      Node* sortedHead = nullptr;
+      Node* sortedTail = nullptr;
+      int merges = 0;
+      Node* rest = first;
+      while (rest) {
+        merges++;
+        Node* left = rest;
+        int leftSize = 0;
+        while (rest && leftSize < width) {
+          rest = rest->next;
+          leftSize++;
+        }
+        Node* right = rest;
+        int rightSize = 0;
+        while (rest && rightSize < width) {
+          rest = rest->next;
+          rightSize++;
+        }
+        while (leftSize > 0 || rightSize > 0) {
+          Node* node;
+          if (rightSize == 0 || (leftSize > 0 && !(right->data() < left->data()))) {
+            node = left;
+            left = left->next;
+            leftSize--;
+          }
+          else {
+            node = right;
+            right = right->next;
+            rightSize--;
+          }
+          if (sortedTail) sortedTail->next = node;
+          else sortedHead = node;
+          sortedTail = node;
+        }
+      }
+      sortedTail->next = nullptr;
+      first = sortedHead;
+      if (merges <= 1) break;
+    }
+    attachChain(first);
+  }
+
+  // Assuming this list and the other list are both sorted, move all of the
+  // other list's items into this one in sorted order, leaving the other list
+  // empty. When items compare equal, the ones already in this list come
+  // first. This takes both lists exclusively.
+  void merge(LockCoupledList& other) {
+    if (&other == this) return;
+    std::unique_lock<std::shared_timed_mutex> mine(structure_, std::defer_lock);
+    std::unique_lock<std::shared_timed_mutex> theirs(other.structure_, std::defer_lock);
+    std::lock(mine, theirs);
+
+    int otherSize = other.size_.load(std::memory_order_relaxed);
+    Node* left = detachChain();
+    Node* right = other.detachChain();
+    other.size_.store(0, std::memory_order_relaxed);
+
+    Node* mergedHead = nullptr;
+    Node* mergedTail = nullptr;
+    while (left || right) {
+      Node* node;
+      if (!right || (left && !(right->data() < left->data()))) {
+        node = left;
+        left = left->next;
+      }
+      else {
+        node = right;
+        right = right->next;
+      }
+      if (mergedTail) mergedTail->next = node;
+      else mergedHead = node;
+      mergedTail = node;
+    }
+    if (mergedTail) mergedTail->next = nullptr;
+    attachChain(mergedHead);
+    size_.fetch_add(otherSize, std::memory_order_relaxed);
+  }
+
+  // Checks whether the list is currently sorted in increasing order.
+  bool isSorted() {
+    bool sorted = true;
+    const T* prev = nullptr;
+    forEach([&](const T& item) {
+      if (prev && item < *prev) sorted = false;
+      prev = &item;
+    });
+    return sorted;
+  }
+
+private:
+  using NodePool = NodeCache<sizeof(Node)>;
+
+  Node* createNode(const T& newData) {
+    Node* newNode = new (NodePool::allocate()) Node();
+    try {
+      new (newNode->storage) T(newData);
+    }
+    catch (...) {
+      freeNode(newNode);
+      throw;
+    }
+    return newNode;
+  }
+
+  static void freeNode(Node* node) {
+    node->~Node();
+    NodePool::deallocate(node);
+  }
+
+  static void destroyNode(Node* node) {
+    node->data().~T();
+    freeNode(node);
+  }
+
+  // Hand over hand from the front, until stop(item) returns true. Returns
+  // whether it did.
+  template <typename Stop>
+  bool walkUntil(Stop stop) {
+    std::shared_lock<std::shared_timed_mutex> shared(structure_);
+    std::unique_lock<std::mutex> prevLock(head_->mutex);
+    Node* cur = head_->next;
+    std::unique_lock<std::mutex> curLock(cur->mutex);
+    while (cur != tail_) {
+      if (stop(static_cast<const T&>(cur->data()))) return true;
+      prevLock = std::move(curLock);
+      cur = cur->next;
+      curLock = std::unique_lock<std::mutex>(cur->mutex);
+    }
+    return false;
+  }
+
+  // prev and next must be adjacent and both locked.
+  void linkBetween(Node* newNode, Node* prev, Node* next) {
+    newNode->prev = prev;
+    newNode->next = next;
+    prev->next = newNode;
+    next->prev = newNode;
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // node and both of its neighbors must be locked.
+  void unlink(Node* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    size_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // With the list held exclusively: unhook the real nodes from the
+  // sentinels and return them as a nullptr-terminated chain.
+  Node* detachChain() {
+    if (head_->next == tail_) return nullptr;
+    Node* first = head_->next;
+    tail_->prev->next = nullptr;
+    head_->next = tail_;
+    tail_->prev = head_;
+    return first;
+  }
+
+  // The reverse of detachChain: link a chain in between the sentinels,
+  // rebuilding the prev links. The list must be empty.
+  void attachChain(Node* first) {
+    Node* prev = head_;
+    for (Node* cur = first; cur; cur = cur->next) {
+      prev->next = cur;
+      cur->prev = prev;
+      prev = cur;
+    }
+    prev->next = tail_;
+    tail_->prev = prev;
+  }
+
+  void clearNodes() {
+    Node* cur = detachChain();
+    while (cur) {
+      Node* next = cur->next;
+      destroyNode(cur);
+      cur = next;
+    }
+    size_.store(0, std::memory_order_relaxed);
+  }
+
+  // Shared for element operations, exclusive for whole-list operations.
+  std::shared_timed_mutex structure_;
+  Node* head_;
+  Node* tail_;
+  std::atomic<int> size_;
+};
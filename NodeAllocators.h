@@ -0,0 +1,232 @@
+
+#pragma once
+
+#include <cstddef> // for std::size_t, std::max_align_t
+#include <cstdlib> // for std::malloc, std::free
+#include <new> // for std::bad_alloc, ::operator new
+
+// Node allocator policies for LinkedList<T, Alloc>.
+//
+// Each LinkedList owns one instance of its allocator policy. The list asks
+// the policy for raw storage for exactly one Node at a time and constructs
+// the Node in place, so a policy only has to provide:
+//
+//   template <typename NodeT> void* allocate();
+//   template <typename NodeT> void deallocate(NodeT* node);
+//   void release();
+//   static constexpr bool releasesInBulk;
+//
+// A policy may also provide
+//
+//   template <typename NodeT> void reserve(std::size_t count);
+//
+// as a hint that count nodes are about to be allocated one after another,
+// e.g. by LinkedList::appendBulk. Policies without it are simply not told.
+//
+// When releasesInBulk is true, release() frees every node the policy ever
+// handed out in one go, and the list is allowed to skip deallocate() for the
+// individual nodes when it is being cleared. A copy of a policy object must
+// start out empty: it carries over configuration only, never storage.
+
+// The default policy: every node is a separate heap allocation, exactly as
+// if the list had used "new Node" and "delete node" directly.
+class HeapNodeAllocator {
+public:
+  static constexpr bool releasesInBulk = false;
+
+  template <typename NodeT>
+  void* allocate() {
+    return ::operator new(sizeof(NodeT));
+  }
+
+  template <typename NodeT>
+  void deallocate(NodeT* node) {
+    ::operator delete(node);
+  }
+
+  // Nothing to do: every node was already returned through deallocate().
+  void release() {}
+};
+
+// Block sources provide the large blocks that an arena carves nodes from:
+//
+//   static constexpr std::size_t defaultBlockBytes;
+//   void* allocateBlock(std::size_t& bytes);  // may round bytes up
+//   void freeBlock(void* block, std::size_t bytes);
+//
+// Like allocator policies, a copied block source carries configuration only.
+
+// Blocks come from malloc.
+class MallocBlockSource {
+public:
+  static constexpr std::size_t defaultBlockBytes = 64 * 1024;
+
+  void* allocateBlock(std::size_t& bytes) {
+    void* block = std::malloc(bytes);
+    if (!block) throw std::bad_alloc();
+    return block;
+  }
+
+  void freeBlock(void* block, std::size_t bytes) {
+    std::free(block);
+  }
+};
+
+// An arena policy: nodes are carved out of blocks with a bump pointer, so
+// building a list costs one block allocation per block instead of one malloc
+// per node. Blocks start small and double in size up to the configured block
+// size, so the many short temporary lists made by the sort algorithms stay
+// cheap. Individually freed nodes go onto a free list and are reused by the
+// next allocation. release() drops all blocks at once, which makes clearing
+// a list of trivially destructible items independent of its length.
+//
+// An arena is owned by a single list and is not thread-safe.
+template <typename BlockSource>
+class BasicArenaNodeAllocator {
+public:
+  static constexpr bool releasesInBulk = true;
+  static constexpr std::size_t DEFAULT_BLOCK_BYTES = BlockSource::defaultBlockBytes;
+  static constexpr std::size_t INITIAL_BLOCK_BYTES = 256;
+
+  explicit BasicArenaNodeAllocator(std::size_t blockBytes = DEFAULT_BLOCK_BYTES, const BlockSource& source = BlockSource())
+    : source_(source), blockBytes_(blockBytes),
+      nextBlockBytes_(INITIAL_BLOCK_BYTES < blockBytes ? INITIAL_BLOCK_BYTES : blockBytes),
+      blocks_(nullptr), spare_(nullptr), cur_(nullptr), end_(nullptr), freeList_(nullptr),
+      blockCount_(0) {}
+
+  // A copy gets the same block size but none of the storage.
+  BasicArenaNodeAllocator(const BasicArenaNodeAllocator& other)
+    : BasicArenaNodeAllocator(other.blockBytes_, other.source_) {}
+
+  BasicArenaNodeAllocator& operator=(const BasicArenaNodeAllocator& other) = delete;
+
+  ~BasicArenaNodeAllocator() {
+    release();
+    if (spare_) source_.freeBlock(spare_, spare_->bytes);
+  }
+
+  template <typename NodeT>
+  void* allocate() {
+    static_assert(sizeof(NodeT) >= sizeof(FreeNode), "node too small for the arena free list");
+    static_assert(alignof(NodeT) <= alignof(std::max_align_t), "node alignment not supported by the arena");
+
+    // Reuse a node that was freed earlier, if there is one.
+    if (freeList_) {
+      FreeNode* node = freeList_;
+      freeList_ = node->next;
+      return node;
+    }
+
+    constexpr std::size_t nodeBytes = roundUp(sizeof(NodeT));
+    if (cur_ + nodeBytes > end_) {
+      newBlock(nodeBytes);
+    }
+    void* result = cur_;
+    cur_ += nodeBytes;
+    return result;
+  }
+
+  // Make sure the next count nodes can be carved from one block, so that a
+  // bulk load is a single block allocation however big the block size is.
+  template <typename NodeT>
+  void reserve(std::size_t count) {
+    constexpr std::size_t nodeBytes = roundUp(sizeof(NodeT));
+    std::size_t bytes = count * nodeBytes;
+    if (static_cast<std::size_t>(end_ - cur_) < bytes) {
+      newBlock(bytes);
+    }
+  }
+
+  template <typename NodeT>
+  void deallocate(NodeT* node) {
+    FreeNode* freed = reinterpret_cast<FreeNode*>(node);
+    freed->next = freeList_;
+    freeList_ = freed;
+  }
+
+  // Frees every block at once. The newest (and largest) block is kept back
+  // as a spare so that refilling a cleared list doesn't go straight back to
+  // the block source.
+  void release() {
+    while (blocks_) {
+      BlockHeader* next = blocks_->next;
+      if (!spare_) {
+        spare_ = blocks_;
+      }
+      else {
+        source_.freeBlock(blocks_, blocks_->bytes);
+      }
+      blocks_ = next;
+    }
+    cur_ = nullptr;
+    end_ = nullptr;
+    freeList_ = nullptr;
+    blockCount_ = 0;
+  }
+
+  std::size_t blockBytes() const { return blockBytes_; }
+  std::size_t blockCount() const { return blockCount_; }
+  const BlockSource& blockSource() const { return source_; }
+
+  // Calls visit(address, bytes) for every block currently in use.
+  template <typename Visitor>
+  void forEachBlock(Visitor visit) const {
+    for (const BlockHeader* block = blocks_; block; block = block->next) {
+      visit(static_cast<const void*>(block), block->bytes);
+    }
+  }
+
+private:
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  struct BlockHeader {
+    BlockHeader* next;
+    std::size_t bytes;
+  };
+
+  static constexpr std::size_t roundUp(std::size_t bytes) {
+    return (bytes + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+  }
+
+  void newBlock(std::size_t nodeBytes) {
+    // Oversized nodes still get a block of their own.
+    std::size_t bytes = nextBlockBytes_;
+    if (bytes < roundUp(sizeof(BlockHeader)) + nodeBytes) {
+      bytes = roundUp(sizeof(BlockHeader)) + nodeBytes;
+    }
+    if (nextBlockBytes_ < blockBytes_) {
+      nextBlockBytes_ = (nextBlockBytes_ * 2 < blockBytes_) ? nextBlockBytes_ * 2 : blockBytes_;
+    }
+
+    BlockHeader* block = nullptr;
+    if (spare_ && spare_->bytes >= bytes) {
+      block = spare_;
+      spare_ = nullptr;
+    }
+    else {
+      // The source may round the size up, e.g. to a whole huge page.
+      block = static_cast<BlockHeader*>(source_.allocateBlock(bytes));
+      block->bytes = bytes;
+    }
+
+    block->next = blocks_;
+    blocks_ = block;
+    blockCount_++;
+    cur_ = reinterpret_cast<char*>(block) + roundUp(sizeof(BlockHeader));
+    end_ = reinterpret_cast<char*>(block) + block->bytes;
+  }
+
+  BlockSource source_;
+  std::size_t blockBytes_;
+  std::size_t nextBlockBytes_;
+  BlockHeader* blocks_;
+  BlockHeader* spare_;
+  char* cur_;
+  char* end_;
+  FreeNode* freeList_;
+  std::size_t blockCount_;
+};
+
+using ArenaNodeAllocator = BasicArenaNodeAllocator<MallocBlockSource>;
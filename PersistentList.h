@@ -0,0 +1,337 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic
+#include <ostream> // for std::ostream
+#include <stdexcept> // for std::runtime_error
+
+#include "LinkedList.h"
+
+// An immutable singly-linked list whose nodes are shared between versions,
+// like the cons lists of functional languages.
+//
+// A PersistentList is a pointer to its first node plus its length. Nodes are
+// never modified after construction; each node holds a reference count and
+// a counted reference to the rest of the list. So copying a list, taking
+// its tail (popFront) or putting a new item in front of it (pushFront) are
+// all O(1) and allocate at most one node, and the result shares every node
+// of the original. Operations that have to change the middle of a list copy
+// only the nodes in front of the change and share the unchanged suffix.
+//
+// Different PersistentList objects can be used on different threads even
+// when they share nodes, since the reference counts are atomic. As with
+// LinkedList, one object must not be modified by two threads at once.
+template <typename T>
+class PersistentList {
+public:
+
+  class Node {
+  public:
+    // The next node in the list, or nullptr if this is the last node.
+    // Every node holds a reference to its successor. (Lists only hand out
+    // const Node pointers, so this can't be changed from outside.)
+    const Node* next;
+    // The data item, which never changes.
+    const T data;
+
+    Node(const T& dataArg, const Node* nextArg) : next(nextArg), data(dataArg), refs_(1) {}
+
+  private:
+    friend class PersistentList;
+    // The number of lists and nodes that point to this node.
+    mutable std::atomic<int> refs_;
+  };
+
+  static constexpr char LIST_GENERAL_BUG_MESSAGE[] = "[Error] Probable causes: wrong head_ pointer, wrong reference count, or wrong size_";
+
+  // The empty list.
+  PersistentList() : head_(nullptr), size_(0) {}
+
+  // Copies share all nodes with the original, in O(1) time.
+  PersistentList(const PersistentList& other) : head_(acquire(other.head_)), size_(other.size_) {}
+
+  PersistentList& operator=(const PersistentList& other) {
+    const Node* oldHead = head_;
+    head_ = acquire(other.head_);
+    size_ = other.size_;
+    release(oldHead);
+    return *this;
+  }
+
+  ~PersistentList() {
+    release(head_);
+  }
+
+  // A list with the same items as the given LinkedList.
+  template <typename Alloc>
+  static PersistentList fromLinkedList(const LinkedList<T, Alloc>& list) {
+    Builder builder;
+    for (const auto* cur = list.getHeadPtr(); cur; cur = cur->next) {
+      builder.append(cur->data);
+    }
+    return builder.finish(nullptr, 0);
+  }
+
+  // A LinkedList with the same items.
+  LinkedList<T> toLinkedList() const {
+    LinkedList<T> result;
+    for (const Node* cur = head_; cur; cur = cur->next) {
+      result.pushBack(cur->data);
+    }
+    return result;
+  }
+
+  const Node* getHeadPtr() const { return head_; }
+
+  int size() const { return size_; }
+
+  bool empty() const { return !head_; }
+
+  const T& front() const {
+    if (!head_) throw std::runtime_error("front() called on empty PersistentList");
+    return head_->data;
+  }
+
+  // A new list with the data item in front of this one's items. The new
+  // list shares all of this list's nodes.
+  PersistentList pushFront(const T& newData) const {
+    return PersistentList(new Node(newData, acquire(head_)), size_ + 1);
+  }
+
+  // A new list without this list's first item, sharing all the other nodes.
+  PersistentList popFront() const {
+    if (!head_) return PersistentList();
+    return PersistentList(acquire(head_->next), size_ - 1);
+  }
+
+  // A new list with the data item after this one's items. All of the nodes
+  // have to be copied, so this is O(n).
+  PersistentList pushBack(const T& newData) const {
+    Builder builder;
+    for (const Node* cur = head_; cur; cur = cur->next) {
+      builder.append(cur->data);
+    }
+    builder.append(newData);
+    return builder.finish(nullptr, 0);
+  }
+
+  bool equals(const PersistentList& other) const {
+    if (size_ != other.size_) return false;
+    const Node* a = head_;
+    const Node* b = other.head_;
+    // Once both lists reach the same node, the rest is shared.
+    while (a != b) {
+      if (!(a->data == b->data)) return false;
+      a = a->next;
+      b = b->next;
+    }
+    return true;
+  }
+  bool operator==(const PersistentList& other) const { return equals(other); }
+  bool operator!=(const PersistentList& other) const { return !equals(other); }
+
+  std::ostream& print(std::ostream& os) const {
+    os << "[";
+    for (const Node* cur = head_; cur; cur = cur->next) {
+      os << "(" << cur->data << ")";
+    }
+    os << "]";
+    return os;
+  }
+
+  // Checks whether the list is sorted in increasing order.
+  bool isSorted() const {
+    if (size_ < 2) return true;
+    for (const Node* cur = head_; cur->next; cur = cur->next) {
+      if (cur->next->data < cur->data) return false;
+    }
+    return true;
+  }
+
+  // Assuming the list is sorted, a new list with the data item in front of
+  // the first item that is greater than it. Only the nodes in front of the
+  // new item are copied; the rest are shared.
+  PersistentList insertOrdered(const T& newData) const {
+    Builder builder;
+    const Node* cur = head_;
+    int copied = 0;
+    while (cur && !(newData < cur->data)) {
+      builder.append(cur->data);
+      cur = cur->next;
+      copied++;
+    }
+    builder.append(newData);
+    return builder.finish(cur, size_ - copied);
+  }
+
+  // Returns a list of two lists, the first and second halves of this one,
+  // with the extra item going into the first half as in
+  // LinkedList::splitHalves. The second half shares its nodes with this list;
+  // only the first half is copied.
+  PersistentList<PersistentList<T>> splitHalves() const {
+    int leftLength = size_ - size_ / 2;
+    Builder builder;
+    const Node* cur = head_;
+    for (int i = 0; i < leftLength; i++) {
+      builder.append(cur->data);
+      cur = cur->next;
+    }
+    PersistentList left = builder.finish(nullptr, 0);
+    PersistentList right(acquire(cur), size_ / 2);
+    return PersistentList<PersistentList<T>>().pushFront(right).pushFront(left);
+  }
+
+  // Returns a list of single-item lists, one for each item in order.
+  PersistentList<PersistentList<T>> explode() const {
+    typename PersistentList<PersistentList<T>>::Builder builder;
+    for (const Node* cur = head_; cur; cur = cur->next) {
+      builder.append(PersistentList().pushFront(cur->data));
+    }
+    return builder.finish(nullptr, 0);
+  }
+
+  // Assuming both lists are sorted, a new sorted list with the items of
+  // both, keeping this list's items first among equal ones. Nodes are copied
+  // only until one list runs out; the rest of the other list is shared.
+  PersistentList merge(const PersistentList& other) const {
+    Builder builder;
+    const Node* left = head_;
+    const Node* right = other.head_;
+    int copied = 0;
+    while (left && right) {
+      if (!(right->data < left->data)) {
+        builder.append(left->data);
+        left = left->next;
+      }
+      else {
+        builder.append(right->data);
+        right = right->next;
+      }
+      copied++;
+    }
+    return builder.finish(left ? left : right, size_ + other.size_ - copied);
+  }
+
+  // A sorted copy of this list, like LinkedList::mergeSort. Runs that are
+  // already in order at the end of a half are shared rather than copied.
+  PersistentList mergeSort() const {
+    return mergeSortRecursive();
+  }
+
+  PersistentList mergeSortRecursive() const {
+    if (size_ < 2) return *this;
+    PersistentList<PersistentList<T>> halves = splitHalves();
+    PersistentList left = halves.front().mergeSortRecursive();
+    PersistentList right = halves.popFront().front().mergeSortRecursive();
+    return left.merge(right);
+  }
+
+  // The same work queue as LinkedList::mergeSortIterative. Moving a list in
+  // and out of the queue costs O(1), since only the head is copied.
+  PersistentList mergeSortIterative() const {
+    if (size_ < 2) return *this;
+    PersistentList<PersistentList<T>> singletons = explode();
+    LinkedList<PersistentList<T>> workQueue;
+    for (const auto* cur = singletons.getHeadPtr(); cur; cur = cur->next) {
+      workQueue.pushBack(cur->data);
+    }
+    while (workQueue.size() > 1) {
+      PersistentList left = workQueue.front();
+      workQueue.popFront();
+      PersistentList right = workQueue.front();
+      workQueue.popFront();
+      workQueue.pushBack(left.merge(right));
+    }
+    return workQueue.front();
+  }
+
+  // The number of lists and nodes that share the first node, or 0 if the
+  // list is empty. This is for testing only.
+  int headUseCount() const {
+    return head_ ? head_->refs_.load(std::memory_order_relaxed) : 0;
+  }
+
+  // Checks whether size_ matches the number of nodes, and otherwise throws
+  // an exception. This is for testing only.
+  bool assertCorrectSize() const {
+    int nodeCount = 0;
+    for (const Node* cur = head_; cur; cur = cur->next) {
+      nodeCount++;
+    }
+    if (nodeCount != size_) throw std::runtime_error(std::string("Error in assertCorrectSize: ") + LIST_GENERAL_BUG_MESSAGE);
+    return true;
+  }
+
+private:
+  template <typename U> friend class PersistentList;
+
+  // Takes over a reference to head that the caller already holds.
+  PersistentList(const Node* head, int size) : head_(head), size_(size) {}
+
+  static const Node* acquire(const Node* node) {
+    if (node) node->refs_.fetch_add(1, std::memory_order_relaxed);
+    return node;
+  }
+
+  // Drop one reference, freeing every node that no one else uses. This is
+  // a loop rather than a recursive destructor, so long lists can't overflow
+  // the stack.
+  static void release(const Node* node) {
+    while (node && node->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      const Node* next = node->next;
+      delete node;
+      node = next;
+    }
+  }
+
+  // Builds a list front to back out of new nodes, then attaches a shared
+  // suffix.
+  class Builder {
+  public:
+    Builder() : head_(nullptr), tail_(nullptr), count_(0) {}
+
+    Builder(const Builder&) = delete;
+    Builder& operator=(const Builder&) = delete;
+
+    // Frees the nodes if finish was never reached, e.g. because copying an
+    // item threw.
+    ~Builder() {
+      release(head_);
+    }
+
+    void append(const T& item) {
+      Node* newNode = new Node(item, nullptr);
+      if (tail_) tail_->next = newNode;
+      else head_ = newNode;
+      tail_ = newNode;
+      count_++;
+    }
+
+    // The appended items followed by suffix, which has suffixSize items and
+    // is shared rather than copied.
+    PersistentList finish(const Node* suffix, int suffixSize) {
+      const Node* head = head_;
+      if (tail_) tail_->next = acquire(suffix);
+      else head = acquire(suffix);
+      head_ = nullptr;
+      tail_ = nullptr;
+      return PersistentList(head, count_ + suffixSize);
+    }
+
+  private:
+    Node* head_;
+    Node* tail_;
+    int count_;
+  };
+
+  const Node* head_;
+  int size_;
+};
+
+template <typename T>
+constexpr char PersistentList<T>::LIST_GENERAL_BUG_MESSAGE[];
+
+template <typename T>
+std::ostream& operator<<(std::ostream& os, const PersistentList<T>& list) {
+  return list.print(os);
+}
@@ -0,0 +1,136 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic
+#include <mutex> // for std::mutex, std::lock_guard
+#include <utility> // for std::declval
+
+#include "LinkedList.h"
+#include "EpochReclamation.h"
+
+// A read-mostly shared LinkedList, in the style of RCU (read-copy-update).
+//
+// The handle points to the current version of the list, which is never
+// modified once it has been published. Readers pin an epoch and traverse
+// that version directly, with no locks and no copies. A writer copies the
+// current version, changes the copy (say, with a batch of insertOrdered
+// calls, or by replacing it with its mergeSort), and swaps it in with one
+// atomic store. The old version is retired through EpochReclamation and
+// freed once every reader that could still see it has finished.
+//
+// Writers are serialized with a mutex and pay an O(n) copy per update, so
+// this only pays off when reads greatly outnumber writes.
+//
+// Usage:
+//
+//   SharedList<int> shared(initialList);
+//
+//   // Reader, on any thread:
+//   {
+//     SharedList<int>::ReadView view(shared);
+//     for (const auto* cur = view->getHeadPtr(); cur; cur = cur->next) { ... }
+//   }
+//
+//   // Writer, on any thread:
+//   shared.update([](LinkedList<int>& list) { list = list.mergeSort(); });
+template <typename T>
+class SharedList {
+public:
+  using ListType = LinkedList<T>;
+
+  // A stable view of the version that was current when the view was made.
+  // The view pins the calling thread's epoch, so it must be destroyed on the
+  // same thread, and should be short-lived: while it exists, nothing retired
+  // by any thread can be freed.
+  class ReadView {
+  public:
+    explicit ReadView(const SharedList& shared)
+      : list_(shared.current_.load(std::memory_order_acquire)) {}
+
+    ReadView(const ReadView&) = delete;
+    ReadView& operator=(const ReadView&) = delete;
+
+    const ListType& operator*() const { return *list_; }
+    const ListType* operator->() const { return list_; }
+
+  private:
+    // Declared first so that the epoch is pinned before list_ is loaded.
+    EpochGuard guard_;
+    const ListType* list_;
+  };
+
+  SharedList() : current_(new ListType()), version_(0) {}
+
+  explicit SharedList(const ListType& initial) : current_(new ListType(initial)), version_(0) {}
+
+  SharedList(const SharedList&) = delete;
+  SharedList& operator=(const SharedList&) = delete;
+
+  // No reader may still hold a view of this list when it is destroyed.
+  ~SharedList() {
+    delete current_.load(std::memory_order_relaxed);
+  }
+
+  // Call reader(list) with the current version, inside a read view, and
+  // return its result.
+  template <typename Reader>
+  auto read(Reader reader) const -> decltype(reader(std::declval<const ListType&>())) {
+    ReadView view(*this);
+    return reader(*view);
+  }
+
+  // Publish a new version made by calling mutator(copy) on a copy of the
+  // current one. Concurrent updates are applied one after the other.
+  template <typename Mutator>
+  void update(Mutator mutator) {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    ListType* next = new ListType(*current_.load(std::memory_order_relaxed));
+    try {
+      mutator(*next);
+    }
+    catch (...) {
+      delete next;
+      throw;
+    }
+    publishLocked(next);
+  }
+
+  // Publish a copy of the given list as the new version.
+  void replace(const ListType& newVersion) {
+    ListType* next = new ListType(newVersion);
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    publishLocked(next);
+  }
+
+  // Insert a batch of items into the sorted list as one new version.
+  template <typename InputIt>
+  void insertOrdered(InputIt first, InputIt last) {
+    update([&](ListType& list) {
+      for (InputIt it = first; it != last; ++it) {
+        list.insertOrdered(*it);
+      }
+    });
+  }
+
+  // The number of versions published since construction.
+  unsigned long version() const { return version_.load(std::memory_order_relaxed); }
+
+private:
+  static void retireVersion(void* list) {
+    delete static_cast<ListType*>(list);
+  }
+
+  void publishLocked(ListType* next) {
+    const ListType* old = current_.exchange(next, std::memory_order_acq_rel);
+    version_.fetch_add(1, std::memory_order_relaxed);
+    EpochReclamation::retire(const_cast<ListType*>(old), &retireVersion);
+    // Versions are big and updates are rare, so don't wait for the retire
+    // count to trigger a collection: each update frees whatever older
+    // versions no reader can still see.
+    EpochReclamation::collect();
+  }
+
+  std::atomic<const ListType*> current_;
+  std::atomic<unsigned long> version_;
+  std::mutex writerMutex_;
+};
@@ -0,0 +1,349 @@
+
+#pragma once
+
+#include <atomic> // for std::atomic
+#include <cerrno> // for errno, EEXIST, EOWNERDEAD
+#include <chrono> // for std::chrono::milliseconds
+#include <cstddef> // for std::size_t, std::max_align_t
+#include <cstdint> // for std::uint64_t
+#include <cstring> // for std::strerror
+#include <new> // for placement new
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::string
+#include <thread> // for std::this_thread::sleep_for
+#include <type_traits> // for std::is_trivially_copyable
+
+#include <fcntl.h> // for O_CREAT, O_EXCL, O_RDWR
+#include <pthread.h> // for pthread_mutex_t and the process-shared attributes
+#include <sys/mman.h> // for shm_open, shm_unlink, mmap, munmap
+#include <sys/stat.h> // for fstat
+#include <unistd.h> // for ftruncate, close
+
+#include "LinkedList.h"
+
+// A list whose nodes live in a POSIX shared memory segment, so that several
+// processes on one machine can share one copy of it (Linux).
+//
+// One process creates the segment with a fixed node capacity; any number of
+// processes then attach to it by name. The segment may be mapped at a
+// different address in each process, so links are stored as byte offsets
+// from the start of the segment rather than as pointers (offset 0 is the
+// header, so it doubles as "null").
+//
+// Writers (pushBack, insertOrdered) are serialized by a process-shared,
+// robust pthread mutex kept in the segment; if a process dies holding it,
+// the next writer recovers it and rebuilds the tail and size from the
+// links. Nodes are never removed, and a new node is
+// completely written before the single atomic store that links it in, so
+// readers (forEach, isSorted, equals, merge, ...) walk the list straight
+// from the mapping without taking the lock. A reader that runs concurrently
+// with writers sees some prefix-consistent version of the list.
+//
+// T must be trivially copyable, since the same bytes are read by every
+// process, and must not contain pointers.
+template <typename T>
+class SharedMemoryList {
+public:
+  static_assert(std::is_trivially_copyable<T>::value, "SharedMemoryList needs a trivially copyable item type");
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "SharedMemoryList needs address-free 64-bit atomics");
+
+  // Create a new segment with room for capacity items. Throws if a segment
+  // of that name already exists.
+  SharedMemoryList(const std::string& name, std::size_t capacity)
+    : name_(name), base_(nullptr), bytes_(segmentBytes(capacity)), owner_(true) {
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) fail("cannot create shared memory segment ");
+    if (::ftruncate(fd, static_cast<off_t>(bytes_)) != 0) {
+      int err = errno;
+      ::close(fd);
+      ::shm_unlink(name.c_str());
+      errno = err;
+      fail("cannot size shared memory segment ");
+    }
+    map(fd);
+    initialize(capacity);
+  }
+
+  // Attach to an existing segment, waiting up to timeout for its creator to
+  // finish setting it up.
+  explicit SharedMemoryList(const std::string& name,
+                            std::chrono::milliseconds timeout = std::chrono::milliseconds(5000))
+    : name_(name), base_(nullptr), bytes_(0), owner_(false) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) fail("cannot open shared memory segment ");
+    // The creator sizes the segment right after creating it.
+    struct stat st;
+    while (true) {
+      if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        fail("cannot stat shared memory segment ");
+      }
+      if (st.st_size != 0 || std::chrono::steady_clock::now() >= deadline) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    bytes_ = static_cast<std::size_t>(st.st_size);
+    if (bytes_ < sizeof(Header)) {
+      ::close(fd);
+      throw std::runtime_error("shared memory segment " + name + " is not a SharedMemoryList");
+    }
+    map(fd);
+    while (header()->ready.load(std::memory_order_acquire) != READY) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        ::munmap(base_, bytes_);
+        throw std::runtime_error("timed out attaching to shared memory segment " + name);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (header()->elementSize != sizeof(T) || header()->segmentBytes != bytes_) {
+      ::munmap(base_, bytes_);
+      throw std::runtime_error("shared memory segment " + name + " holds a different item type");
+    }
+  }
+
+  SharedMemoryList(const SharedMemoryList&) = delete;
+  SharedMemoryList& operator=(const SharedMemoryList&) = delete;
+
+  // Unmaps the segment. The segment itself stays until unlink() is called,
+  // and its memory is freed once no process has it mapped.
+  ~SharedMemoryList() {
+    ::munmap(base_, bytes_);
+  }
+
+  // Remove the segment's name, so no new process can attach.
+  static void unlink(const std::string& name) {
+    ::shm_unlink(name.c_str());
+  }
+
+  // Whether this object created the segment.
+  bool isOwner() const { return owner_; }
+
+  std::size_t size() const { return header()->size.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+  std::size_t capacity() const { return header()->capacity; }
+  std::size_t segmentBytes() const { return bytes_; }
+
+  // Append a copy of the item. Throws std::runtime_error if the segment is
+  // full.
+  void pushBack(const T& newData) {
+    WriterLock lock(this);
+    std::uint64_t newNode = newNodeLocked(newData);
+    std::uint64_t tail = header()->tail;
+    node(newNode)->prev = tail;
+    if (tail) node(tail)->next.store(newNode, std::memory_order_release);
+    else header()->head.store(newNode, std::memory_order_release);
+    header()->tail = newNode;
+    header()->size.fetch_add(1, std::memory_order_release);
+  }
+
+  // Assuming the list is sorted, insert a copy of the item in front of the
+  // first greater item, like LinkedList::insertOrdered.
+  void insertOrdered(const T& newData) {
+    WriterLock lock(this);
+    std::uint64_t newNode = newNodeLocked(newData);
+    std::uint64_t prev = 0;
+    std::uint64_t cur = header()->head.load(std::memory_order_relaxed);
+    while (cur && !(newData < node(cur)->data)) {
+      prev = cur;
+      cur = node(cur)->next.load(std::memory_order_relaxed);
+    }
+    node(newNode)->prev = prev;
+    node(newNode)->next.store(cur, std::memory_order_relaxed);
+    if (cur) node(cur)->prev = newNode;
+    else header()->tail = newNode;
+    // This store makes the fully written node visible to readers.
+    if (prev) node(prev)->next.store(newNode, std::memory_order_release);
+    else header()->head.store(newNode, std::memory_order_release);
+    header()->size.fetch_add(1, std::memory_order_release);
+  }
+
+  // Calls visit(item) for each item from front to back, reading straight
+  // from the mapping.
+  template <typename Visitor>
+  void forEach(Visitor visit) const {
+    for (std::uint64_t cur = header()->head.load(std::memory_order_acquire); cur;
+         cur = node(cur)->next.load(std::memory_order_acquire)) {
+      visit(static_cast<const T&>(node(cur)->data));
+    }
+  }
+
+  const T& front() const {
+    std::uint64_t head = header()->head.load(std::memory_order_acquire);
+    if (!head) throw std::runtime_error("front() called on empty SharedMemoryList");
+    return node(head)->data;
+  }
+
+  // Checks whether the list is sorted in increasing order.
+  bool isSorted() const {
+    bool sorted = true;
+    const T* prev = nullptr;
+    forEach([&](const T& item) {
+      if (prev && item < *prev) sorted = false;
+      prev = &item;
+    });
+    return sorted;
+  }
+
+  // Whether the items are equal to a local list's, in the same order.
+  template <typename Alloc>
+  bool equals(const LinkedList<T, Alloc>& other) const {
+    const auto* otherCur = other.getHeadPtr();
+    std::uint64_t cur = header()->head.load(std::memory_order_acquire);
+    while (cur && otherCur) {
+      if (!(node(cur)->data == otherCur->data)) return false;
+      cur = node(cur)->next.load(std::memory_order_acquire);
+      otherCur = otherCur->next;
+    }
+    return !cur && !otherCur;
+  }
+
+  // A local copy of the list.
+  LinkedList<T> toLinkedList() const {
+    LinkedList<T> result;
+    forEach([&](const T& item) { result.pushBack(item); });
+    return result;
+  }
+
+  // Assuming this list and the local list are both sorted, a new local list
+  // with the items of both, in one pass over the mapping. As in
+  // LinkedList::merge, this list's items come first among equal ones.
+  template <typename Alloc>
+  LinkedList<T, Alloc> merge(const LinkedList<T, Alloc>& local) const {
+    LinkedList<T, Alloc> result(local.allocator());
+    const auto* right = local.getHeadPtr();
+    forEach([&](const T& item) {
+      while (right && right->data < item) {
+        result.pushBack(right->data);
+        right = right->next;
+      }
+      result.pushBack(item);
+    });
+    for (; right; right = right->next) {
+      result.pushBack(right->data);
+    }
+    return result;
+  }
+
+private:
+  // The tests stop a writer partway through, to check the recovery.
+  friend struct SharedMemoryListTesting;
+
+  static constexpr std::uint64_t READY = 0x5348'4D4C'4953'5401ull;
+
+  struct Header {
+    std::atomic<std::uint64_t> ready;
+    std::uint64_t elementSize;
+    std::uint64_t capacity;
+    std::uint64_t segmentBytes;
+    pthread_mutex_t writerMutex;
+    std::atomic<std::uint64_t> head;
+    // The fields below are only used under writerMutex, except size.
+    std::uint64_t tail;
+    std::atomic<std::uint64_t> size;
+    std::uint64_t used;
+  };
+
+  struct Node {
+    std::atomic<std::uint64_t> next;
+    std::uint64_t prev;
+    T data;
+  };
+
+  static constexpr std::size_t roundUp(std::size_t bytes) {
+    return (bytes + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+  }
+
+  static constexpr std::size_t HEADER_BYTES = roundUp(sizeof(Header));
+  static constexpr std::size_t NODE_BYTES = roundUp(sizeof(Node));
+
+  static std::size_t segmentBytes(std::size_t capacity) {
+    return HEADER_BYTES + capacity * NODE_BYTES;
+  }
+
+  // Locks writerMutex, recovering it and the list if its last owner died.
+  class WriterLock {
+  public:
+    explicit WriterLock(SharedMemoryList* list) : mutex_(&list->header()->writerMutex) {
+      int err = ::pthread_mutex_lock(mutex_);
+      if (err == EOWNERDEAD) {
+        // The dead writer may have linked a node in without updating tail
+        // and size, and the next pushBack would link after the stale tail.
+        list->repairLocked();
+        ::pthread_mutex_consistent(mutex_);
+      }
+      else if (err != 0) {
+        throw std::runtime_error("cannot lock SharedMemoryList writer mutex");
+      }
+    }
+    ~WriterLock() { ::pthread_mutex_unlock(mutex_); }
+
+  private:
+    pthread_mutex_t* mutex_;
+  };
+
+  // Rebuilds tail, size and the prev links from the next links, after a
+  // writer died holding the lock. The next links are always consistent: a
+  // node is written completely before the one store that makes it
+  // reachable. A node the dead writer allocated but never linked in stays
+  // unused.
+  void repairLocked() {
+    Header* h = header();
+    std::uint64_t prev = 0;
+    std::uint64_t count = 0;
+    for (std::uint64_t cur = h->head.load(std::memory_order_relaxed); cur;
+         cur = node(cur)->next.load(std::memory_order_relaxed)) {
+      node(cur)->prev = prev;
+      prev = cur;
+      count++;
+    }
+    h->tail = prev;
+    h->size.store(count, std::memory_order_release);
+  }
+
+  [[noreturn]] void fail(const char* what) const {
+    throw std::runtime_error(what + name_ + ": " + std::strerror(errno));
+  }
+
+  void map(int fd) {
+    void* base = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) fail("cannot map shared memory segment ");
+    base_ = static_cast<char*>(base);
+  }
+
+  void initialize(std::size_t capacity) {
+    // The new segment is zero-filled, which is a valid empty state for
+    // everything except the mutex.
+    Header* h = new (base_) Header();
+    h->elementSize = sizeof(T);
+    h->capacity = capacity;
+    h->segmentBytes = bytes_;
+    h->used = 0;
+    pthread_mutexattr_t attr;
+    ::pthread_mutexattr_init(&attr);
+    ::pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    ::pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    ::pthread_mutex_init(&h->writerMutex, &attr);
+    ::pthread_mutexattr_destroy(&attr);
+    h->ready.store(READY, std::memory_order_release);
+  }
+
+  Header* header() const { return reinterpret_cast<Header*>(base_); }
+  Node* node(std::uint64_t offset) const { return reinterpret_cast<Node*>(base_ + offset); }
+
+  std::uint64_t newNodeLocked(const T& newData) {
+    Header* h = header();
+    if (h->used == h->capacity) throw std::runtime_error("SharedMemoryList " + name_ + " is full");
+    std::uint64_t offset = HEADER_BYTES + h->used * NODE_BYTES;
+    h->used++;
+    new (base_ + offset) Node{{0}, 0, newData};
+    return offset;
+  }
+
+  std::string name_;
+  char* base_;
+  std::size_t bytes_;
+  bool owner_;
+};
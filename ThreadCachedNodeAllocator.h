@@ -0,0 +1,237 @@
+
+#pragma once
+
+#include <cstddef> // for std::size_t, std::max_align_t
+#include <mutex> // for std::mutex, std::lock_guard
+#include <new> // for ::operator new
+#include <vector> // for std::vector
+
+// A node allocator policy with per-thread caches and a global depot, after
+// the transfer caches in tcmalloc, but with one size class per node type.
+//
+// Each thread keeps a small free list of nodes for each node size. Frees go
+// to the freeing thread's list; when it grows past two batches, one batch
+// moves to the depot in a single locked operation. Allocations come from the
+// local list, and when that is empty a whole batch is taken from the depot.
+// So when one thread builds lists and another destroys them, the consumer's
+// frees flow back to the producer a batch at a time, and neither thread
+// touches the system allocator's cross-thread free path in the steady state.
+//
+// Storage is obtained in slabs and is kept by the depot for reuse for the
+// life of the process.
+
+// Counters for one node size, summed over all threads.
+struct NodeCacheStats {
+  std::size_t slabsAllocated;
+  std::size_t batchesToDepot;
+  std::size_t batchesFromDepot;
+  std::size_t batchesInDepot;
+};
+
+template <std::size_t NodeBytes>
+class NodeCache {
+public:
+  // Nodes move between threads and the depot in batches of this size.
+  static constexpr std::size_t BATCH_NODES = 64;
+
+  static void* allocate() {
+    if (cacheDestroyed()) return allocateFromDepot();
+    ThreadCache& cache = threadCache();
+    if (!cache.head) {
+      cache.refill();
+    }
+    FreeNode* node = cache.head;
+    cache.head = node->next;
+    cache.count--;
+    return node;
+  }
+
+  static void deallocate(void* ptr) {
+    FreeNode* node = static_cast<FreeNode*>(ptr);
+    if (cacheDestroyed()) {
+      deallocateToDepot(node);
+      return;
+    }
+    ThreadCache& cache = threadCache();
+    node->next = cache.head;
+    cache.head = node;
+    cache.count++;
+    if (cache.count >= 2 * BATCH_NODES) {
+      cache.flushBatch();
+    }
+  }
+
+  static NodeCacheStats stats() {
+    Depot& d = depot();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    NodeCacheStats s;
+    s.slabsAllocated = d.slabsAllocated;
+    s.batchesToDepot = d.batchesIn;
+    s.batchesFromDepot = d.batchesOut;
+    s.batchesInDepot = d.batches.size();
+    return s;
+  }
+
+private:
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  static_assert(NodeBytes >= sizeof(FreeNode), "node too small for the cache free list");
+
+  // Nodes are carved from slabs at this stride, so every node stays
+  // suitably aligned for any type.
+  static constexpr std::size_t STRIDE =
+    (NodeBytes + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+  struct Batch {
+    FreeNode* head;
+    std::size_t count;
+  };
+
+  struct Depot {
+    std::mutex mutex;
+    std::vector<Batch> batches;
+    std::size_t slabsAllocated = 0;
+    std::size_t batchesIn = 0;
+    std::size_t batchesOut = 0;
+  };
+
+  static Depot& depot() {
+    static Depot* d = new Depot();  // Never destroyed: thread caches may outlive static destructors.
+    return *d;
+  }
+
+  struct ThreadCache {
+    FreeNode* head;
+    std::size_t count;
+
+    ThreadCache() : head(nullptr), count(0) {
+      // Make sure the depot exists before this cache can be destroyed.
+      depot();
+    }
+
+    // A thread that exits hands everything it cached to the depot. Lists in
+    // thread_locals destroyed after this go to the depot directly.
+    ~ThreadCache() {
+      while (head) {
+        flushBatch();
+      }
+      cacheDestroyed() = true;
+    }
+
+    // Take one batch from the depot, or carve a new slab if it's empty.
+    void refill() {
+      Depot& d = depot();
+      {
+        std::lock_guard<std::mutex> lock(d.mutex);
+        if (!d.batches.empty()) {
+          Batch batch = d.batches.back();
+          d.batches.pop_back();
+          d.batchesOut++;
+          head = batch.head;
+          count = batch.count;
+          return;
+        }
+        d.slabsAllocated++;
+      }
+
+      char* slab = static_cast<char*>(::operator new(STRIDE * BATCH_NODES));
+      for (std::size_t i = 0; i < BATCH_NODES; i++) {
+        FreeNode* node = reinterpret_cast<FreeNode*>(slab + i * STRIDE);
+        node->next = head;
+        head = node;
+      }
+      count = BATCH_NODES;
+    }
+
+    // Move up to one batch from the local list to the depot.
+    void flushBatch() {
+      Batch batch{head, 0};
+      FreeNode* last = head;
+      std::size_t n = 1;
+      while (n < BATCH_NODES && last->next) {
+        last = last->next;
+        n++;
+      }
+      head = last->next;
+      last->next = nullptr;
+      batch.count = n;
+      count -= n;
+
+      Depot& d = depot();
+      std::lock_guard<std::mutex> lock(d.mutex);
+      d.batches.push_back(batch);
+      d.batchesIn++;
+    }
+  };
+
+  static ThreadCache& threadCache() {
+    static thread_local ThreadCache cache;
+    return cache;
+  }
+
+  // Set once this thread's cache is destroyed at thread exit. A plain bool
+  // has no destructor, so it can still be read after that.
+  static bool& cacheDestroyed() {
+    static thread_local bool destroyed = false;
+    return destroyed;
+  }
+
+  // Allocation and free without the thread's cache, one node at a time
+  // under the depot's lock.
+  static void* allocateFromDepot() {
+    Depot& d = depot();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    if (d.batches.empty()) {
+      d.slabsAllocated++;
+      char* slab = static_cast<char*>(::operator new(STRIDE * BATCH_NODES));
+      Batch batch{nullptr, BATCH_NODES};
+      for (std::size_t i = 0; i < BATCH_NODES; i++) {
+        FreeNode* node = reinterpret_cast<FreeNode*>(slab + i * STRIDE);
+        node->next = batch.head;
+        batch.head = node;
+      }
+      d.batches.push_back(batch);
+    }
+    Batch& batch = d.batches.back();
+    FreeNode* node = batch.head;
+    batch.head = node->next;
+    if (--batch.count == 0) d.batches.pop_back();
+    return node;
+  }
+
+  static void deallocateToDepot(FreeNode* node) {
+    node->next = nullptr;
+    Depot& d = depot();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.batches.push_back(Batch{node, 1});
+    d.batchesIn++;
+  }
+};
+
+// The allocator policy. It has no state of its own, so lists that use it
+// are as cheap to copy as with HeapNodeAllocator, and their nodes can be
+// freed on any thread.
+class ThreadCachedNodeAllocator {
+public:
+  static constexpr bool releasesInBulk = false;
+
+  template <typename NodeT>
+  void* allocate() {
+    static_assert(alignof(NodeT) <= alignof(std::max_align_t), "node alignment not supported by the cache");
+    return NodeCache<sizeof(NodeT)>::allocate();
+  }
+
+  template <typename NodeT>
+  void deallocate(NodeT* node) {
+    NodeCache<sizeof(NodeT)>::deallocate(node);
+  }
+
+  void release() {}
+
+  template <typename NodeT>
+  static NodeCacheStats stats() {
+    return NodeCache<sizeof(NodeT)>::stats();
+  }
+};
@@ -0,0 +1,243 @@
+
+#pragma once
+
+#include <algorithm> // for std::min, std::max, std::swap, std::upper_bound
+#include <cstdint> // for std::uint64_t
+#include <cstdio> // for std::snprintf
+#include <cstring> // for std::memset
+#include <random> // for std::mt19937_64
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::string
+#include <vector> // for std::vector
+
+#include "../LinkedList.h"
+
+// Input generators for the sort benchmarks.
+//
+// Every input is first generated as a sequence of 64-bit keys in one of the
+// shapes below, then turned into list items with BenchValue<T>::fromKey,
+// which keeps the order of the keys. So the same shape, size and seed give
+// the same sequence for every item type, and the sorts see the same
+// comparisons whatever T is.
+//
+// Only std::mt19937_64 and plain arithmetic are used for randomness, never
+// the <random> distributions, whose output differs between standard
+// libraries. A seed gives the same input everywhere.
+
+enum class BenchShape {
+  // Independent keys, uniform over [0, 2^31).
+  Uniform,
+  // 0, 1, 2, ...
+  Sorted,
+  // n-1, n-2, ..., 0
+  Reverse,
+  // Sorted, then param random pairs swapped (default n/100, at least 1).
+  NearlySorted,
+  // param ascending ramps of equal length one after another (default 8).
+  Sawtooth,
+  // 1, 2, ..., n/2, n/2, ..., 2, 1, as in the original week 1 benchmarks.
+  OrganPipe,
+  // Uniform over param distinct values (default 16).
+  FewUnique,
+  // Zipf-distributed with exponent 1 over min(n, 2^20) distinct values,
+  // which are scattered over the key range.
+  Zipfian,
+  // Every key the same.
+  AllEqual,
+  // param sorted runs one after another, with interleaved values: run r
+  // holds r, r+param, r+2*param, ... (default 8).
+  Runs,
+};
+
+inline const std::vector<BenchShape>& allBenchShapes() {
+  static const std::vector<BenchShape> shapes = {
+    BenchShape::Uniform, BenchShape::Sorted, BenchShape::Reverse, BenchShape::NearlySorted,
+    BenchShape::Sawtooth, BenchShape::OrganPipe, BenchShape::FewUnique, BenchShape::Zipfian,
+    BenchShape::AllEqual, BenchShape::Runs,
+  };
+  return shapes;
+}
+
+inline const char* benchShapeName(BenchShape shape) {
+  switch (shape) {
+    case BenchShape::Uniform: return "uniform";
+    case BenchShape::Sorted: return "sorted";
+    case BenchShape::Reverse: return "reverse";
+    case BenchShape::NearlySorted: return "nearly sorted";
+    case BenchShape::Sawtooth: return "sawtooth";
+    case BenchShape::OrganPipe: return "organ pipe";
+    case BenchShape::FewUnique: return "few unique";
+    case BenchShape::Zipfian: return "zipfian";
+    case BenchShape::AllEqual: return "all equal";
+    case BenchShape::Runs: return "runs";
+  }
+  return "";
+}
+
+namespace bench_data_detail {
+
+  constexpr std::uint64_t KEY_RANGE = std::uint64_t(1) << 31;
+
+  // A number in [0, bound), with a bias too small to matter here.
+  inline std::uint64_t below(std::mt19937_64& rng, std::uint64_t bound) {
+    return rng() % bound;
+  }
+
+  // Spreads small ranks over the key range without changing how many
+  // distinct keys there are (the multiplier is odd, so this is a bijection
+  // modulo 2^31).
+  inline std::uint64_t scatter(std::uint64_t rank) {
+    return (rank * 0x9E3779B1u) % KEY_RANGE;
+  }
+
+  // Draws ranks 0..count-1 with probability proportional to 1/(rank+1).
+  class ZipfSampler {
+  public:
+    explicit ZipfSampler(std::size_t count) : cdf_(count) {
+      double sum = 0;
+      for (std::size_t i = 0; i < count; i++) {
+        sum += 1.0 / static_cast<double>(i + 1);
+        cdf_[i] = sum;
+      }
+      for (double& c : cdf_) c /= sum;
+    }
+
+    std::uint64_t operator()(std::mt19937_64& rng) const {
+      double u = static_cast<double>(rng() >> 11) * (1.0 / 9007199254740992.0);
+      std::size_t rank = std::upper_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+      return std::min(rank, cdf_.size() - 1);
+    }
+
+  private:
+    std::vector<double> cdf_;
+  };
+
+}
+
+// The keys of one input. param is the shape's parameter, or 0 for its
+// default (see BenchShape).
+inline std::vector<std::uint64_t> generateBenchKeys(BenchShape shape, long long size, std::uint64_t seed, long long param = 0) {
+  using namespace bench_data_detail;
+  if (size < 0) throw std::runtime_error("generateBenchKeys: negative size");
+  std::size_t n = static_cast<std::size_t>(size);
+  std::vector<std::uint64_t> keys(n);
+  std::mt19937_64 rng(seed);
+
+  switch (shape) {
+    case BenchShape::Uniform:
+      for (auto& key : keys) key = below(rng, KEY_RANGE);
+      break;
+    case BenchShape::Sorted:
+      for (std::size_t i = 0; i < n; i++) keys[i] = i;
+      break;
+    case BenchShape::Reverse:
+      for (std::size_t i = 0; i < n; i++) keys[i] = n - 1 - i;
+      break;
+    case BenchShape::NearlySorted: {
+      for (std::size_t i = 0; i < n; i++) keys[i] = i;
+      long long swaps = param > 0 ? param : std::max<long long>(1, size / 100);
+      for (long long s = 0; s < swaps && n > 1; s++) {
+        std::swap(keys[below(rng, n)], keys[below(rng, n)]);
+      }
+      break;
+    }
+    case BenchShape::Sawtooth: {
+      std::size_t teeth = param > 0 ? static_cast<std::size_t>(param) : 8;
+      std::size_t period = std::max<std::size_t>(1, (n + teeth - 1) / teeth);
+      for (std::size_t i = 0; i < n; i++) keys[i] = i % period;
+      break;
+    }
+    case BenchShape::OrganPipe:
+      for (std::size_t i = 0; i < n; i++) keys[i] = i < n / 2 ? i + 1 : n - i;
+      break;
+    case BenchShape::FewUnique: {
+      std::uint64_t distinct = param > 0 ? static_cast<std::uint64_t>(param) : 16;
+      for (auto& key : keys) key = scatter(below(rng, distinct));
+      break;
+    }
+    case BenchShape::Zipfian: {
+      ZipfSampler sampler(std::max<std::size_t>(1, std::min<std::size_t>(n, std::size_t(1) << 20)));
+      for (auto& key : keys) key = scatter(sampler(rng));
+      break;
+    }
+    case BenchShape::AllEqual:
+      for (auto& key : keys) key = 42;
+      break;
+    case BenchShape::Runs: {
+      std::size_t runs = param > 0 ? static_cast<std::size_t>(param) : 8;
+      std::size_t runLength = std::max<std::size_t>(1, (n + runs - 1) / runs);
+      for (std::size_t i = 0; i < n; i++) keys[i] = (i % runLength) * runs + i / runLength;
+      break;
+    }
+  }
+  return keys;
+}
+
+// A record much wider than its key, for measuring the cost of copying
+// items rather than comparing them.
+struct WideBenchRecord {
+  std::uint64_t key;
+  char payload[56];
+
+  bool operator<(const WideBenchRecord& other) const { return key < other.key; }
+  bool operator<=(const WideBenchRecord& other) const { return key <= other.key; }
+  bool operator==(const WideBenchRecord& other) const { return key == other.key; }
+  bool operator!=(const WideBenchRecord& other) const { return key != other.key; }
+};
+
+// BenchValue<T>::fromKey turns a key into an item, so that a < b between
+// items exactly when a < b between their keys. name() is used in
+// benchmark names.
+template <typename T>
+struct BenchValue;
+
+template <>
+struct BenchValue<int> {
+  static const char* name() { return "int"; }
+  // Keys are below 2^31, so they fit; shifting down centers them on 0.
+  static int fromKey(std::uint64_t key) { return static_cast<int>(static_cast<long long>(key) - (1LL << 30)); }
+};
+
+template <>
+struct BenchValue<std::uint64_t> {
+  static const char* name() { return "uint64"; }
+  static std::uint64_t fromKey(std::uint64_t key) { return key << 32 | (key & 0xFFFFFFFFu); }
+};
+
+template <>
+struct BenchValue<double> {
+  static const char* name() { return "double"; }
+  static double fromKey(std::uint64_t key) { return static_cast<double>(key) * 0.25 - 1e8; }
+};
+
+template <>
+struct BenchValue<std::string> {
+  static const char* name() { return "string"; }
+  // A shared prefix, so that comparisons look past the first bytes, then
+  // the key in zero-padded decimal, so that byte order is key order.
+  static std::string fromKey(std::uint64_t key) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "key-%010llu", static_cast<unsigned long long>(key));
+    return text;
+  }
+};
+
+template <>
+struct BenchValue<WideBenchRecord> {
+  static const char* name() { return "wide record"; }
+  static WideBenchRecord fromKey(std::uint64_t key) {
+    WideBenchRecord record;
+    record.key = key;
+    std::memset(record.payload, static_cast<int>(key & 0x7F), sizeof(record.payload));
+    return record;
+  }
+};
+
+template <typename T>
+LinkedList<T> generateBenchList(BenchShape shape, long long size, std::uint64_t seed, long long param = 0) {
+  LinkedList<T> list;
+  for (std::uint64_t key : generateBenchKeys(shape, size, seed, param)) {
+    list.pushBack(BenchValue<T>::fromKey(key));
+  }
+  return list;
+}
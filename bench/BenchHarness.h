@@ -0,0 +1,316 @@
+
+#pragma once
+
+#include <algorithm> // for std::sort, std::max, std::min
+#include <chrono> // for std::chrono::steady_clock
+#include <cmath> // for std::sqrt, std::ceil
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <functional> // for std::function
+#include <string> // for std::string
+#include <vector> // for std::vector
+
+#include "../CountedItem.h"
+#include "../ListAllocStats.h"
+#include "LatencyHistogram.h"
+#include "PerfCounters.h"
+
+// A small benchmark harness for the list benchmarks in bench/ (see
+// bench_main.cpp for the command line, and "make bench").
+//
+// A benchmark is a function that builds its input for one size and then
+// calls state.run(body) once. run() times body in batches:
+//
+//   1. calibration: the batch size doubles until one batch takes at least
+//      the minimum batch time, which also warms up caches and the heap;
+//   2. warmup: one more full batch that is thrown away (skipped when a
+//      batch takes over a second);
+//   3. samples: repeated batches, each giving one time per iteration.
+//
+// The samples are summarized as min, median, p95, mean and standard
+// deviation. Slow cases (a batch of one iteration longer than the time
+// budget allows) get fewer samples, but never fewer than MIN_SAMPLES.
+//
+// With --perf, the driver also hands run() a set of hardware counters
+// (PerfCounters.h), which count over all the samples and are reported per
+// iteration.
+//
+// In a build with LINKEDLIST_ALLOC_STATS ("make benchmarks-stats"), run()
+// also runs body once more, untimed, inside a ScopedListAllocStats, so that
+// every result says how many nodes and item copies one iteration makes.
+// With --memory, that pass also records a ListMemoryTimeline of the live
+// node bytes, which the driver plots.
+//
+// Register a benchmark at namespace scope:
+//
+//   static BenchRegistration myBench("group/name", BenchSizes(100, 1000000),
+//     [](BenchState& state) {
+//       LinkedList<int> list = makeInput(state.size());
+//       state.setItemsPerIteration(state.size());
+//       state.run([&] { doNotOptimize(list.mergeSort()); });
+//     });
+//
+// Cases that do the same work on different data structures share their name
+// up to the last '/', and the last part names the structure, as in
+// "compare/sort/std::list". When one of them is named ".../LinkedList",
+// the driver reports the throughput of the others relative to it (see
+// baseline_bench.cpp).
+
+// Keeps the compiler from optimizing away the computation of value.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Forces pending writes to memory to be treated as observable.
+inline void clobberMemory() {
+  asm volatile("" : : : "memory");
+}
+
+struct BenchSettings {
+  // Each timed batch runs for at least this long.
+  double minBatchMs = 10;
+  // Samples per case, unless the time budget runs out first.
+  int samples = 15;
+  // Rough time budget for the samples of one case.
+  double maxCaseMs = 10000;
+  // Only sizes in this range are run.
+  long long minSize = 0;
+  long long maxSize = -1;
+  // Record a memory timeline in the allocation counting pass.
+  bool memoryTimeline = false;
+};
+
+struct BenchStats {
+  double minNs = 0;
+  double medianNs = 0;
+  double p95Ns = 0;
+  double meanNs = 0;
+  double stddevNs = 0;
+};
+
+// The result of one benchmark at one size.
+struct BenchResult {
+  std::string name;
+  long long size = 0;
+  long long iterations = 0;
+  long long itemsPerIteration = 0;
+  // Heap bytes per item of the structure under test, or 0 if not measured.
+  double bytesPerItem = 0;
+  // Hardware counter totals per iteration; empty unless counters were on.
+  std::vector<PerfCounterReading> countersPerIteration;
+  // LinkedList allocation counts of one iteration; all zero unless
+  // ListAllocStats::enabled.
+  ListAllocStats allocStats;
+  // Live LinkedList memory over one iteration; empty unless
+  // BenchSettings::memoryTimeline and ListAllocStats::enabled.
+  std::vector<ListMemorySample> memoryTimeline;
+  // Time per iteration of every sample, in nanoseconds.
+  std::vector<double> samplesNs;
+  BenchStats stats;
+};
+
+// Summarizes per-iteration times. p95 is the nearest-rank percentile.
+inline BenchStats summarizeSamples(std::vector<double> samples) {
+  BenchStats stats;
+  if (samples.empty()) return stats;
+  std::sort(samples.begin(), samples.end());
+  std::size_t n = samples.size();
+  stats.minNs = samples.front();
+  stats.medianNs = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+  std::size_t rank = static_cast<std::size_t>(std::ceil(0.95 * n));
+  stats.p95Ns = samples[std::max<std::size_t>(rank, 1) - 1];
+  double sum = 0;
+  for (double s : samples) sum += s;
+  stats.meanNs = sum / n;
+  double squares = 0;
+  for (double s : samples) squares += (s - stats.meanNs) * (s - stats.meanNs);
+  stats.stddevNs = n > 1 ? std::sqrt(squares / (n - 1)) : 0;
+  return stats;
+}
+
+class BenchState {
+public:
+  static constexpr int MIN_SAMPLES = 3;
+
+  BenchState(long long size, const BenchSettings& settings, PerfCounters* counters = nullptr)
+    : size_(size), settings_(settings), counters_(counters) {}
+
+  long long size() const { return size_; }
+
+  // How many items one iteration handles, for the per-item time. Defaults
+  // to 0, meaning per-item times are not reported.
+  void setItemsPerIteration(long long items) { items_ = items; }
+
+  // The memory footprint of the structure under test, for the bytes/item
+  // column. Defaults to 0, meaning not measured.
+  void setBytesPerItem(double bytes) { bytesPerItem_ = bytes; }
+
+  // Times body as described at the top of this file. Call it once.
+  template <typename Body>
+  void run(Body body) {
+    long long iterations = 1;
+    double batchMs = timeBatch(body, iterations);
+    while (batchMs < settings_.minBatchMs && iterations < (1LL << 40)) {
+      // Aim a little past the target so that calibration ends quickly.
+      double scale = batchMs > 0 ? 1.2 * settings_.minBatchMs / batchMs : 10;
+      iterations = std::max(iterations * 2, static_cast<long long>(iterations * std::min(scale, 10.0)));
+      batchMs = timeBatch(body, iterations);
+    }
+    // A batch longer than a second is warm enough after calibration.
+    if (batchMs < 1000) timeBatch(body, iterations);
+
+    int samples = settings_.samples;
+    if (batchMs * samples > settings_.maxCaseMs) {
+      samples = std::max(MIN_SAMPLES, static_cast<int>(settings_.maxCaseMs / batchMs));
+      samples = std::min(samples, settings_.samples);
+    }
+    iterations_ = iterations;
+    samplesNs_.clear();
+    if (counters_) counters_->start();
+    for (int i = 0; i < samples; i++) {
+      samplesNs_.push_back(timeBatch(body, iterations) * 1e6 / iterations);
+    }
+    if (counters_) {
+      counters_->stop();
+      countersPerIteration_ = counters_->read();
+      for (PerfCounterReading& reading : countersPerIteration_) {
+        reading.count /= static_cast<double>(samples) * iterations;
+      }
+    }
+    if (ListAllocStats::enabled && settings_.memoryTimeline) {
+      ScopedListMemoryTimeline record(memoryTimeline_);
+      allocStats_ = measureListAllocs([&] { body(); });
+    }
+    else if (ListAllocStats::enabled) {
+      allocStats_ = measureListAllocs([&] { body(); });
+    }
+  }
+
+  long long iterations() const { return iterations_; }
+  long long itemsPerIteration() const { return items_; }
+  double bytesPerItem() const { return bytesPerItem_; }
+  const std::vector<double>& samplesNs() const { return samplesNs_; }
+  const std::vector<PerfCounterReading>& countersPerIteration() const { return countersPerIteration_; }
+  const ListAllocStats& allocStats() const { return allocStats_; }
+  const ListMemoryTimeline& memoryTimeline() const { return memoryTimeline_; }
+
+private:
+  template <typename Body>
+  double timeBatch(Body& body, long long iterations) {
+    clobberMemory();
+    auto start_time = std::chrono::steady_clock::now();
+    for (long long i = 0; i < iterations; i++) {
+      body();
+    }
+    clobberMemory();
+    std::chrono::duration<double, std::milli> dur_ms = std::chrono::steady_clock::now() - start_time;
+    return dur_ms.count();
+  }
+
+  long long size_;
+  const BenchSettings& settings_;
+  PerfCounters* counters_;
+  long long items_ = 0;
+  double bytesPerItem_ = 0;
+  long long iterations_ = 0;
+  std::vector<double> samplesNs_;
+  std::vector<PerfCounterReading> countersPerIteration_;
+  ListAllocStats allocStats_;
+  ListMemoryTimeline memoryTimeline_;
+};
+
+// The sizes 1e2, 1e3, ... from first to last, multiplying by 10.
+inline std::vector<long long> BenchSizes(long long first, long long last) {
+  std::vector<long long> sizes;
+  for (long long size = first; size <= last; size *= 10) {
+    sizes.push_back(size);
+  }
+  return sizes;
+}
+
+struct BenchDefinition {
+  std::string name;
+  std::vector<long long> sizes;
+  std::function<void(BenchState&)> function;
+};
+
+// Every registered benchmark, in registration order.
+inline std::vector<BenchDefinition>& benchRegistry() {
+  static std::vector<BenchDefinition> registry;
+  return registry;
+}
+
+struct BenchRegistration {
+  BenchRegistration(const std::string& name, const std::vector<long long>& sizes, std::function<void(BenchState&)> function) {
+    benchRegistry().push_back(BenchDefinition{name, sizes, function});
+  }
+};
+
+// Operation counts: instead of timing, an analysis runs an algorithm once
+// on items wrapped in Counted<T> (CountedItem.h) and returns what it did.
+// "benchmarks --counts" runs these instead of the timed benchmarks.
+//
+//   static BenchCountRegistration myCounts("group/name", BenchSizes(100, 100000),
+//     [](long long size) {
+//       LinkedList<Counted<int>> list = makeInput(size);
+//       return measureCountedOps([&] { list.mergeSort(); });
+//     });
+struct BenchCountDefinition {
+  std::string name;
+  std::vector<long long> sizes;
+  std::function<CountedOps(long long size)> function;
+};
+
+inline std::vector<BenchCountDefinition>& benchCountRegistry() {
+  static std::vector<BenchCountDefinition> registry;
+  return registry;
+}
+
+struct BenchCountRegistration {
+  BenchCountRegistration(const std::string& name, const std::vector<long long>& sizes, std::function<CountedOps(long long)> function) {
+    benchCountRegistry().push_back(BenchCountDefinition{name, sizes, function});
+  }
+};
+
+// Latency benchmarks: instead of timing batches, these time every single
+// operation into a LatencyHistogram, for the tail percentiles that a batch
+// average hides. "benchmarks --latency" runs these.
+//
+//   static BenchLatencyRegistration myLatency("pushBack", BenchSizes(1000, 1000000),
+//     [](long long size, LatencyHistogram& histogram) {
+//       LinkedList<int> list;
+//       for (long long i = 0; i < size; i++) {
+//         recordLatency(histogram, [&] { list.pushBack(1); });
+//       }
+//     });
+struct BenchLatencyDefinition {
+  std::string name;
+  std::vector<long long> sizes;
+  std::function<void(long long size, LatencyHistogram& histogram)> function;
+};
+
+inline std::vector<BenchLatencyDefinition>& benchLatencyRegistry() {
+  static std::vector<BenchLatencyDefinition> registry;
+  return registry;
+}
+
+struct BenchLatencyRegistration {
+  BenchLatencyRegistration(const std::string& name, const std::vector<long long>& sizes,
+                           std::function<void(long long, LatencyHistogram&)> function) {
+    benchLatencyRegistry().push_back(BenchLatencyDefinition{name, sizes, function});
+  }
+};
+
+// Times one call of operation and records it in nanoseconds. The two clock
+// reads cost some tens of nanoseconds, which every value includes; the
+// driver measures and prints this overhead.
+template <typename Operation>
+inline void recordLatency(LatencyHistogram& histogram, Operation operation) {
+  clobberMemory();
+  auto start_time = std::chrono::steady_clock::now();
+  operation();
+  clobberMemory();
+  auto end_time = std::chrono::steady_clock::now();
+  histogram.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count()));
+}
@@ -0,0 +1,230 @@
+
+#pragma once
+
+#include <algorithm> // for std::min, std::max
+#include <atomic> // for std::atomic
+#include <cmath> // for std::sqrt
+#include <cstdint> // for std::uint64_t
+#include <cstdio> // for std::FILE, std::fprintf
+#include <memory> // for std::unique_ptr
+#include <mutex> // for std::mutex, std::lock_guard
+#include <vector> // for std::vector
+
+// Latency histograms in the style of HdrHistogram, for recording the time
+// of every single operation and reporting its tail.
+//
+// Values (nanoseconds, but any unit works) go into log-linear buckets:
+// values below 2^SUB_BITS each get their own bucket, and every power of two
+// above that is split into 2^(SUB_BITS-1) equal buckets. So a value is
+// reported at most 1/64th (about 1.6%) above its true value, for any value
+// up to 2^64, in a fixed 30 KB of counts. min and max are kept exactly.
+//
+// A LatencyHistogram has one writer: record() is a plain load and store on
+// relaxed atomics, with no lock prefix, so it is cheap, and another thread
+// may still read or merge it while it is being written (it then sees some
+// recent state). LatencyRecorder gives each thread its own histogram and
+// merges them on demand.
+
+class LatencyHistogram {
+public:
+  static constexpr int SUB_BITS = 7;
+  static constexpr std::uint64_t SUB_COUNT = std::uint64_t(1) << SUB_BITS;
+  static constexpr std::uint64_t HALF_COUNT = SUB_COUNT / 2;
+  // Bucket indexes run up to (64 - SUB_BITS) * HALF_COUNT + SUB_COUNT.
+  static constexpr std::size_t BUCKETS = (64 - SUB_BITS) * HALF_COUNT + SUB_COUNT;
+
+  LatencyHistogram() : counts_(new std::atomic<std::uint64_t>[BUCKETS]) {
+    reset();
+  }
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void record(std::uint64_t value) {
+    bump(counts_[bucketOf(value)], 1);
+    bump(total_, 1);
+    if (value < min_.load(std::memory_order_relaxed)) min_.store(value, std::memory_order_relaxed);
+    if (value > max_.load(std::memory_order_relaxed)) max_.store(value, std::memory_order_relaxed);
+  }
+
+  // Adds other's counts to this one. Only this histogram's writer, or a
+  // thread that owns it while nobody writes, may call this.
+  void merge(const LatencyHistogram& other) {
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+      std::uint64_t count = other.counts_[i].load(std::memory_order_relaxed);
+      if (count) bump(counts_[i], count);
+    }
+    bump(total_, other.count());
+    if (other.count()) {
+      min_.store(std::min(minimum(), other.minimum()), std::memory_order_relaxed);
+      max_.store(std::max(maximum(), other.maximum()), std::memory_order_relaxed);
+    }
+  }
+
+  void reset() {
+    for (std::size_t i = 0; i < BUCKETS; i++) counts_[i].store(0, std::memory_order_relaxed);
+    total_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  std::uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+  std::uint64_t minimum() const { return count() ? min_.load(std::memory_order_relaxed) : 0; }
+  std::uint64_t maximum() const { return max_.load(std::memory_order_relaxed); }
+
+  // Mean and standard deviation, from the bucket midpoints.
+  double mean() const {
+    double sum = 0;
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+      std::uint64_t c = counts_[i].load(std::memory_order_relaxed);
+      sum += static_cast<double>(c) * static_cast<double>(bucketMidpoint(i));
+      total += c;
+    }
+    return total ? sum / static_cast<double>(total) : 0;
+  }
+
+  double stddev() const {
+    double average = mean();
+    double squares = 0;
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+      std::uint64_t c = counts_[i].load(std::memory_order_relaxed);
+      double deviation = static_cast<double>(bucketMidpoint(i)) - average;
+      squares += static_cast<double>(c) * deviation * deviation;
+      total += c;
+    }
+    return total ? std::sqrt(squares / static_cast<double>(total)) : 0;
+  }
+
+  // The smallest recorded value v such that at least the given percentage
+  // of values are <= v, reported as the top of its bucket (but never above
+  // the maximum). 0 when nothing was recorded.
+  std::uint64_t percentile(double percent) const {
+    std::uint64_t total = count();
+    if (total == 0) return 0;
+    double wanted = percent / 100.0 * static_cast<double>(total);
+    std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(wanted + 0.999999));
+    rank = std::min(rank, total);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+      seen += counts_[i].load(std::memory_order_relaxed);
+      if (seen >= rank) return std::min(bucketHighest(i), maximum());
+    }
+    return maximum();
+  }
+
+  // Writes the distribution in the text format of HdrHistogram's
+  // outputPercentileDistribution, one line per non-empty bucket, so that
+  // the usual .hgrm plotters can read it. valueScale divides the values,
+  // e.g. 1000 to write microseconds from nanoseconds.
+  void writePercentiles(std::FILE* out, double valueScale = 1) const {
+    std::fprintf(out, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    std::uint64_t total = count();
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS && total; i++) {
+      std::uint64_t c = counts_[i].load(std::memory_order_relaxed);
+      if (!c) continue;
+      seen += c;
+      double fraction = static_cast<double>(seen) / static_cast<double>(total);
+      double value = static_cast<double>(std::min(bucketHighest(i), maximum())) / valueScale;
+      if (seen < total) {
+        std::fprintf(out, "%12.3f %2.12f %10llu %14.2f\n", value, fraction, static_cast<unsigned long long>(seen),
+                     1 / (1 - fraction));
+      }
+      else {
+        std::fprintf(out, "%12.3f %2.12f %10llu\n", value, fraction, static_cast<unsigned long long>(seen));
+      }
+    }
+    std::fprintf(out, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean() / valueScale, stddev() / valueScale);
+    std::fprintf(out, "#[Max     = %12.3f, Total count    = %12llu]\n", static_cast<double>(maximum()) / valueScale,
+                 static_cast<unsigned long long>(total));
+    std::fprintf(out, "#[Buckets = %12zu, SubBuckets     = %12llu]\n", BUCKETS,
+                 static_cast<unsigned long long>(SUB_COUNT));
+  }
+
+  // Bucket arithmetic, public for the tests.
+  static std::size_t bucketOf(std::uint64_t value) {
+    if (value < SUB_COUNT) return static_cast<std::size_t>(value);
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - (SUB_BITS - 1);
+    return static_cast<std::size_t>(shift * HALF_COUNT + (value >> shift));
+  }
+
+  static std::uint64_t bucketLowest(std::size_t index) {
+    if (index < SUB_COUNT) return index;
+    std::uint64_t shift = index / HALF_COUNT - 1;
+    std::uint64_t top = index - shift * HALF_COUNT;
+    return top << shift;
+  }
+
+  static std::uint64_t bucketHighest(std::size_t index) {
+    if (index < SUB_COUNT) return index;
+    std::uint64_t shift = index / HALF_COUNT - 1;
+    std::uint64_t top = index - shift * HALF_COUNT;
+    return ((top + 1) << shift) - 1;
+  }
+
+private:
+  // Only one thread writes, so a load and a store is enough.
+  static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t by) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+  }
+
+  static std::uint64_t bucketMidpoint(std::size_t index) {
+    return bucketLowest(index) + (bucketHighest(index) - bucketLowest(index)) / 2;
+  }
+
+  std::unique_ptr<std::atomic<std::uint64_t>[]> counts_;
+  std::atomic<std::uint64_t> total_;
+  std::atomic<std::uint64_t> min_;
+  std::atomic<std::uint64_t> max_;
+};
+
+// Hands every thread that records its own LatencyHistogram, so recording
+// never contends. The first record() on a thread takes a lock to register
+// its histogram; after that it is lock-free. snapshot() merges them all.
+class LatencyRecorder {
+public:
+  LatencyRecorder() : id_(nextId()) {}
+
+  LatencyRecorder(const LatencyRecorder&) = delete;
+  LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+  void record(std::uint64_t value) { local().record(value); }
+
+  // The calling thread's histogram.
+  LatencyHistogram& local() {
+    // Recorders are told apart by id rather than address, so that a new
+    // recorder at a dead one's address doesn't pick up its histograms.
+    struct Cached {
+      std::uint64_t id;
+      LatencyHistogram* histogram;
+    };
+    static thread_local std::vector<Cached> cache;
+    for (const Cached& cached : cache) {
+      if (cached.id == id_) return *cached.histogram;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_.emplace_back(new LatencyHistogram());
+    cache.push_back(Cached{id_, threads_.back().get()});
+    return *threads_.back();
+  }
+
+  // All threads' histograms merged into into, which is reset first.
+  void snapshot(LatencyHistogram& into) {
+    into.reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::unique_ptr<LatencyHistogram>& histogram : threads_) into.merge(*histogram);
+  }
+
+private:
+  static std::uint64_t nextId() {
+    static std::atomic<std::uint64_t> next(1);
+    return next.fetch_add(1);
+  }
+
+  std::uint64_t id_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<LatencyHistogram>> threads_;
+};
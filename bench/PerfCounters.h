@@ -0,0 +1,178 @@
+
+#pragma once
+
+#include <cerrno> // for errno
+#include <cstdint> // for std::uint64_t
+#include <cstdio> // for std::FILE, std::fopen, std::fscanf
+#include <cstring> // for std::memset, std::strerror
+#include <string> // for std::string
+#include <vector> // for std::vector
+
+#include <linux/perf_event.h> // for perf_event_attr, PERF_*
+#include <sys/ioctl.h> // for ioctl
+#include <sys/syscall.h> // for SYS_perf_event_open
+#include <unistd.h> // for syscall, read, close
+
+// Hardware performance counters for the benchmarks, through Linux
+// perf_event_open. Each event is opened on its own for this thread, user
+// space only, so that an event the CPU or the kernel doesn't offer (common
+// in virtual machines) only loses that one column. If no event can be
+// opened at all, e.g. because perf_event_paranoid forbids it, available()
+// is false, error() says why, and start(), stop() and read() do nothing.
+//
+//   PerfCounters counters;
+//   counters.start();
+//   ... measured region ...
+//   counters.stop();
+//   for (const PerfCounterReading& r : counters.read()) ...
+//
+// When the kernel has to multiplex more events than the PMU has counters,
+// the counts are scaled up by the fraction of time each event was running.
+
+struct PerfCounterReading {
+  // A short name that is also used as the JSON and CSV key.
+  const char* name;
+  // Whether the event could be opened and ran during the measurement.
+  bool available;
+  double count;
+};
+
+class PerfCounters {
+public:
+  PerfCounters() {
+    std::string failed;
+    std::string reason;
+    for (const EventSpec& spec : eventSpecs()) {
+      Counter counter;
+      counter.name = spec.name;
+      counter.fd = openEvent(spec.type, spec.config);
+      if (counter.fd < 0) {
+        if (failed.empty()) reason = std::strerror(errno);
+        failed += failed.empty() ? spec.name : std::string(", ") + spec.name;
+      }
+      else {
+        opened_++;
+      }
+      counters_.push_back(counter);
+    }
+    if (!failed.empty()) {
+      error_ = failed + ": " + reason;
+      int paranoid = readParanoid();
+      if (opened_ == 0 && paranoid >= 0) error_ += ", perf_event_paranoid is " + std::to_string(paranoid);
+    }
+  }
+
+  ~PerfCounters() {
+    for (Counter& counter : counters_) {
+      if (counter.fd >= 0) ::close(counter.fd);
+    }
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  bool available() const { return opened_ > 0; }
+
+  // Which events could not be opened and why the first one failed, or ""
+  // if all of them were opened.
+  const std::string& error() const { return error_; }
+
+  // Zeroes the counters and starts counting.
+  void start() {
+    for (Counter& counter : counters_) {
+      if (counter.fd < 0) continue;
+      ::ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+      ::ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  void stop() {
+    for (Counter& counter : counters_) {
+      if (counter.fd >= 0) ::ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+
+  // The counts since the last start(), one reading per event in the order
+  // of eventNames().
+  std::vector<PerfCounterReading> read() const {
+    std::vector<PerfCounterReading> readings;
+    for (const Counter& counter : counters_) {
+      PerfCounterReading reading{counter.name, false, 0};
+      // value, time enabled, time running (PERF_FORMAT_TOTAL_TIME_*).
+      std::uint64_t values[3] = {0, 0, 0};
+      if (counter.fd >= 0 && ::read(counter.fd, values, sizeof(values)) == static_cast<ssize_t>(sizeof(values)) && values[2] > 0) {
+        reading.available = true;
+        reading.count = static_cast<double>(values[0]);
+        if (values[2] < values[1]) reading.count *= static_cast<double>(values[1]) / static_cast<double>(values[2]);
+      }
+      readings.push_back(reading);
+    }
+    return readings;
+  }
+
+  // The names of the events, whether or not they are available.
+  static std::vector<const char*> eventNames() {
+    std::vector<const char*> names;
+    for (const EventSpec& spec : eventSpecs()) names.push_back(spec.name);
+    return names;
+  }
+
+private:
+  struct EventSpec {
+    const char* name;
+    std::uint32_t type;
+    std::uint64_t config;
+  };
+
+  struct Counter {
+    const char* name = "";
+    int fd = -1;
+  };
+
+  static constexpr std::uint64_t cacheMisses(std::uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+
+  static const std::vector<EventSpec>& eventSpecs() {
+    static const std::vector<EventSpec> specs = {
+      {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {"l1d_misses", PERF_TYPE_HW_CACHE, cacheMisses(PERF_COUNT_HW_CACHE_L1D)},
+      {"llc_misses", PERF_TYPE_HW_CACHE, cacheMisses(PERF_COUNT_HW_CACHE_LL)},
+      {"dtlb_misses", PERF_TYPE_HW_CACHE, cacheMisses(PERF_COUNT_HW_CACHE_DTLB)},
+      {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+      // A software event, so that there is something to count even where
+      // the hardware counters are hidden; it shows the allocator touching
+      // fresh memory.
+      {"page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    };
+    return specs;
+  }
+
+  static int openEvent(std::uint32_t type, std::uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // This thread, any CPU, no group, no flags.
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  static int readParanoid() {
+    std::FILE* in = std::fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    if (!in) return -1;
+    int value = -1;
+    if (std::fscanf(in, "%d", &value) != 1) value = -1;
+    std::fclose(in);
+    return value;
+  }
+
+  std::vector<Counter> counters_;
+  int opened_ = 0;
+  std::string error_;
+};
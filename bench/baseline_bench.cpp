@@ -0,0 +1,342 @@
+
+// The same operations on LinkedList<int> and on the standard containers,
+// so that the list's numbers have something to be compared with. Every
+// case is registered as "compare/<operation>/<container>", and the driver
+// prints each container's throughput relative to LinkedList at the end of
+// the run:
+//
+//   ./benchmarks --max-size 100000 compare/
+//
+// The "build" cases also measure how many heap bytes each container uses
+// per item, including the allocator's own overhead and any spare capacity.
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+
+static constexpr std::uint64_t SEED = 20240101;
+
+static const std::vector<long long> SIZES = BenchSizes(100, 1000000);
+
+// Bytes currently allocated from the heap, or 0 where glibc cannot say.
+static double heapBytesInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return static_cast<double>(::mallinfo2().uordblks);
+#else
+  return 0;
+#endif
+}
+
+static std::vector<int> uniformInts(long long size) {
+  std::vector<int> items;
+  for (std::uint64_t key : generateBenchKeys(BenchShape::Uniform, size, SEED)) {
+    items.push_back(BenchValue<int>::fromKey(key));
+  }
+  return items;
+}
+
+// LinkedList spells the sequence operations differently from the standard
+// containers; these overloads let one template drive all of them.
+static void pushBack(LinkedList<int>& list, int item) { list.pushBack(item); }
+static void popBack(LinkedList<int>& list) { list.popBack(); }
+static void pushFront(LinkedList<int>& list, int item) { list.pushFront(item); }
+static void popFront(LinkedList<int>& list) { list.popFront(); }
+
+template <typename Container>
+static void pushBack(Container& container, int item) { container.push_back(item); }
+template <typename Container>
+static void popBack(Container& container) { container.pop_back(); }
+template <typename Container>
+static void pushFront(Container& container, int item) { container.push_front(item); }
+template <typename Container>
+static void popFront(Container& container) { container.pop_front(); }
+
+// A vector has no push_front; inserting at the front moves every item.
+template <>
+void pushFront(std::vector<int>& items, int item) { items.insert(items.begin(), item); }
+template <>
+void popFront(std::vector<int>& items) { items.erase(items.begin()); }
+
+static long long sum(const LinkedList<int>& list) {
+  long long total = 0;
+  for (auto cur = list.getHeadPtr(); cur; cur = cur->next) total += cur->data;
+  return total;
+}
+
+template <typename Container>
+static long long sum(const Container& container) {
+  long long total = 0;
+  for (int item : container) total += item;
+  return total;
+}
+
+// The items pushed one at a time onto the back of a new container.
+template <typename Container>
+static Container build(const std::vector<int>& items) {
+  Container container;
+  for (int item : items) pushBack(container, item);
+  return container;
+}
+
+// 0, 2, 4, ... or 1, 3, 5, ...: two sorted halves that interleave when
+// merged.
+static std::vector<int> sortedHalf(long long size, int offset) {
+  std::vector<int> items;
+  for (long long i = 0; i < size / 2; i++) items.push_back(static_cast<int>(2 * i + offset));
+  return items;
+}
+
+static void compare(const std::string& operation, const std::string& container, std::function<void(BenchState&)> function) {
+  BenchRegistration("compare/" + operation + "/" + container, SIZES, function);
+}
+
+// Also records the heap bytes per item of the built container.
+template <typename Container>
+static void registerBuild(const std::string& name) {
+  compare("build", name, [](BenchState& state) {
+    std::vector<int> items = uniformInts(state.size());
+    double before = heapBytesInUse();
+    {
+      Container kept = build<Container>(items);
+      double after = heapBytesInUse();
+      if (before > 0 && after > before) state.setBytesPerItem((after - before) / items.size());
+      doNotOptimize(kept);
+    }
+    state.setItemsPerIteration(state.size());
+    state.run([&] { doNotOptimize(build<Container>(items)); });
+  });
+}
+
+// Each iteration pushes an item and pops it again, so that the container
+// keeps its size.
+template <typename Container>
+static void registerPushPopBack(const std::string& name) {
+  compare("push+pop back", name, [](BenchState& state) {
+    Container container = build<Container>(uniformInts(state.size()));
+    state.run([&] {
+      pushBack(container, 1);
+      doNotOptimize(container);
+      popBack(container);
+    });
+  });
+}
+
+template <typename Container>
+static void registerPushPopFront(const std::string& name) {
+  compare("push+pop front", name, [](BenchState& state) {
+    Container container = build<Container>(uniformInts(state.size()));
+    state.run([&] {
+      pushFront(container, 1);
+      doNotOptimize(container);
+      popFront(container);
+    });
+  });
+}
+
+// Inserting past the end is the LinkedList's worst case, since it walks
+// every node to find the place; std::list does the same walk, while the
+// random-access containers find the place with a binary search. Each
+// iteration removes the item again.
+static void insertOrdered(LinkedList<int>& list, int item) { list.insertOrdered(item); }
+
+static void insertOrdered(std::list<int>& list, int item) {
+  list.insert(std::find_if(list.begin(), list.end(), [item](int other) { return item < other; }), item);
+}
+
+template <typename Container>
+static void insertOrdered(Container& items, int item) {
+  items.insert(std::upper_bound(items.begin(), items.end(), item), item);
+}
+
+template <typename Container>
+static void registerInsertOrdered(const std::string& name) {
+  compare("insertOrdered at end", name, [](BenchState& state) {
+    std::vector<int> items;
+    for (long long i = 0; i < state.size(); i++) items.push_back(static_cast<int>(i));
+    Container container = build<Container>(items);
+    // Not INT_MAX: the compiler would see that nothing compares greater
+    // and drop the search.
+    int last = static_cast<int>(state.size());
+    state.run([&] {
+      insertOrdered(container, last);
+      doNotOptimize(container);
+      popBack(container);
+    });
+  });
+}
+
+template <typename Container>
+static void registerEquality(const std::string& name) {
+  compare("equality", name, [](BenchState& state) {
+    std::vector<int> items = uniformInts(state.size());
+    Container a = build<Container>(items);
+    Container b = build<Container>(items);
+    state.setItemsPerIteration(state.size());
+    state.run([&] { doNotOptimize(a == b); });
+  });
+}
+
+template <typename Container>
+static void registerTraversal(const std::string& name) {
+  compare("traversal", name, [](BenchState& state) {
+    Container container = build<Container>(uniformInts(state.size()));
+    state.setItemsPerIteration(state.size());
+    state.run([&] { doNotOptimize(sum(container)); });
+  });
+}
+
+// LinkedList::merge leaves both inputs alone and returns a new list, so
+// every container here builds a new merged sequence too. std::list::merge
+// splices, so it works on fresh copies of the inputs.
+static void registerMerge() {
+  compare("merge", "LinkedList", [](BenchState& state) {
+    LinkedList<int> left = build<LinkedList<int>>(sortedHalf(state.size(), 0));
+    LinkedList<int> right = build<LinkedList<int>>(sortedHalf(state.size(), 1));
+    state.setItemsPerIteration(left.size() + right.size());
+    state.run([&] { doNotOptimize(left.merge(right)); });
+  });
+  compare("merge", "std::list", [](BenchState& state) {
+    std::list<int> left = build<std::list<int>>(sortedHalf(state.size(), 0));
+    std::list<int> right = build<std::list<int>>(sortedHalf(state.size(), 1));
+    state.setItemsPerIteration(left.size() + right.size());
+    state.run([&] {
+      std::list<int> merged = left;
+      std::list<int> other = right;
+      merged.merge(other);
+      doNotOptimize(merged);
+    });
+  });
+  compare("merge", "std::vector std::merge", [](BenchState& state) {
+    std::vector<int> left = sortedHalf(state.size(), 0);
+    std::vector<int> right = sortedHalf(state.size(), 1);
+    state.setItemsPerIteration(left.size() + right.size());
+    state.run([&] {
+      std::vector<int> merged(left.size() + right.size());
+      std::merge(left.begin(), left.end(), right.begin(), right.end(), merged.begin());
+      doNotOptimize(merged);
+    });
+  });
+  compare("merge", "std::vector inplace_merge", [](BenchState& state) {
+    std::vector<int> left = sortedHalf(state.size(), 0);
+    std::vector<int> right = sortedHalf(state.size(), 1);
+    state.setItemsPerIteration(left.size() + right.size());
+    state.run([&] {
+      std::vector<int> merged(left);
+      merged.insert(merged.end(), right.begin(), right.end());
+      std::inplace_merge(merged.begin(), merged.begin() + left.size(), merged.end());
+      doNotOptimize(merged);
+    });
+  });
+  compare("merge", "std::deque", [](BenchState& state) {
+    std::deque<int> left = build<std::deque<int>>(sortedHalf(state.size(), 0));
+    std::deque<int> right = build<std::deque<int>>(sortedHalf(state.size(), 1));
+    state.setItemsPerIteration(left.size() + right.size());
+    state.run([&] {
+      std::deque<int> merged;
+      std::merge(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(merged));
+      doNotOptimize(merged);
+    });
+  });
+}
+
+// The LinkedList sorts return a sorted copy, so the other containers copy
+// their input before sorting it in place.
+static void registerSort() {
+  compare("sort", "LinkedList", [](BenchState& state) {
+    LinkedList<int> list = build<LinkedList<int>>(uniformInts(state.size()));
+    state.setItemsPerIteration(state.size());
+    state.run([&] { doNotOptimize(list.mergeSort()); });
+  });
+  compare("sort", "LinkedList iterative", [](BenchState& state) {
+    LinkedList<int> list = build<LinkedList<int>>(uniformInts(state.size()));
+    state.setItemsPerIteration(state.size());
+    state.run([&] { doNotOptimize(list.mergeSortIterative()); });
+  });
+  compare("sort", "std::list", [](BenchState& state) {
+    std::list<int> list = build<std::list<int>>(uniformInts(state.size()));
+    state.setItemsPerIteration(state.size());
+    state.run([&] {
+      std::list<int> sorted = list;
+      sorted.sort();
+      doNotOptimize(sorted);
+    });
+  });
+  compare("sort", "std::vector std::sort", [](BenchState& state) {
+    std::vector<int> items = uniformInts(state.size());
+    state.setItemsPerIteration(state.size());
+    state.run([&] {
+      std::vector<int> sorted = items;
+      std::sort(sorted.begin(), sorted.end());
+      doNotOptimize(sorted);
+    });
+  });
+  compare("sort", "std::vector stable_sort", [](BenchState& state) {
+    std::vector<int> items = uniformInts(state.size());
+    state.setItemsPerIteration(state.size());
+    state.run([&] {
+      std::vector<int> sorted = items;
+      std::stable_sort(sorted.begin(), sorted.end());
+      doNotOptimize(sorted);
+    });
+  });
+  compare("sort", "std::deque", [](BenchState& state) {
+    std::deque<int> items = build<std::deque<int>>(uniformInts(state.size()));
+    state.setItemsPerIteration(state.size());
+    state.run([&] {
+      std::deque<int> sorted = items;
+      std::sort(sorted.begin(), sorted.end());
+      doNotOptimize(sorted);
+    });
+  });
+}
+
+// The LinkedList case of each operation is registered first, so that it
+// heads its group in the output.
+static bool registered = [] {
+  registerBuild<LinkedList<int>>("LinkedList");
+  registerBuild<std::list<int>>("std::list");
+  registerBuild<std::vector<int>>("std::vector");
+  registerBuild<std::deque<int>>("std::deque");
+
+  registerPushPopBack<LinkedList<int>>("LinkedList");
+  registerPushPopBack<std::list<int>>("std::list");
+  registerPushPopBack<std::vector<int>>("std::vector");
+  registerPushPopBack<std::deque<int>>("std::deque");
+
+  registerPushPopFront<LinkedList<int>>("LinkedList");
+  registerPushPopFront<std::list<int>>("std::list");
+  registerPushPopFront<std::vector<int>>("std::vector");
+  registerPushPopFront<std::deque<int>>("std::deque");
+
+  registerInsertOrdered<LinkedList<int>>("LinkedList");
+  registerInsertOrdered<std::list<int>>("std::list");
+  registerInsertOrdered<std::vector<int>>("std::vector");
+  registerInsertOrdered<std::deque<int>>("std::deque");
+
+  registerMerge();
+  registerSort();
+
+  registerEquality<LinkedList<int>>("LinkedList");
+  registerEquality<std::list<int>>("std::list");
+  registerEquality<std::vector<int>>("std::vector");
+  registerEquality<std::deque<int>>("std::deque");
+
+  registerTraversal<LinkedList<int>>("LinkedList");
+  registerTraversal<std::list<int>>("std::list");
+  registerTraversal<std::vector<int>>("std::vector");
+  registerTraversal<std::deque<int>>("std::deque");
+  return true;
+}();
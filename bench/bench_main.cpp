@@ -0,0 +1,617 @@
+/**
+ * @file bench_main.cpp
+ * The driver for the benchmarks registered by the sources in bench/.
+ *
+ * Build and run with "make bench" (arguments go in BENCH_ARGS), or build
+ * with "make benchmarks" and run ./benchmarks --help for the options.
+**/
+
+#include <algorithm> // for std::max
+#include <cctype> // for std::isalnum
+#include <cmath> // for std::log2
+#include <cstdint> // for std::int64_t
+#include <cstdio> // for std::FILE, std::fopen, std::fprintf, std::printf
+#include <cstdlib> // for std::atoi, std::atoll, std::atof, std::exit
+#include <ctime> // for std::time, std::strftime
+#include <memory> // for std::unique_ptr
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::string
+#include <vector> // for std::vector
+
+#include <sched.h> // for sched_setaffinity, sched_getcpu
+#include <unistd.h> // for sysconf
+
+#include "../ListTrace.h"
+#include "BenchHarness.h"
+
+struct BenchOptions {
+  BenchSettings settings;
+  std::vector<std::string> filters;
+  // -1 pins to the CPU we start on; -2 disables pinning.
+  int cpu = -1;
+  std::string jsonPath;
+  std::string csvPath;
+  bool listOnly = false;
+  bool perf = false;
+  bool counts = false;
+  bool latency = false;
+  std::string histogramDir;
+  std::string tracePath;
+  long long traceMinSize = -1;
+};
+
+static void usage(std::FILE* out) {
+  std::fprintf(out,
+    "Usage: benchmarks [options] [filter...]\n"
+    "Runs the registered benchmarks whose names contain any filter.\n"
+    "\n"
+    "  --min-size N      skip sizes below N\n"
+    "  --max-size N      skip sizes above N\n"
+    "  --samples N       samples per case (default 15)\n"
+    "  --min-batch-ms X  minimum time of one timed batch (default 10)\n"
+    "  --max-case-ms X   time budget for the samples of one case (default 10000)\n"
+    "  --cpu N           pin to CPU N (default: the CPU we start on)\n"
+    "  --no-pin          don't pin to a CPU\n"
+    "  --json FILE       also write the results as JSON\n"
+    "  --csv FILE        also write the results as CSV\n"
+    "  --perf            also count cycles, instructions, cache, TLB and branch\n"
+    "                    misses and page faults with perf_event_open, where allowed\n"
+    "  --counts          instead of timing, count the comparisons, copies and moves\n"
+    "                    of the algorithms on counted items\n"
+    "  --latency         instead of timing batches, time every single operation and\n"
+    "                    report latency percentiles\n"
+    "  --hgrm DIR        with --latency, also write each histogram to DIR as a\n"
+    "                    HdrHistogram percentile file (values in nanoseconds)\n"
+    "  --memory          plot the live LinkedList memory over one iteration of each\n"
+    "                    benchmark and list the peaks (needs a build with\n"
+    "                    LINKEDLIST_ALLOC_STATS, such as benchmarks-stats)\n"
+    "  --trace FILE      write a Chrome trace-event timeline of the sort and merge\n"
+    "                    phases to FILE (needs a build with LINKEDLIST_TRACE, such\n"
+    "                    as benchmarks-stats; only the last events of each thread\n"
+    "                    are kept, so filter down to the case of interest)\n"
+    "  --trace-min-size N\n"
+    "                    with --trace, leave out phases on lists of fewer than N\n"
+    "                    items (default 1024)\n"
+    "  --list            list the benchmarks and their sizes (with --counts or\n"
+    "                    --latency, the ones of that mode)\n");
+}
+
+static BenchOptions parseArguments(int argc, char* argv[]) {
+  BenchOptions options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&]() -> const char* {
+      if (i + 1 >= argc) throw std::runtime_error(arg + " needs a value");
+      return argv[++i];
+    };
+    if (arg == "--min-size") options.settings.minSize = std::atoll(value());
+    else if (arg == "--max-size") options.settings.maxSize = std::atoll(value());
+    else if (arg == "--samples") options.settings.samples = std::max(1, std::atoi(value()));
+    else if (arg == "--min-batch-ms") options.settings.minBatchMs = std::atof(value());
+    else if (arg == "--max-case-ms") options.settings.maxCaseMs = std::atof(value());
+    else if (arg == "--cpu") options.cpu = std::atoi(value());
+    else if (arg == "--no-pin") options.cpu = -2;
+    else if (arg == "--json") options.jsonPath = value();
+    else if (arg == "--csv") options.csvPath = value();
+    else if (arg == "--list") options.listOnly = true;
+    else if (arg == "--perf") options.perf = true;
+    else if (arg == "--counts") options.counts = true;
+    else if (arg == "--latency") options.latency = true;
+    else if (arg == "--hgrm") options.histogramDir = value();
+    else if (arg == "--memory") options.settings.memoryTimeline = true;
+    else if (arg == "--trace") options.tracePath = value();
+    else if (arg == "--trace-min-size") options.traceMinSize = std::atoll(value());
+    else if (arg == "--help" || arg == "-h") {
+      usage(stdout);
+      std::exit(0);
+    }
+    else if (!arg.empty() && arg[0] == '-') throw std::runtime_error("unknown option " + arg);
+    else options.filters.push_back(arg);
+  }
+  return options;
+}
+
+static bool matchesFilters(const std::string& name, const std::vector<std::string>& filters) {
+  if (filters.empty()) return true;
+  for (const std::string& filter : filters) {
+    if (name.find(filter) != std::string::npos) return true;
+  }
+  return false;
+}
+
+// Pins this thread to one CPU, so that samples are not spread over cores
+// with different cache contents. Returns the CPU, or -1 if not pinned.
+static int pinToCpu(int cpu) {
+  if (cpu == -2) return -1;
+  if (cpu == -1) cpu = ::sched_getcpu();
+  if (cpu < 0) return -1;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (::sched_setaffinity(0, sizeof(set), &set) != 0) {
+    std::fprintf(stderr, "warning: could not pin to CPU %d; running unpinned\n", cpu);
+    return -1;
+  }
+  return cpu;
+}
+
+// Formats nanoseconds with a unit that keeps 3-4 significant digits.
+static std::string formatTime(double ns) {
+  char text[32];
+  if (ns < 1e3) std::snprintf(text, sizeof(text), "%.1f ns", ns);
+  else if (ns < 1e6) std::snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+  else if (ns < 1e9) std::snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+  else std::snprintf(text, sizeof(text), "%.3f s", ns / 1e9);
+  return text;
+}
+
+static std::string formatBytes(double bytes) {
+  char text[32];
+  std::snprintf(text, sizeof(text), "%.1f", bytes);
+  return text;
+}
+
+// Formats a memory size with a binary unit.
+static std::string formatMemory(double bytes) {
+  char text[32];
+  if (bytes < 1024) std::snprintf(text, sizeof(text), "%.0f B", bytes);
+  else if (bytes < 1024.0 * 1024) std::snprintf(text, sizeof(text), "%.1f KiB", bytes / 1024);
+  else if (bytes < 1024.0 * 1024 * 1024) std::snprintf(text, sizeof(text), "%.1f MiB", bytes / (1024.0 * 1024));
+  else std::snprintf(text, sizeof(text), "%.2f GiB", bytes / (1024.0 * 1024 * 1024));
+  return text;
+}
+
+// One line of hardware counter rates under a result, per item when the
+// benchmark says how many items an iteration handles. Events that are not
+// available are left out.
+static void printCounters(const BenchResult& result) {
+  if (result.countersPerIteration.empty()) return;
+  double items = result.itemsPerIteration > 0 ? result.itemsPerIteration : 1;
+  std::string line = result.itemsPerIteration > 0 ? "  per item:" : "  per iteration:";
+  double cycles = 0;
+  double instructions = 0;
+  bool any = false;
+  for (const PerfCounterReading& reading : result.countersPerIteration) {
+    if (!reading.available) continue;
+    char text[64];
+    std::snprintf(text, sizeof(text), " %s %.3g", reading.name, reading.count / items);
+    line += text;
+    any = true;
+    if (std::string(reading.name) == "cycles") cycles = reading.count;
+    if (std::string(reading.name) == "instructions") instructions = reading.count;
+  }
+  if (cycles > 0 && instructions > 0) {
+    char text[32];
+    std::snprintf(text, sizeof(text), " (IPC %.2f)", instructions / cycles);
+    line += text;
+  }
+  if (any) std::printf("%s\n", line.c_str());
+}
+
+// One line of LinkedList allocation counts for one iteration under a
+// result, in builds that have them.
+static void printAllocStats(const BenchResult& result) {
+  if (!ListAllocStats::enabled) return;
+  const ListAllocStats& a = result.allocStats;
+  std::printf("  per iteration: %llu node allocs (%llu bytes), %llu frees, %llu item copies, %llu assignments, "
+              "peak %llu live nodes (%s)\n",
+              static_cast<unsigned long long>(a.nodeAllocations), static_cast<unsigned long long>(a.bytesAllocated),
+              static_cast<unsigned long long>(a.nodeFrees), static_cast<unsigned long long>(a.itemCopies),
+              static_cast<unsigned long long>(a.itemAssignments), static_cast<unsigned long long>(a.peakLiveNodes),
+              formatMemory(static_cast<double>(a.peakLiveBytes)).c_str());
+}
+
+// A plot of the live LinkedList bytes over one iteration, under a result,
+// with --memory. Each column is the highest sample in its slice of time,
+// and each row an eighth of the peak.
+static void printMemoryPlot(const BenchResult& result) {
+  const std::vector<ListMemorySample>& samples = result.memoryTimeline;
+  if (samples.size() < 2) return;
+  const int columns = 64;
+  const int rows = 8;
+  double duration = samples.back().timeMs;
+  // The exact peak, which thinned samples may have missed.
+  std::int64_t peak = std::max<std::int64_t>(1, static_cast<std::int64_t>(result.allocStats.peakLiveBytes));
+  for (const ListMemorySample& sample : samples) peak = std::max(peak, sample.liveBytes);
+
+  std::vector<std::int64_t> heights(columns, -1);
+  for (const ListMemorySample& sample : samples) {
+    int column = duration > 0 ? static_cast<int>(sample.timeMs / duration * (columns - 1)) : 0;
+    heights[column] = std::max(heights[column], sample.liveBytes);
+  }
+  // Slices without a sample keep the level of the one before.
+  for (int c = 1; c < columns; c++) {
+    if (heights[c] < 0) heights[c] = heights[c - 1];
+  }
+
+  std::printf("  live LinkedList memory over one iteration (%s):\n", formatTime(duration * 1e6).c_str());
+  for (int row = rows; row >= 1; row--) {
+    double level = static_cast<double>(peak) * (row - 0.5) / rows;
+    std::string label = row == rows ? formatMemory(static_cast<double>(peak)) : "";
+    std::string line;
+    for (int c = 0; c < columns; c++) line += static_cast<double>(heights[c]) >= level ? '#' : ' ';
+    std::printf("  %10s |%s\n", label.c_str(), line.c_str());
+  }
+  std::printf("  %10s +%s\n", "0", std::string(columns, '-').c_str());
+}
+
+// The peaks of every result, with --memory, so the variants of an
+// algorithm can be compared at a glance.
+static void printMemoryPeaks(const std::vector<BenchResult>& results) {
+  std::printf("\nPeak live LinkedList memory per iteration:\n");
+  std::printf("%-40s %10s %12s %12s %12s\n", "benchmark", "size", "peak nodes", "peak memory", "bytes/item");
+  for (const BenchResult& r : results) {
+    const ListAllocStats& a = r.allocStats;
+    double perItem = r.size > 0 ? static_cast<double>(a.peakLiveBytes) / static_cast<double>(r.size) : 0;
+    std::printf("%-40s %10lld %12llu %12s %12s\n", r.name.c_str(), r.size,
+                static_cast<unsigned long long>(a.peakLiveNodes), formatMemory(static_cast<double>(a.peakLiveBytes)).c_str(),
+                formatBytes(perItem).c_str());
+  }
+  std::fflush(stdout);
+}
+
+// The part of a name before its last '/', and the part after it.
+static std::string groupOf(const std::string& name) {
+  std::size_t slash = name.rfind('/');
+  return slash == std::string::npos ? "" : name.substr(0, slash);
+}
+
+static std::string memberOf(const std::string& name) {
+  return name.substr(name.rfind('/') + 1);
+}
+
+// For every group of cases with a ".../LinkedList" member (see
+// BenchHarness.h), prints each member's throughput at each size as a
+// multiple of the LinkedList's: 2.00x means twice as many items per second.
+static void printRelativeThroughput(const std::vector<BenchResult>& results) {
+  bool printedHeader = false;
+  for (const BenchResult& reference : results) {
+    if (memberOf(reference.name) != "LinkedList" || groupOf(reference.name).empty()) continue;
+    std::string group = groupOf(reference.name);
+    if (!printedHeader) {
+      std::printf("\nThroughput relative to LinkedList (higher is faster):\n");
+      std::printf("%-40s %10s %10s %10s\n", "benchmark", "size", "relative", "bytes/item");
+      printedHeader = true;
+    }
+    for (const BenchResult& r : results) {
+      if (r.size != reference.size || groupOf(r.name) != group || r.stats.medianNs <= 0) continue;
+      double items = r.itemsPerIteration > 0 ? r.itemsPerIteration : 1;
+      double referenceItems = reference.itemsPerIteration > 0 ? reference.itemsPerIteration : 1;
+      double relative = (items / r.stats.medianNs) / (referenceItems / reference.stats.medianNs);
+      std::string bytes = r.bytesPerItem > 0 ? formatBytes(r.bytesPerItem) : "";
+      std::printf("%-40s %10lld %9.2fx %10s\n", r.name.c_str(), r.size, relative, bytes.c_str());
+    }
+  }
+  std::fflush(stdout);
+}
+
+static std::string jsonEscape(const std::string& text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\') escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+static void writeJson(const std::string& path, const std::vector<BenchResult>& results, int cpu) {
+  std::FILE* out = std::fopen(path.c_str(), "w");
+  if (!out) throw std::runtime_error("cannot create " + path);
+  char date[64];
+  std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+  std::fprintf(out, "{\n  \"context\": {\n");
+  std::fprintf(out, "    \"date\": \"%s\",\n", date);
+  std::fprintf(out, "    \"cpus\": %ld,\n", ::sysconf(_SC_NPROCESSORS_ONLN));
+  std::fprintf(out, "    \"pinned_cpu\": %d,\n", cpu);
+  std::fprintf(out, "    \"compiler\": \"%s\",\n", jsonEscape(__VERSION__).c_str());
+  std::fprintf(out, "    \"alloc_stats\": %s\n", ListAllocStats::enabled ? "true" : "false");
+  std::fprintf(out, "  },\n  \"benchmarks\": [");
+  for (std::size_t i = 0; i < results.size(); i++) {
+    const BenchResult& r = results[i];
+    std::fprintf(out, "%s\n    {\"name\": \"%s\", \"size\": %lld, \"iterations\": %lld, \"items_per_iteration\": %lld,",
+                 i ? "," : "", jsonEscape(r.name).c_str(), r.size, r.iterations, r.itemsPerIteration);
+    if (r.bytesPerItem > 0) std::fprintf(out, " \"bytes_per_item\": %.2f,", r.bytesPerItem);
+    if (!r.countersPerIteration.empty()) {
+      std::fprintf(out, " \"counters_per_iteration\": {");
+      bool first = true;
+      for (const PerfCounterReading& reading : r.countersPerIteration) {
+        if (!reading.available) continue;
+        std::fprintf(out, "%s\"%s\": %.3f", first ? "" : ", ", reading.name, reading.count);
+        first = false;
+      }
+      std::fprintf(out, "},");
+    }
+    if (ListAllocStats::enabled) {
+      const ListAllocStats& a = r.allocStats;
+      std::fprintf(out, " \"alloc_stats\": {\"node_allocations\": %llu, \"node_frees\": %llu, \"bytes_allocated\": %llu,"
+                   " \"bytes_freed\": %llu, \"item_copies\": %llu, \"item_assignments\": %llu, \"peak_live_nodes\": %llu,"
+                   " \"peak_live_bytes\": %llu},",
+                   static_cast<unsigned long long>(a.nodeAllocations), static_cast<unsigned long long>(a.nodeFrees),
+                   static_cast<unsigned long long>(a.bytesAllocated), static_cast<unsigned long long>(a.bytesFreed),
+                   static_cast<unsigned long long>(a.itemCopies), static_cast<unsigned long long>(a.itemAssignments),
+                   static_cast<unsigned long long>(a.peakLiveNodes), static_cast<unsigned long long>(a.peakLiveBytes));
+    }
+    if (!r.memoryTimeline.empty()) {
+      // [milliseconds, live nodes, live bytes] triples.
+      std::fprintf(out, " \"memory_timeline\": [");
+      for (std::size_t s = 0; s < r.memoryTimeline.size(); s++) {
+        const ListMemorySample& sample = r.memoryTimeline[s];
+        std::fprintf(out, "%s[%.4f, %lld, %lld]", s ? ", " : "", sample.timeMs, static_cast<long long>(sample.liveNodes),
+                     static_cast<long long>(sample.liveBytes));
+      }
+      std::fprintf(out, "],");
+    }
+    std::fprintf(out, " \"min_ns\": %.3f, \"median_ns\": %.3f, \"p95_ns\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f,",
+                 r.stats.minNs, r.stats.medianNs, r.stats.p95Ns, r.stats.meanNs, r.stats.stddevNs);
+    std::fprintf(out, " \"samples_ns\": [");
+    for (std::size_t s = 0; s < r.samplesNs.size(); s++) {
+      std::fprintf(out, "%s%.3f", s ? ", " : "", r.samplesNs[s]);
+    }
+    std::fprintf(out, "]}");
+  }
+  std::fprintf(out, "\n  ]\n}\n");
+  std::fclose(out);
+}
+
+static void writeCsv(const std::string& path, const std::vector<BenchResult>& results) {
+  std::FILE* out = std::fopen(path.c_str(), "w");
+  if (!out) throw std::runtime_error("cannot create " + path);
+  std::fprintf(out, "name,size,iterations,samples,items_per_iteration,min_ns,median_ns,p95_ns,mean_ns,stddev_ns,bytes_per_item");
+  // One column per counter, per iteration, left empty where not measured.
+  std::vector<const char*> counterNames = PerfCounters::eventNames();
+  for (const char* name : counterNames) std::fprintf(out, ",%s", name);
+  if (ListAllocStats::enabled) {
+    std::fprintf(out, ",node_allocations,node_frees,bytes_allocated,bytes_freed,item_copies,item_assignments,peak_live_nodes,peak_live_bytes");
+  }
+  std::fprintf(out, "\n");
+  for (const BenchResult& r : results) {
+    std::fprintf(out, "\"%s\",%lld,%lld,%zu,%lld,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f", r.name.c_str(), r.size, r.iterations,
+                 r.samplesNs.size(), r.itemsPerIteration, r.stats.minNs, r.stats.medianNs, r.stats.p95Ns,
+                 r.stats.meanNs, r.stats.stddevNs, r.bytesPerItem);
+    for (std::size_t c = 0; c < counterNames.size(); c++) {
+      if (c < r.countersPerIteration.size() && r.countersPerIteration[c].available) {
+        std::fprintf(out, ",%.3f", r.countersPerIteration[c].count);
+      }
+      else {
+        std::fprintf(out, ",");
+      }
+    }
+    if (ListAllocStats::enabled) {
+      const ListAllocStats& a = r.allocStats;
+      std::fprintf(out, ",%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu", static_cast<unsigned long long>(a.nodeAllocations),
+                   static_cast<unsigned long long>(a.nodeFrees), static_cast<unsigned long long>(a.bytesAllocated),
+                   static_cast<unsigned long long>(a.bytesFreed), static_cast<unsigned long long>(a.itemCopies),
+                   static_cast<unsigned long long>(a.itemAssignments), static_cast<unsigned long long>(a.peakLiveNodes),
+                   static_cast<unsigned long long>(a.peakLiveBytes));
+    }
+    std::fprintf(out, "\n");
+  }
+  std::fclose(out);
+}
+
+// The --counts mode. Comparisons are shown per n log2 n, the comparison
+// count of an ideal sort, and the rest per item.
+static void runCounts(const BenchOptions& options) {
+  const BenchSettings& settings = options.settings;
+  struct CountResult {
+    std::string name;
+    long long size;
+    CountedOps ops;
+  };
+  std::vector<CountResult> results;
+
+  std::printf("%-40s %10s %14s %12s %10s %10s %10s\n", "analysis", "size", "comparisons", "cmp/n lg n",
+              "copies/n", "moves/n", "assigns/n");
+  for (const BenchCountDefinition& analysis : benchCountRegistry()) {
+    if (!matchesFilters(analysis.name, options.filters)) continue;
+    for (long long size : analysis.sizes) {
+      if (size < settings.minSize || (settings.maxSize >= 0 && size > settings.maxSize)) continue;
+      CountedOps ops = analysis.function(size);
+      results.push_back(CountResult{analysis.name, size, ops});
+      double n = static_cast<double>(size);
+      double nLogN = size > 1 ? n * std::log2(n) : 1;
+      std::printf("%-40s %10lld %14llu %12.3f %10.3f %10.3f %10.3f\n", analysis.name.c_str(), size,
+                  static_cast<unsigned long long>(ops.comparisons), ops.comparisons / nLogN, ops.copies / n,
+                  ops.moves / n, (ops.copyAssignments + ops.moveAssignments) / n);
+      std::fflush(stdout);
+    }
+  }
+
+  if (!options.csvPath.empty()) {
+    std::FILE* out = std::fopen(options.csvPath.c_str(), "w");
+    if (!out) throw std::runtime_error("cannot create " + options.csvPath);
+    std::fprintf(out, "name,size,comparisons,copies,moves,copy_assignments,move_assignments\n");
+    for (const CountResult& r : results) {
+      std::fprintf(out, "\"%s\",%lld,%llu,%llu,%llu,%llu,%llu\n", r.name.c_str(), r.size,
+                   static_cast<unsigned long long>(r.ops.comparisons), static_cast<unsigned long long>(r.ops.copies),
+                   static_cast<unsigned long long>(r.ops.moves), static_cast<unsigned long long>(r.ops.copyAssignments),
+                   static_cast<unsigned long long>(r.ops.moveAssignments));
+    }
+    std::fclose(out);
+  }
+  if (!options.jsonPath.empty()) {
+    std::FILE* out = std::fopen(options.jsonPath.c_str(), "w");
+    if (!out) throw std::runtime_error("cannot create " + options.jsonPath);
+    std::fprintf(out, "{\n  \"counts\": [");
+    for (std::size_t i = 0; i < results.size(); i++) {
+      const CountResult& r = results[i];
+      std::fprintf(out, "%s\n    {\"name\": \"%s\", \"size\": %lld, \"comparisons\": %llu, \"copies\": %llu, \"moves\": %llu,"
+                   " \"copy_assignments\": %llu, \"move_assignments\": %llu}", i ? "," : "", jsonEscape(r.name).c_str(), r.size,
+                   static_cast<unsigned long long>(r.ops.comparisons), static_cast<unsigned long long>(r.ops.copies),
+                   static_cast<unsigned long long>(r.ops.moves), static_cast<unsigned long long>(r.ops.copyAssignments),
+                   static_cast<unsigned long long>(r.ops.moveAssignments));
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+    std::fclose(out);
+  }
+}
+
+// A file name for a benchmark name: anything but letters, digits, '-' and
+// '.' becomes '_'.
+static std::string fileNameFor(const std::string& name, long long size) {
+  std::string file;
+  for (char c : name) file += std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '.' ? c : '_';
+  return file + "-" + std::to_string(size) + ".hgrm";
+}
+
+// The --latency mode.
+static void runLatency(const BenchOptions& options) {
+  const BenchSettings& settings = options.settings;
+
+  // What recordLatency adds to every value, from timing an empty operation.
+  LatencyHistogram overhead;
+  for (int i = 0; i < 100000; i++) recordLatency(overhead, [] {});
+  std::printf("timer overhead: p50 %llu ns, p99 %llu ns (included in every value below)\n\n",
+              static_cast<unsigned long long>(overhead.percentile(50)),
+              static_cast<unsigned long long>(overhead.percentile(99)));
+
+  std::printf("%-40s %10s %10s %10s %10s %10s %10s %10s %10s\n", "benchmark", "size", "ops", "p50", "p90", "p99",
+              "p99.9", "max", "mean");
+  for (const BenchLatencyDefinition& bench : benchLatencyRegistry()) {
+    if (!matchesFilters(bench.name, options.filters)) continue;
+    for (long long size : bench.sizes) {
+      if (size < settings.minSize || (settings.maxSize >= 0 && size > settings.maxSize)) continue;
+      LatencyHistogram histogram;
+      bench.function(size, histogram);
+      std::printf("%-40s %10lld %10llu %10s %10s %10s %10s %10s %10s\n", bench.name.c_str(), size,
+                  static_cast<unsigned long long>(histogram.count()), formatTime(histogram.percentile(50)).c_str(),
+                  formatTime(histogram.percentile(90)).c_str(), formatTime(histogram.percentile(99)).c_str(),
+                  formatTime(histogram.percentile(99.9)).c_str(), formatTime(histogram.maximum()).c_str(),
+                  formatTime(histogram.mean()).c_str());
+      std::fflush(stdout);
+
+      if (!options.histogramDir.empty()) {
+        std::string path = options.histogramDir + "/" + fileNameFor(bench.name, size);
+        std::FILE* out = std::fopen(path.c_str(), "w");
+        if (!out) throw std::runtime_error("cannot create " + path);
+        histogram.writePercentiles(out);
+        std::fclose(out);
+      }
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    BenchOptions options = parseArguments(argc, argv);
+    const BenchSettings& settings = options.settings;
+    // A build with tracing only traces when asked to, and only the timed
+    // benchmarks.
+    ListTrace::setEnabled(!options.tracePath.empty() && !options.counts && !options.latency);
+    if (options.traceMinSize >= 0) ListTrace::setMinSize(options.traceMinSize);
+    if (!options.tracePath.empty() && !ListTrace::compiledIn()) {
+      std::fprintf(stderr, "warning: --trace needs a build with LINKEDLIST_TRACE (make benchmarks-stats); "
+                           "the trace will be empty\n");
+    }
+
+    if (options.listOnly && options.latency) {
+      for (const BenchLatencyDefinition& bench : benchLatencyRegistry()) {
+        std::printf("%s:", bench.name.c_str());
+        for (long long size : bench.sizes) std::printf(" %lld", size);
+        std::printf("\n");
+      }
+      return 0;
+    }
+    if (options.listOnly && options.counts) {
+      for (const BenchCountDefinition& analysis : benchCountRegistry()) {
+        std::printf("%s:", analysis.name.c_str());
+        for (long long size : analysis.sizes) std::printf(" %lld", size);
+        std::printf("\n");
+      }
+      return 0;
+    }
+    if (options.listOnly) {
+      for (const BenchDefinition& bench : benchRegistry()) {
+        std::printf("%s:", bench.name.c_str());
+        for (long long size : bench.sizes) std::printf(" %lld", size);
+        std::printf("\n");
+      }
+      return 0;
+    }
+    if (options.counts) {
+      runCounts(options);
+      return 0;
+    }
+    if (options.latency) {
+      pinToCpu(options.cpu);
+      runLatency(options);
+      return 0;
+    }
+
+    int cpu = pinToCpu(options.cpu);
+    if (ListAllocStats::enabled) {
+      std::fprintf(stderr, "note: built with LINKEDLIST_ALLOC_STATS; LinkedList timings include the counting\n");
+    }
+    else if (settings.memoryTimeline) {
+      std::fprintf(stderr, "warning: --memory needs a build with LINKEDLIST_ALLOC_STATS (make benchmarks-stats); "
+                           "no memory is recorded\n");
+    }
+
+    // Counting is best effort: without permission, or on a machine without
+    // the events, the benchmarks run with wall-clock times only.
+    std::unique_ptr<PerfCounters> counters;
+    if (options.perf) {
+      counters.reset(new PerfCounters());
+      if (!counters->available()) {
+        std::fprintf(stderr, "warning: perf counters unavailable (%s); timing only\n", counters->error().c_str());
+        counters.reset();
+      }
+      else if (!counters->error().empty()) {
+        std::fprintf(stderr, "warning: some perf counters unavailable (%s)\n", counters->error().c_str());
+      }
+    }
+    std::printf("%-40s %10s %10s %4s %11s %11s %11s %9s %11s %10s\n", "benchmark", "size", "iters", "n",
+                "median", "p95", "min", "rel sd", "per item", "bytes/item");
+    std::fflush(stdout);
+
+    std::vector<BenchResult> results;
+    for (const BenchDefinition& bench : benchRegistry()) {
+      if (!matchesFilters(bench.name, options.filters)) continue;
+      for (long long size : bench.sizes) {
+        if (size < settings.minSize || (settings.maxSize >= 0 && size > settings.maxSize)) continue;
+        BenchState state(size, settings, counters.get());
+        bench.function(state);
+        if (state.samplesNs().empty()) continue;
+
+        BenchResult result;
+        result.name = bench.name;
+        result.size = size;
+        result.iterations = state.iterations();
+        result.itemsPerIteration = state.itemsPerIteration();
+        result.bytesPerItem = state.bytesPerItem();
+        result.samplesNs = state.samplesNs();
+        result.countersPerIteration = state.countersPerIteration();
+        result.allocStats = state.allocStats();
+        result.memoryTimeline = state.memoryTimeline().samples();
+        result.stats = summarizeSamples(result.samplesNs);
+        results.push_back(result);
+
+        const BenchStats& s = result.stats;
+        std::string perItem = result.itemsPerIteration > 0 ? formatTime(s.medianNs / result.itemsPerIteration) : "";
+        std::string bytes = result.bytesPerItem > 0 ? formatBytes(result.bytesPerItem) : "";
+        std::printf("%-40s %10lld %10lld %4zu %11s %11s %11s %8.1f%% %11s %10s\n", bench.name.c_str(), size,
+                    result.iterations, result.samplesNs.size(), formatTime(s.medianNs).c_str(),
+                    formatTime(s.p95Ns).c_str(), formatTime(s.minNs).c_str(),
+                    s.meanNs > 0 ? 100 * s.stddevNs / s.meanNs : 0.0, perItem.c_str(), bytes.c_str());
+        printCounters(result);
+        printAllocStats(result);
+        printMemoryPlot(result);
+        std::fflush(stdout);
+      }
+    }
+
+    printRelativeThroughput(results);
+    if (settings.memoryTimeline && ListAllocStats::enabled) printMemoryPeaks(results);
+    if (!options.jsonPath.empty()) writeJson(options.jsonPath, results, cpu);
+    if (!options.csvPath.empty()) writeCsv(options.csvPath, results);
+    if (!options.tracePath.empty() && !ListTrace::writeChromeJson(options.tracePath)) {
+      throw std::runtime_error("cannot create " + options.tracePath);
+    }
+    return 0;
+  }
+  catch (const std::exception& e) {
+    std::fprintf(stderr, "benchmarks: %s\n", e.what());
+    return 2;
+  }
+}
@@ -0,0 +1,78 @@
+
+// Per-operation latencies of the LinkedList hot paths, for
+// "benchmarks --latency". Every call is timed on its own, so the tails show
+// the occasional slow call that a batch average hides: a malloc that has to
+// get memory from the kernel, a page fault on a fresh page, a cache miss
+// on a cold node.
+//
+//   ./benchmarks --latency --hgrm /tmp/hist pushBack
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+
+static constexpr std::uint64_t SEED = 20240101;
+
+static std::vector<int> uniformInts(long long size) {
+  std::vector<int> items;
+  for (std::uint64_t key : generateBenchKeys(BenchShape::Uniform, size, SEED)) {
+    items.push_back(BenchValue<int>::fromKey(key));
+  }
+  return items;
+}
+
+// size random items inserted into a list that starts empty, so the calls
+// walk from 0 to size nodes.
+static BenchLatencyRegistration insertOrderedLatency("insertOrdered/uniform", BenchSizes(1000, 10000),
+  [](long long size, LatencyHistogram& histogram) {
+    std::vector<int> items = uniformInts(size);
+    LinkedList<int> list;
+    for (int item : items) {
+      recordLatency(histogram, [&] { list.insertOrdered(item); });
+    }
+    doNotOptimize(list);
+  });
+
+// size pushes onto a list that starts empty; most go to malloc's free
+// lists, some make it ask the kernel for more memory.
+static BenchLatencyRegistration pushBackLatency("pushBack", BenchSizes(1000, 10000000),
+  [](long long size, LatencyHistogram& histogram) {
+    LinkedList<int> list;
+    for (long long i = 0; i < size; i++) {
+      recordLatency(histogram, [&] { list.pushBack(static_cast<int>(i)); });
+    }
+    doNotOptimize(list);
+  });
+
+// Pops every node of a list built beforehand.
+static BenchLatencyRegistration popFrontLatency("popFront", BenchSizes(1000, 10000000),
+  [](long long size, LatencyHistogram& histogram) {
+    LinkedList<int> list;
+    for (long long i = 0; i < size; i++) list.pushBack(static_cast<int>(i));
+    for (long long i = 0; i < size; i++) {
+      recordLatency(histogram, [&] { list.popFront(); });
+    }
+    doNotOptimize(list);
+  });
+
+// Whole merges of two sorted halves of size items, repeated so that each
+// size records about 1e6 merged items (and at least 20 merges).
+static BenchLatencyRegistration mergeLatency("merge", BenchSizes(100, 1000000),
+  [](long long size, LatencyHistogram& histogram) {
+    LinkedList<int> left;
+    LinkedList<int> right;
+    for (long long i = 0; i < size / 2; i++) {
+      left.pushBack(static_cast<int>(2 * i));
+      right.pushBack(static_cast<int>(2 * i + 1));
+    }
+    long long merges = std::max(20LL, 1000000 / size);
+    for (long long i = 0; i < merges; i++) {
+      recordLatency(histogram, [&] { doNotOptimize(left.merge(right)); });
+    }
+  });
@@ -0,0 +1,70 @@
+
+// Benchmarks for insertOrdered, merge and the sorts of LinkedList<int>.
+// These replace the single-shot timers that used to be in
+// tests/week1_tests.cpp. The inputs have the same shapes as before.
+
+#include <climits>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+
+#include "BenchHarness.h"
+
+// 1, 2, ..., n/2, n/2, ..., 2, 1: the unsorted input the week 1 sorting
+// benchmarks used.
+static LinkedList<int> organPipe(long long size) {
+  LinkedList<int> list;
+  for (int i = static_cast<int>(size / 2); i > 0; i--) {
+    list.pushFront(i);
+    list.pushBack(i);
+  }
+  return list;
+}
+
+// Worst case: the new item goes past every item in the list. It is popped
+// again so that every iteration sees the same list.
+static BenchRegistration insertOrderedBench("insertOrdered/at end", BenchSizes(100, 10000000), [](BenchState& state) {
+  LinkedList<int> list;
+  for (long long i = 0; i < state.size(); i++) {
+    list.pushBack(0);
+  }
+  state.setItemsPerIteration(state.size());
+  state.run([&] {
+    list.insertOrdered(INT_MAX);
+    list.popBack();
+    doNotOptimize(list);
+  });
+});
+
+// Two interleaved sorted halves, merged into a new list.
+static BenchRegistration mergeBench("merge/interleaved", BenchSizes(100, 10000000), [](BenchState& state) {
+  LinkedList<int> left;
+  LinkedList<int> right;
+  for (int i = 0; i < state.size() / 4; i++) {
+    left.pushBack(i);
+    right.pushBack(i + 1);
+    right.pushBack(i + 2);
+    left.pushBack(i + 3);
+  }
+  state.setItemsPerIteration(left.size() + right.size());
+  state.run([&] { doNotOptimize(left.merge(right)); });
+});
+
+// insertionSort is O(n^2), so it stops at 1e4 items.
+static BenchRegistration insertionSortBench("insertionSort/organ pipe", BenchSizes(100, 10000), [](BenchState& state) {
+  LinkedList<int> list = organPipe(state.size());
+  state.setItemsPerIteration(list.size());
+  state.run([&] { doNotOptimize(list.insertionSort()); });
+});
+
+static BenchRegistration mergeSortRecursiveBench("mergeSortRecursive/organ pipe", BenchSizes(100, 10000000), [](BenchState& state) {
+  LinkedList<int> list = organPipe(state.size());
+  state.setItemsPerIteration(list.size());
+  state.run([&] { doNotOptimize(list.mergeSortRecursive()); });
+});
+
+static BenchRegistration mergeSortIterativeBench("mergeSortIterative/organ pipe", BenchSizes(100, 10000000), [](BenchState& state) {
+  LinkedList<int> list = organPipe(state.size());
+  state.setItemsPerIteration(list.size());
+  state.run([&] { doNotOptimize(list.mergeSortIterative()); });
+});
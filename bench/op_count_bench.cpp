@@ -0,0 +1,87 @@
+
+// Operation counts of the LinkedList algorithms over every input shape in
+// BenchData.h, for "benchmarks --counts". Each analysis is registered as
+// "<algorithm>/<shape>" and counts only the algorithm itself, not the
+// building of its input:
+//
+//   ./benchmarks --counts mergeSortRecursive/
+//   ./benchmarks --counts --max-size 10000 /runs
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../CountedItem.h"
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+
+// The same inputs as the timed sort benchmarks.
+static constexpr std::uint64_t SEED = 20240101;
+
+using CountedInt = Counted<int>;
+
+static std::vector<CountedInt> countedItems(BenchShape shape, long long size) {
+  std::vector<CountedInt> items;
+  for (std::uint64_t key : generateBenchKeys(shape, size, SEED)) {
+    items.push_back(BenchValue<int>::fromKey(key));
+  }
+  return items;
+}
+
+static LinkedList<CountedInt> countedList(const std::vector<CountedInt>& items) {
+  LinkedList<CountedInt> list;
+  for (const CountedInt& item : items) list.pushBack(item);
+  return list;
+}
+
+// Registers "<algorithm>/<shape>" for every shape.
+static void registerCounts(const std::string& algorithm, const std::vector<long long>& sizes,
+                           CountedOps (*analysis)(BenchShape shape, long long size)) {
+  for (BenchShape shape : allBenchShapes()) {
+    BenchCountRegistration(algorithm + "/" + benchShapeName(shape), sizes, [shape, analysis](long long size) {
+      return analysis(shape, size);
+    });
+  }
+}
+
+static bool registered = [] {
+  // n items inserted one at a time into an empty list, so O(n^2).
+  registerCounts("insertOrdered", BenchSizes(100, 10000), [](BenchShape shape, long long size) {
+    std::vector<CountedInt> items = countedItems(shape, size);
+    LinkedList<CountedInt> list;
+    return measureCountedOps([&] {
+      for (const CountedInt& item : items) list.insertOrdered(item);
+    });
+  });
+
+  // The first and second halves of the input, each sorted, then merged.
+  registerCounts("merge", BenchSizes(100, 1000000), [](BenchShape shape, long long size) {
+    std::vector<CountedInt> items = countedItems(shape, size);
+    auto middle = items.begin() + items.size() / 2;
+    std::sort(items.begin(), middle);
+    std::sort(middle, items.end());
+    LinkedList<CountedInt> left = countedList(std::vector<CountedInt>(items.begin(), middle));
+    LinkedList<CountedInt> right = countedList(std::vector<CountedInt>(middle, items.end()));
+    return measureCountedOps([&] { left.merge(right); });
+  });
+
+  registerCounts("insertionSort", BenchSizes(100, 10000), [](BenchShape shape, long long size) {
+    LinkedList<CountedInt> list = countedList(countedItems(shape, size));
+    return measureCountedOps([&] { list.insertionSort(); });
+  });
+
+  registerCounts("mergeSortRecursive", BenchSizes(100, 1000000), [](BenchShape shape, long long size) {
+    LinkedList<CountedInt> list = countedList(countedItems(shape, size));
+    return measureCountedOps([&] { list.mergeSortRecursive(); });
+  });
+
+  registerCounts("mergeSortIterative", BenchSizes(100, 1000000), [](BenchShape shape, long long size) {
+    LinkedList<CountedInt> list = countedList(countedItems(shape, size));
+    return measureCountedOps([&] { list.mergeSortIterative(); });
+  });
+  return true;
+}();
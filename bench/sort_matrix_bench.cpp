@@ -0,0 +1,54 @@
+
+// The LinkedList sorts over every input shape and item type in
+// BenchData.h. Every case is registered under
+// "<sort>/<type>/<shape>", so a filter picks out any slice of the matrix:
+//
+//   ./benchmarks --max-size 100000 "mergeSortRecursive/int/"
+//   ./benchmarks "/zipfian"
+
+#include <cstdint>
+#include <string>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+
+// The same seed for every case, so that each sort sees the same inputs.
+static constexpr std::uint64_t SEED = 20240101;
+
+template <typename T>
+static void registerSortsFor() {
+  for (BenchShape shape : allBenchShapes()) {
+    std::string suffix = std::string("/") + BenchValue<T>::name() + "/" + benchShapeName(shape);
+
+    BenchRegistration(std::string("mergeSortRecursive") + suffix, BenchSizes(100, 1000000), [shape](BenchState& state) {
+      LinkedList<T> list = generateBenchList<T>(shape, state.size(), SEED);
+      state.setItemsPerIteration(list.size());
+      state.run([&] { doNotOptimize(list.mergeSortRecursive()); });
+    });
+    BenchRegistration(std::string("mergeSortIterative") + suffix, BenchSizes(100, 1000000), [shape](BenchState& state) {
+      LinkedList<T> list = generateBenchList<T>(shape, state.size(), SEED);
+      state.setItemsPerIteration(list.size());
+      state.run([&] { doNotOptimize(list.mergeSortIterative()); });
+    });
+    // insertionSort is O(n^2) on most shapes, so it stops at 1e4 items.
+    BenchRegistration(std::string("insertionSort") + suffix, BenchSizes(100, 10000), [shape](BenchState& state) {
+      LinkedList<T> list = generateBenchList<T>(shape, state.size(), SEED);
+      state.setItemsPerIteration(list.size());
+      state.run([&] { doNotOptimize(list.insertionSort()); });
+    });
+  }
+}
+
+static bool registerSortMatrix() {
+  registerSortsFor<int>();
+  registerSortsFor<std::uint64_t>();
+  registerSortsFor<double>();
+  registerSortsFor<std::string>();
+  registerSortsFor<WideBenchRecord>();
+  return true;
+}
+
+static bool sortMatrixRegistered = registerSortMatrix();
@@ -0,0 +1,247 @@
+/**
+ * @file lreplay.cpp
+ * Replays a LinkedList operation trace against list implementations.
+ *
+ * Usage: lreplay [options] trace
+ *
+ * The trace is one recorded with ScopedListOpRecorder (ListOpRecorder.h) in
+ * a build with LINKEDLIST_RECORD. Every operation in it is run again, in
+ * order, on each chosen implementation, and timed on its own; lreplay then
+ * reports the throughput and latency percentiles of each kind of
+ * operation, and compares the implementations. The replay checks the list
+ * sizes against the trace as it goes, so every implementation runs exactly
+ * the recorded workload. See usage() for the options.
+**/
+
+#include <algorithm> // for std::max
+#include <cstdint> // for std::uint64_t, std::int32_t, std::int64_t
+#include <cstdio> // for std::printf, std::fprintf
+#include <cstdlib> // for std::atoi
+#include <list> // for std::list
+#include <memory> // for std::unique_ptr
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::string
+#include <vector> // for std::vector
+
+#include <unistd.h> // for getopt
+
+#include "LinkedList.h"
+#include "LinkedListExercises.h"
+#include "NodeAllocators.h"
+#include "HugePageArena.h"
+#include "ThreadCachedNodeAllocator.h"
+#include "bench/LatencyHistogram.h"
+
+// -----------------------------------------------------------------------
+// Options
+
+struct ReplayOptions {
+  std::vector<std::string> implementations;
+  int repeat = 3;
+};
+
+static const std::vector<std::string>& allImplementations() {
+  static const std::vector<std::string> names = {"heap", "arena", "hugepage", "thread-cached", "std::list"};
+  return names;
+}
+
+static void usage(std::FILE* out) {
+  std::fprintf(out,
+    "Usage: lreplay [options] trace\n"
+    "Replays a LinkedList operation trace and reports throughput and latency.\n"
+    "\n"
+    "  -i NAME   replay with this implementation; may be given more than once\n"
+    "            (default: all of them):\n"
+    "              heap           LinkedList with HeapNodeAllocator\n"
+    "              arena          LinkedList with ArenaNodeAllocator\n"
+    "              hugepage       LinkedList with HugePageArenaNodeAllocator\n"
+    "              thread-cached  LinkedList with ThreadCachedNodeAllocator\n"
+    "              std::list      std::list, sorting with std::list::sort\n"
+    "  -r N      replay the trace N times per implementation (default 3)\n"
+    "  -h        show this help\n");
+}
+
+// -----------------------------------------------------------------------
+// std::list with the LinkedList operations that a replay needs.
+
+template <typename T>
+class StdListAdapter {
+public:
+  int size() const { return static_cast<int>(items_.size()); }
+  void pushBack(const T& item) { items_.push_back(item); }
+  void pushFront(const T& item) { items_.push_front(item); }
+  void popBack() { if (!items_.empty()) items_.pop_back(); }
+  void popFront() { if (!items_.empty()) items_.pop_front(); }
+  void appendBulk(const T* items, int count) { items_.insert(items_.end(), items, items + count); }
+  void clear() { items_.clear(); }
+
+  void insertOrdered(const T& item) {
+    auto at = items_.begin();
+    while (at != items_.end() && *at < item) ++at;
+    items_.insert(at, item);
+  }
+
+  StdListAdapter merge(const StdListAdapter& other) const {
+    StdListAdapter result;
+    auto a = items_.begin();
+    auto b = other.items_.begin();
+    while (a != items_.end() && b != other.items_.end()) {
+      if (*b < *a) result.items_.push_back(*b++);
+      else result.items_.push_back(*a++);
+    }
+    result.items_.insert(result.items_.end(), a, items_.end());
+    result.items_.insert(result.items_.end(), b, other.items_.end());
+    return result;
+  }
+
+  StdListAdapter sorted() const {
+    StdListAdapter result = *this;
+    result.items_.sort();
+    return result;
+  }
+
+  StdListAdapter mergeSortRecursive() const { return sorted(); }
+  StdListAdapter mergeSortIterative() const { return sorted(); }
+  StdListAdapter insertionSort() const { return sorted(); }
+
+private:
+  std::list<T> items_;
+};
+
+// -----------------------------------------------------------------------
+// Replaying
+
+// The latencies of one implementation, per kind of operation and overall.
+struct ReplayResult {
+  std::string implementation;
+  std::vector<std::unique_ptr<LatencyHistogram>> byOp;
+  LatencyHistogram all;
+  std::vector<double> totalNsByOp;
+  double totalNs = 0;
+
+  ReplayResult() {
+    for (int code = 0; code < LIST_OP_CODES; code++) byOp.emplace_back(new LatencyHistogram());
+    totalNsByOp.assign(LIST_OP_CODES, 0);
+  }
+};
+
+template <typename T, typename List>
+static void replay(const ListOpTrace& trace, int repeat, ReplayResult& result) {
+  for (int run = 0; run < repeat; run++) {
+    // A fresh replayer per run, so that every run starts from empty lists.
+    ListOpReplayer<T, List> replayer(trace);
+    replayer.run([&](const ListOp& op, std::uint64_t ns) {
+      int code = static_cast<int>(op.code);
+      result.byOp[code]->record(ns);
+      result.totalNsByOp[code] += static_cast<double>(ns);
+      // Snapshots only rebuild lists that existed before recording began.
+      if (op.code != ListOpCode::Snapshot) {
+        result.all.record(ns);
+        result.totalNs += static_cast<double>(ns);
+      }
+    });
+  }
+}
+
+template <typename T>
+static void replayAs(const ListOpTrace& trace, const std::string& implementation, int repeat, ReplayResult& result) {
+  if (implementation == "heap") replay<T, LinkedList<T>>(trace, repeat, result);
+  else if (implementation == "arena") replay<T, LinkedList<T, ArenaNodeAllocator>>(trace, repeat, result);
+  else if (implementation == "hugepage") replay<T, LinkedList<T, HugePageArenaNodeAllocator>>(trace, repeat, result);
+  else if (implementation == "thread-cached") replay<T, LinkedList<T, ThreadCachedNodeAllocator>>(trace, repeat, result);
+  else if (implementation == "std::list") replay<T, StdListAdapter<T>>(trace, repeat, result);
+  else throw std::runtime_error("unknown implementation " + implementation);
+}
+
+// Picks the item type from the trace header.
+static void replayTrace(const ListOpTrace& trace, const std::string& implementation, int repeat, ReplayResult& result) {
+  char kind = trace.itemKind();
+  std::uint32_t size = trace.elementSize();
+  if (kind == 'i' && size == 4) replayAs<std::int32_t>(trace, implementation, repeat, result);
+  else if (kind == 'i' && size == 8) replayAs<std::int64_t>(trace, implementation, repeat, result);
+  else if (kind == 'u' && size == 4) replayAs<std::uint32_t>(trace, implementation, repeat, result);
+  else if (kind == 'u' && size == 8) replayAs<std::uint64_t>(trace, implementation, repeat, result);
+  else if (kind == 'f' && size == 4) replayAs<float>(trace, implementation, repeat, result);
+  else if (kind == 'f' && size == 8) replayAs<double>(trace, implementation, repeat, result);
+  else {
+    throw std::runtime_error("lreplay can't replay items of kind '" + std::string(1, kind) + "' and " +
+                             std::to_string(size) + " bytes; use ListOpReplayer with the recorded type");
+  }
+}
+
+// -----------------------------------------------------------------------
+// Reporting
+
+static void printHistogramRow(const char* name, const LatencyHistogram& histogram, double totalNs) {
+  double perSecond = totalNs > 0 ? static_cast<double>(histogram.count()) / (totalNs / 1e9) : 0;
+  std::printf("  %-20s %10llu %11.3f %12.0f %9llu %9llu %9llu %9llu %11llu\n", name,
+              static_cast<unsigned long long>(histogram.count()), totalNs / 1e6, perSecond,
+              static_cast<unsigned long long>(histogram.percentile(50)),
+              static_cast<unsigned long long>(histogram.percentile(90)),
+              static_cast<unsigned long long>(histogram.percentile(99)),
+              static_cast<unsigned long long>(histogram.percentile(99.9)),
+              static_cast<unsigned long long>(histogram.maximum()));
+}
+
+static void printResult(const ReplayResult& result) {
+  std::printf("\n%s:\n", result.implementation.c_str());
+  std::printf("  %-20s %10s %11s %12s %9s %9s %9s %9s %11s\n", "operation", "count", "total ms", "ops/s",
+              "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns");
+  for (int code = 1; code < LIST_OP_CODES; code++) {
+    if (result.byOp[code]->count() == 0) continue;
+    printHistogramRow(listOpName(static_cast<ListOpCode>(code)), *result.byOp[code], result.totalNsByOp[code]);
+  }
+  printHistogramRow("all but snapshots", result.all, result.totalNs);
+}
+
+static int run(const std::string& path, const ReplayOptions& options) {
+  ListOpTrace trace = ListOpTrace::read(path);
+  std::printf("%s: %zu operations on %zu lists, %u-byte items of kind '%c'; %d run%s each\n", path.c_str(),
+              trace.ops().size(), trace.listCount(), trace.elementSize(), trace.itemKind(), options.repeat,
+              options.repeat == 1 ? "" : "s");
+  std::printf("Latencies include one steady_clock read, some tens of nanoseconds.\n");
+
+  std::vector<std::unique_ptr<ReplayResult>> results;
+  for (const std::string& implementation : options.implementations) {
+    results.emplace_back(new ReplayResult());
+    results.back()->implementation = implementation;
+    replayTrace(trace, implementation, options.repeat, *results.back());
+    printResult(*results.back());
+    std::fflush(stdout);
+  }
+
+  if (results.size() > 1) {
+    const ReplayResult& reference = *results.front();
+    std::printf("\nThroughput relative to %s (higher is faster):\n", reference.implementation.c_str());
+    for (const std::unique_ptr<ReplayResult>& result : results) {
+      double relative = result->totalNs > 0 ? reference.totalNs / result->totalNs : 0;
+      std::printf("  %-20s %11.3f ms %9.2fx\n", result->implementation.c_str(), result->totalNs / 1e6, relative);
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  ReplayOptions options;
+  try {
+    int opt;
+    while ((opt = ::getopt(argc, argv, "i:r:h")) != -1) {
+      switch (opt) {
+        case 'i': options.implementations.push_back(optarg); break;
+        case 'r': options.repeat = std::max(1, std::atoi(optarg)); break;
+        case 'h': usage(stdout); return 0;
+        default: usage(stderr); return 2;
+      }
+    }
+    if (optind + 1 != argc) {
+      usage(stderr);
+      return 2;
+    }
+    if (options.implementations.empty()) options.implementations = allImplementations();
+    return run(argv[optind], options);
+  }
+  catch (const std::exception& e) {
+    std::fprintf(stderr, "lreplay: %s\n", e.what());
+    return 2;
+  }
+}
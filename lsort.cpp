@@ -0,0 +1,744 @@
+/**
+ * @file lsort.cpp
+ * A command-line line sorter built on LinkedList.
+ *
+ * Usage: lsort [options] [file...]
+ *
+ * Reads lines from the files (or stdin, or "-") into a LinkedList, sorts
+ * them with the chosen algorithm and writes them to stdout. The ordering
+ * follows GNU sort in the C locale: keys are compared byte by byte (or as
+ * numbers with -n), and lines with equal keys are ordered by the whole line
+ * unless -s is given. See usage() for the options.
+**/
+
+#include <cerrno> // for errno
+#include <chrono> // for std::chrono::steady_clock
+#include <cstdio> // for std::FILE, std::fopen, std::fread, std::fwrite, std::fprintf, std::rename
+#include <cstdlib> // for std::strtoull, std::getenv, realpath, std::free
+#include <cstring> // for std::memcmp, std::memchr, std::strerror
+#include <memory> // for std::unique_ptr
+#include <queue> // for std::priority_queue
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::string
+#include <vector> // for std::vector
+
+#include <sys/resource.h> // for getrusage
+#include <sys/stat.h> // for stat, fchmod, umask
+#include <unistd.h> // for getopt, mkstemp, close, unlink
+
+#include "LinkedList.h"
+#include "LinkedListExercises.h"
+#include "IntrusiveLinkedList.h"
+
+// -----------------------------------------------------------------------
+// Options
+
+enum class Algorithm { Recursive, Iterative, Insertion, InPlace };
+
+struct SortOptions {
+  Algorithm algorithm = Algorithm::Recursive;
+  // The key runs from the start of field keyFirst to the end of field
+  // keyLast, counting from 1. 0 means the start or end of the line.
+  int keyFirst = 0;
+  int keyLast = 0;
+  // Field separator; 0 means fields are runs of blanks followed by
+  // non-blanks, as in GNU sort.
+  char separator = 0;
+  bool numeric = false;
+  bool reverse = false;
+  bool unique = false;
+  // Equal keys keep their input order instead of comparing whole lines.
+  bool stable = false;
+  bool mergeOnly = false;
+  bool stats = false;
+  // Sorted runs are spilled to temporary files once the records in memory
+  // take more than this many bytes. 0 means never.
+  std::size_t memoryLimit = 0;
+  std::string tempDir;
+  std::string outputPath;
+};
+
+// The comparisons below are called through operator< by the LinkedList
+// sorts, so the options they need are global.
+static SortOptions options;
+
+// -----------------------------------------------------------------------
+// Records
+
+// The key as a number, for -n: its digits, read in place, without leading
+// zeros in the integer part or trailing zeros in the fraction, so that
+// numbers of any length compare exactly.
+struct NumericKey {
+  // The integer digits, followed by '.' and the fraction digits if any.
+  const char* digits;
+  std::size_t intDigits;
+  std::size_t fracDigits;
+  bool negative;
+};
+
+// One input line, pointing into a LineStore or a RunReader buffer.
+struct LineRecord {
+  const char* text;
+  std::size_t length;
+  const char* key;
+  std::size_t keyLength;
+  // The key as a number, for -n.
+  NumericKey number;
+  // The position in the input, so that equal lines keep their input order
+  // whichever algorithm sorts them.
+  long long sequence;
+  // Used by the in-place sort, which relinks the records themselves.
+  IntrusiveListHook<LineRecord> hook;
+};
+
+static bool isBlank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+// Where field "field" (from 1) starts in [begin, end).
+static const char* fieldStart(const char* begin, const char* end, int field) {
+  const char* p = begin;
+  for (int f = 1; f < field && p != end; f++) {
+    if (options.separator) {
+      const void* sep = std::memchr(p, options.separator, end - p);
+      p = sep ? static_cast<const char*>(sep) + 1 : end;
+    }
+    else {
+      while (p != end && isBlank(*p)) p++;
+      while (p != end && !isBlank(*p)) p++;
+    }
+  }
+  return p;
+}
+
+// Where the field starting at p ends.
+static const char* fieldEnd(const char* p, const char* end) {
+  if (options.separator) {
+    const void* sep = std::memchr(p, options.separator, end - p);
+    return sep ? static_cast<const char*>(sep) : end;
+  }
+  while (p != end && isBlank(*p)) p++;
+  while (p != end && !isBlank(*p)) p++;
+  return p;
+}
+
+// Leading blanks, an optional minus sign, digits and an optional fraction,
+// as GNU sort -n reads them. Anything else counts as 0.
+static NumericKey parseLeadingNumber(const char* p, const char* end) {
+  NumericKey number;
+  while (p != end && isBlank(*p)) p++;
+  number.negative = p != end && *p == '-';
+  if (number.negative) p++;
+  while (p != end && *p == '0') p++;
+  number.digits = p;
+  while (p != end && *p >= '0' && *p <= '9') p++;
+  number.intDigits = p - number.digits;
+  number.fracDigits = 0;
+  if (p != end && *p == '.') {
+    const char* fraction = ++p;
+    const char* lastNonZero = fraction;
+    for (; p != end && *p >= '0' && *p <= '9'; p++) {
+      if (*p != '0') lastNonZero = p + 1;
+    }
+    number.fracDigits = lastNonZero - fraction;
+  }
+  // -0 is 0.
+  if (number.intDigits == 0 && number.fracDigits == 0) number.negative = false;
+  return number;
+}
+
+static LineRecord makeRecord(const char* text, std::size_t length, long long sequence = 0) {
+  LineRecord record;
+  record.text = text;
+  record.length = length;
+  record.sequence = sequence;
+  const char* end = text + length;
+  const char* keyBegin = options.keyFirst > 1 ? fieldStart(text, end, options.keyFirst) : text;
+  const char* keyEnd = options.keyLast > 0 ? fieldEnd(fieldStart(keyBegin, end, options.keyLast - options.keyFirst + 1), end) : end;
+  if (keyEnd < keyBegin) keyEnd = keyBegin;
+  record.key = keyBegin;
+  record.keyLength = keyEnd - keyBegin;
+  record.number = options.numeric ? parseLeadingNumber(keyBegin, keyEnd) : NumericKey();
+  return record;
+}
+
+static int compareBytes(const char* a, std::size_t aLength, const char* b, std::size_t bLength) {
+  int c = std::memcmp(a, b, aLength < bLength ? aLength : bLength);
+  if (c != 0) return c;
+  return aLength < bLength ? -1 : (aLength > bLength ? 1 : 0);
+}
+
+static const char* fractionOf(const NumericKey& number) {
+  return number.fracDigits ? number.digits + number.intDigits + 1 : number.digits;
+}
+
+// Compares two numbers digit by digit: more integer digits is larger, then
+// the integer digits decide, then the fractions.
+static int compareNumbers(const NumericKey& a, const NumericKey& b) {
+  if (a.negative != b.negative) return a.negative ? -1 : 1;
+  int c;
+  if (a.intDigits != b.intDigits) c = a.intDigits < b.intDigits ? -1 : 1;
+  else {
+    c = std::memcmp(a.digits, b.digits, a.intDigits);
+    if (c == 0) c = compareBytes(fractionOf(a), a.fracDigits, fractionOf(b), b.fracDigits);
+  }
+  return a.negative ? -c : c;
+}
+
+static int compareKeys(const LineRecord& a, const LineRecord& b) {
+  int c;
+  if (options.numeric) c = compareNumbers(a.number, b.number);
+  else c = compareBytes(a.key, a.keyLength, b.key, b.keyLength);
+  return options.reverse ? -c : c;
+}
+
+// The output order: by key, then (unless -s or -u) by the whole line.
+static int compareLines(const LineRecord& a, const LineRecord& b) {
+  int c = compareKeys(a, b);
+  if (c != 0 || options.stable || options.unique) return c;
+  c = compareBytes(a.text, a.length, b.text, b.length);
+  return options.reverse ? -c : c;
+}
+
+// The LinkedList merge is not stable, so ties are broken by input order.
+// That keeps -s and -u right, and the output the same for every algorithm.
+static int compareRecords(const LineRecord& a, const LineRecord& b) {
+  int c = compareLines(a, b);
+  if (c != 0) return c;
+  return a.sequence < b.sequence ? -1 : (a.sequence > b.sequence ? 1 : 0);
+}
+
+bool operator<(const LineRecord& a, const LineRecord& b) { return compareRecords(a, b) < 0; }
+bool operator<=(const LineRecord& a, const LineRecord& b) { return compareRecords(a, b) <= 0; }
+
+// -----------------------------------------------------------------------
+// Input
+
+// The text of the lines held in memory, in large blocks.
+class LineStore {
+public:
+  static constexpr std::size_t BLOCK_BYTES = 1 << 20;
+
+  LineStore() : used_(BLOCK_BYTES), bytes_(0) {}
+
+  const char* add(const char* text, std::size_t length) {
+    if (length > BLOCK_BYTES / 4) {
+      // Long lines get a block of their own.
+      blocks_.emplace_back(new char[length]);
+      bytes_ += length;
+      std::memcpy(blocks_.back().get(), text, length);
+      return blocks_.back().get();
+    }
+    if (!current_ || used_ + length > BLOCK_BYTES) {
+      blocks_.emplace_back(new char[BLOCK_BYTES]);
+      bytes_ += BLOCK_BYTES;
+      used_ = 0;
+      current_ = blocks_.back().get();
+    }
+    char* copy = current_ + used_;
+    std::memcpy(copy, text, length);
+    used_ += length;
+    return copy;
+  }
+
+  std::size_t bytes() const { return bytes_; }
+
+  void clear() {
+    blocks_.clear();
+    current_ = nullptr;
+    used_ = BLOCK_BYTES;
+    bytes_ = 0;
+  }
+
+private:
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* current_ = nullptr;
+  std::size_t used_;
+  std::size_t bytes_;
+};
+
+// Opens path for reading, with "-" meaning stdin.
+static std::FILE* openInput(const std::string& path) {
+  if (path == "-") return stdin;
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (!file) throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+  return file;
+}
+
+// Reads one line at a time, without the newline. A missing newline at the
+// end of the input still ends the last line.
+class LineReader {
+public:
+  static constexpr std::size_t BUFFER_BYTES = 1 << 20;
+
+  explicit LineReader(std::FILE* file) : file_(file), buffer_(BUFFER_BYTES), begin_(0), end_(0), eof_(false) {}
+
+  bool next(const char*& text, std::size_t& length) {
+    for (;;) {
+      const void* newline = std::memchr(buffer_.data() + begin_, '\n', end_ - begin_);
+      if (newline) {
+        text = buffer_.data() + begin_;
+        length = static_cast<const char*>(newline) - text;
+        begin_ += length + 1;
+        return true;
+      }
+      if (eof_) {
+        if (begin_ == end_) return false;
+        text = buffer_.data() + begin_;
+        length = end_ - begin_;
+        begin_ = end_;
+        return true;
+      }
+      refill();
+    }
+  }
+
+private:
+  void refill() {
+    // Move the partial line to the front, growing the buffer if it is full.
+    std::size_t partial = end_ - begin_;
+    std::memmove(buffer_.data(), buffer_.data() + begin_, partial);
+    begin_ = 0;
+    end_ = partial;
+    if (end_ == buffer_.size()) buffer_.resize(buffer_.size() * 2);
+    std::size_t got = std::fread(buffer_.data() + end_, 1, buffer_.size() - end_, file_);
+    end_ += got;
+    if (got == 0) {
+      if (std::ferror(file_)) throw std::runtime_error(std::string("read error: ") + std::strerror(errno));
+      eof_ = true;
+    }
+  }
+
+  std::FILE* file_;
+  std::vector<char> buffer_;
+  std::size_t begin_;
+  std::size_t end_;
+  bool eof_;
+};
+
+// -----------------------------------------------------------------------
+// Output
+
+class LineWriter {
+public:
+  explicit LineWriter(std::FILE* file) : file_(file), hasLast_(false) {
+    std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+  }
+
+  // Writes the record, or drops it under -u if its key equals the last one.
+  void write(const LineRecord& record) {
+    if (options.unique) {
+      if (hasLast_ && compareKeys(last_, record) == 0) return;
+      // The record's text may not outlive this call, so keep a copy.
+      lastText_.assign(record.text, record.length);
+      last_ = makeRecord(lastText_.data(), lastText_.size());
+      hasLast_ = true;
+    }
+    std::fwrite(record.text, 1, record.length, file_);
+    std::putc('\n', file_);
+  }
+
+  void finish() {
+    if (std::fflush(file_) != 0) throw std::runtime_error(std::string("write error: ") + std::strerror(errno));
+  }
+
+private:
+  std::FILE* file_;
+  bool hasLast_;
+  LineRecord last_;
+  std::string lastText_;
+};
+
+// -----------------------------------------------------------------------
+// Sorting
+
+// Sorts records with the chosen algorithm and hands them to emit in order.
+template <typename Emit>
+static void sortRecords(LinkedList<LineRecord>& records, Emit emit) {
+  if (options.algorithm == Algorithm::InPlace) {
+    // Link the records where they already are and sort the links.
+    IntrusiveLinkedList<LineRecord, &LineRecord::hook> linked;
+    for (auto* cur = records.getHeadPtr(); cur; cur = cur->next) {
+      linked.pushBack(cur->data);
+    }
+    linked.mergeSort();
+    for (const LineRecord* cur = linked.empty() ? nullptr : &linked.front(); cur; cur = cur->hook.next) {
+      emit(*cur);
+    }
+    linked.clear();
+    return;
+  }
+
+  LinkedList<LineRecord> sorted;
+  switch (options.algorithm) {
+    case Algorithm::Recursive: sorted = records.mergeSortRecursive(); break;
+    case Algorithm::Iterative: sorted = records.mergeSortIterative(); break;
+    case Algorithm::Insertion: sorted = records.insertionSort(); break;
+    case Algorithm::InPlace: break;
+  }
+  for (const auto* cur = sorted.getHeadPtr(); cur; cur = cur->next) {
+    emit(cur->data);
+  }
+}
+
+// A sorted run in a temporary file, or a sorted input under -m.
+class RunReader {
+public:
+  RunReader(std::FILE* file, bool closeWhenDone) : reader_(file), file_(file), close_(closeWhenDone) {}
+  ~RunReader() {
+    if (close_) std::fclose(file_);
+  }
+
+  // Reads the next record; false at the end of the run. The record stays
+  // valid until the next call.
+  bool advance() {
+    const char* text;
+    std::size_t length;
+    if (!reader_.next(text, length)) return false;
+    // The reader's buffer may move on refill, so keep a copy of the line.
+    line_.assign(text, length);
+    current_ = makeRecord(line_.data(), line_.size());
+    return true;
+  }
+
+  const LineRecord& current() const { return current_; }
+
+private:
+  LineReader reader_;
+  std::FILE* file_;
+  bool close_;
+  std::string line_;
+  LineRecord current_;
+};
+
+// Merges sorted runs into writer. Ties go to the earlier run, so the merge
+// is stable when the runs are in input order.
+static void mergeRuns(std::vector<std::unique_ptr<RunReader>>& runs, LineWriter& writer) {
+  auto later = [&](std::size_t a, std::size_t b) {
+    int c = compareLines(runs[a]->current(), runs[b]->current());
+    return c > 0 || (c == 0 && a > b);
+  };
+  std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> heap(later);
+  for (std::size_t i = 0; i < runs.size(); i++) {
+    if (runs[i]->advance()) heap.push(i);
+  }
+  while (!heap.empty()) {
+    std::size_t i = heap.top();
+    heap.pop();
+    writer.write(runs[i]->current());
+    if (runs[i]->advance()) heap.push(i);
+  }
+}
+
+// Temporary run files, removed when this goes away.
+class SpillFiles {
+public:
+  ~SpillFiles() {
+    for (const std::string& path : paths_) {
+      ::unlink(path.c_str());
+    }
+  }
+
+  std::FILE* create() {
+    std::string pattern = options.tempDir + "/lsort_XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+    int fd = ::mkstemp(path.data());
+    if (fd < 0) throw std::runtime_error("cannot create a temporary file in " + options.tempDir);
+    paths_.push_back(path.data());
+    std::FILE* file = ::fdopen(fd, "w+b");
+    if (!file) {
+      ::close(fd);
+      throw std::runtime_error("cannot open a temporary file in " + options.tempDir);
+    }
+    return file;
+  }
+
+  std::size_t count() const { return paths_.size(); }
+
+private:
+  std::vector<std::string> paths_;
+};
+
+// The -o file. It is written under a temporary name in the same directory
+// and renamed over the target once all of the output is written, so that,
+// as with sort -o, the target may also be one of the inputs, and a failed
+// run leaves it as it was. A target that exists and isn't a regular file
+// (a device or a FIFO) is written directly.
+class OutputFile {
+public:
+  explicit OutputFile(const std::string& path) : file_(nullptr) {
+    // Write through a symbolic link rather than replacing it.
+    target_ = path;
+    if (char* real = ::realpath(path.c_str(), nullptr)) {
+      target_ = real;
+      std::free(real);
+    }
+
+    struct stat st;
+    bool exists = ::stat(target_.c_str(), &st) == 0;
+    if (exists && !S_ISREG(st.st_mode)) {
+      file_ = std::fopen(target_.c_str(), "wb");
+      if (!file_) throw std::runtime_error("cannot create " + path + ": " + std::strerror(errno));
+      return;
+    }
+
+    std::string::size_type slash = target_.rfind('/');
+    std::string pattern = (slash == std::string::npos ? "" : target_.substr(0, slash + 1)) + ".lsort_XXXXXX";
+    std::vector<char> temp(pattern.begin(), pattern.end());
+    temp.push_back('\0');
+    int fd = ::mkstemp(temp.data());
+    if (fd < 0) throw std::runtime_error("cannot create " + path + ": " + std::strerror(errno));
+    temp_ = temp.data();
+    // mkstemp makes the file private; give it the target's mode, or the
+    // mode a new file would get.
+    mode_t mask = ::umask(0);
+    ::umask(mask);
+    ::fchmod(fd, exists ? (st.st_mode & 07777) : (0666 & ~mask));
+    file_ = ::fdopen(fd, "wb");
+    if (!file_) {
+      ::close(fd);
+      ::unlink(temp_.c_str());
+      throw std::runtime_error("cannot create " + path + ": " + std::strerror(errno));
+    }
+  }
+
+  // Without commit(), the output is thrown away.
+  ~OutputFile() {
+    if (file_) std::fclose(file_);
+    if (!temp_.empty()) ::unlink(temp_.c_str());
+  }
+
+  OutputFile(const OutputFile&) = delete;
+  OutputFile& operator=(const OutputFile&) = delete;
+
+  std::FILE* file() const { return file_; }
+
+  // Closes the file and puts it in place of the target.
+  void commit() {
+    int closed = std::fclose(file_);
+    file_ = nullptr;
+    if (closed != 0) throw std::runtime_error("write error on " + target_ + ": " + std::strerror(errno));
+    if (temp_.empty()) return;
+    if (std::rename(temp_.c_str(), target_.c_str()) != 0) {
+      throw std::runtime_error("cannot replace " + target_ + ": " + std::strerror(errno));
+    }
+    temp_.clear();
+  }
+
+private:
+  std::string target_;
+  // Empty when the target is written directly.
+  std::string temp_;
+  std::FILE* file_;
+};
+
+// -----------------------------------------------------------------------
+// Main program
+
+struct Timer {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  double ms() const {
+    std::chrono::duration<double, std::milli> dur_ms = std::chrono::steady_clock::now() - start;
+    return dur_ms.count();
+  }
+};
+
+static void usage(std::FILE* out) {
+  std::fprintf(out,
+    "Usage: lsort [options] [file...]\n"
+    "Sort lines of text files (or stdin) with LinkedList.\n"
+    "\n"
+    "  -a ALG     algorithm: recursive (default), iterative, insertion, inplace\n"
+    "  -k F1[,F2] sort on fields F1 to F2 (default: to the end of the line)\n"
+    "  -t C       fields are separated by character C (default: blanks)\n"
+    "  -n         compare keys as numbers\n"
+    "  -r         reverse the order\n"
+    "  -u         output only the first of lines with equal keys\n"
+    "  -s         stable: keep equal keys in input order\n"
+    "  -m         merge files that are already sorted\n"
+    "  -S SIZE    spill sorted runs to disk above SIZE bytes (K, M, G suffixes)\n"
+    "  -T DIR     directory for spilled runs (default: $TMPDIR or /tmp)\n"
+    "  -o FILE    write to FILE instead of stdout; FILE may also be an input\n"
+    "  -v         report timing and peak memory on stderr\n"
+    "  -h         show this help\n");
+}
+
+static std::size_t parseSize(const char* text) {
+  char* end = nullptr;
+  unsigned long long value = std::strtoull(text, &end, 10);
+  if (end == text) throw std::runtime_error(std::string("bad size: ") + text);
+  switch (*end) {
+    case 'k': case 'K': value <<= 10; end++; break;
+    case 'm': case 'M': value <<= 20; end++; break;
+    case 'g': case 'G': value <<= 30; end++; break;
+    default: break;
+  }
+  if (*end) throw std::runtime_error(std::string("bad size: ") + text);
+  return static_cast<std::size_t>(value);
+}
+
+static void parseKey(const char* text) {
+  char* end = nullptr;
+  options.keyFirst = static_cast<int>(std::strtoul(text, &end, 10));
+  if (end == text || options.keyFirst < 1) throw std::runtime_error(std::string("bad key: ") + text);
+  options.keyLast = 0;
+  if (*end == ',') {
+    const char* last = end + 1;
+    options.keyLast = static_cast<int>(std::strtoul(last, &end, 10));
+    if (end == last || options.keyLast < options.keyFirst) throw std::runtime_error(std::string("bad key: ") + text);
+  }
+  if (*end) throw std::runtime_error(std::string("bad key: ") + text);
+}
+
+static Algorithm parseAlgorithm(const std::string& name) {
+  if (name == "recursive") return Algorithm::Recursive;
+  if (name == "iterative") return Algorithm::Iterative;
+  if (name == "insertion") return Algorithm::Insertion;
+  if (name == "inplace") return Algorithm::InPlace;
+  throw std::runtime_error("unknown algorithm: " + name + " (choose recursive, iterative, insertion or inplace)");
+}
+
+static const char* algorithmName(Algorithm algorithm) {
+  switch (algorithm) {
+    case Algorithm::Recursive: return "recursive";
+    case Algorithm::Iterative: return "iterative";
+    case Algorithm::Insertion: return "insertion";
+    case Algorithm::InPlace: return "inplace";
+  }
+  return "";
+}
+
+// Memory charged to one record on top of its text: the record itself, the
+// node links and the heap's own overhead.
+static constexpr std::size_t RECORD_OVERHEAD = sizeof(LineRecord) + 2 * sizeof(void*) + 16;
+
+static int run(const std::vector<std::string>& inputs) {
+  Timer total;
+  std::FILE* out = stdout;
+  std::unique_ptr<OutputFile> output;
+  if (!options.outputPath.empty()) {
+    output.reset(new OutputFile(options.outputPath));
+    out = output->file();
+  }
+  LineWriter writer(out);
+  double readMs = 0;
+  double sortMs = 0;
+  double mergeMs = 0;
+  long long lines = 0;
+  SpillFiles spills;
+
+  if (options.mergeOnly) {
+    Timer merge;
+    std::vector<std::unique_ptr<RunReader>> runs;
+    for (const std::string& input : inputs) {
+      std::FILE* file = openInput(input);
+      runs.emplace_back(new RunReader(file, file != stdin));
+    }
+    mergeRuns(runs, writer);
+    mergeMs = merge.ms();
+  }
+  else {
+    LineStore store;
+    LinkedList<LineRecord> records;
+    std::vector<std::unique_ptr<RunReader>> runs;
+
+    // Sorts what is in memory and writes it to a new run file.
+    auto spill = [&] {
+      Timer sort;
+      std::FILE* file = spills.create();
+      // Under -u this already drops duplicates within the run; the final
+      // merge drops those between runs.
+      LineWriter runWriter(file);
+      sortRecords(records, [&](const LineRecord& r) { runWriter.write(r); });
+      runWriter.finish();
+      std::rewind(file);
+      runs.emplace_back(new RunReader(file, true));
+      records.clear();
+      store.clear();
+      sortMs += sort.ms();
+    };
+
+    for (const std::string& input : inputs) {
+      Timer read;
+      std::FILE* file = openInput(input);
+      LineReader reader(file);
+      const char* text;
+      std::size_t length;
+      while (reader.next(text, length)) {
+        records.pushBack(makeRecord(store.add(text, length), length, lines));
+        lines++;
+        if (options.memoryLimit &&
+            store.bytes() + records.size() * RECORD_OVERHEAD > options.memoryLimit) {
+          readMs += read.ms();
+          spill();
+          read = Timer();
+        }
+      }
+      if (file != stdin) std::fclose(file);
+      readMs += read.ms();
+    }
+
+    if (runs.empty()) {
+      Timer sort;
+      sortRecords(records, [&](const LineRecord& r) { writer.write(r); });
+      sortMs += sort.ms();
+    }
+    else {
+      if (!records.empty()) spill();
+      Timer merge;
+      mergeRuns(runs, writer);
+      mergeMs = merge.ms();
+    }
+  }
+
+  writer.finish();
+  if (output) output->commit();
+
+  if (options.stats) {
+    struct rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    std::fprintf(stderr, "lsort: %lld lines, algorithm %s\n", lines, algorithmName(options.algorithm));
+    std::fprintf(stderr, "lsort: read %.1f ms, sort+write %.1f ms, merge %.1f ms, total %.1f ms\n",
+                 readMs, sortMs, mergeMs, total.ms());
+    std::fprintf(stderr, "lsort: %zu runs spilled, peak RSS %ld KiB\n", spills.count(), usage.ru_maxrss);
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  const char* tmp = std::getenv("TMPDIR");
+  options.tempDir = tmp && *tmp ? tmp : "/tmp";
+
+  try {
+    int opt;
+    while ((opt = ::getopt(argc, argv, "a:k:t:nrusmS:T:o:vh")) != -1) {
+      switch (opt) {
+        case 'a': options.algorithm = parseAlgorithm(optarg); break;
+        case 'k': parseKey(optarg); break;
+        case 't':
+          if (std::strlen(optarg) != 1) throw std::runtime_error("the separator must be one character");
+          options.separator = optarg[0];
+          break;
+        case 'n': options.numeric = true; break;
+        case 'r': options.reverse = true; break;
+        case 'u': options.unique = true; break;
+        case 's': options.stable = true; break;
+        case 'm': options.mergeOnly = true; break;
+        case 'S': options.memoryLimit = parseSize(optarg); break;
+        case 'T': options.tempDir = optarg; break;
+        case 'o': options.outputPath = optarg; break;
+        case 'v': options.stats = true; break;
+        case 'h': usage(stdout); return 0;
+        default: usage(stderr); return 2;
+      }
+    }
+    std::vector<std::string> inputs(argv + optind, argv + argc);
+    if (inputs.empty()) inputs.push_back("-");
+    return run(inputs);
+  }
+  catch (const std::exception& e) {
+    std::fprintf(stderr, "lsort: %s\n", e.what());
+    return 2;
+  }
+}
@@ -0,0 +1,107 @@
+#!/usr/bin/env bash
+#
+# Compare lsort with GNU sort on the same generated inputs: check that the
+# outputs are identical and report the time (and, when /usr/bin/time is
+# available, the peak memory) of each.
+#
+# Usage: ./lsort_compare.sh [lines]    (default 1000000)
+
+set -euo pipefail
+
+LINES=${1:-1000000}
+LSORT=${LSORT:-./lsort}
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/lsort_compare.XXXXXX")
+trap 'rm -rf "$WORK"' EXIT
+
+# Both tools compare bytes in the C locale.
+export LC_ALL=C
+
+echo "Generating inputs with $LINES lines in $WORK"
+awk -v n="$LINES" 'BEGIN { srand(1); for (i = 0; i < n; i++) print int(rand() * 2000000000) - 1000000000 }' > "$WORK/numbers"
+awk -v n="$LINES" 'BEGIN {
+  srand(2)
+  split("alpha bravo charlie delta echo foxtrot golf hotel india juliet", words, " ")
+  for (i = 0; i < n; i++) {
+    printf "%s%d %s %d\n", words[int(rand() * 10) + 1], int(rand() * 1000), words[int(rand() * 10) + 1], int(rand() * 100000)
+  }
+}' > "$WORK/words"
+# Numbers with up to 30 digits, past what a double holds exactly, most of
+# them sharing their leading digits.
+awk -v n="$LINES" 'BEGIN {
+  srand(3)
+  for (i = 0; i < n; i++) {
+    printf "%s1000000000%d%09d", (rand() < 0.5 ? "-" : ""), int(rand() * 10), int(rand() * 1000000000)
+    if (rand() < 0.3) printf ".%d", int(rand() * 1000)
+    printf "\n"
+  }
+}' > "$WORK/bignumbers"
+sort "$WORK/numbers" -n -o "$WORK/numbers.sorted.a"
+head -n $((LINES / 2)) "$WORK/numbers" | sort -n > "$WORK/part1"
+tail -n +$((LINES / 2 + 1)) "$WORK/numbers" | sort -n > "$WORK/part2"
+
+# Runs a command with its output sent to a file and prints its time and
+# peak memory.
+measure() {
+  local out=$1
+  shift
+  if [ -x /usr/bin/time ]; then
+    /usr/bin/time -f "%e s  %M KiB" "$@" > "$out" 2> "$out.time"
+    tail -n 1 "$out.time"
+  else
+    local start end
+    start=$(date +%s.%N)
+    "$@" > "$out"
+    end=$(date +%s.%N)
+    awk -v s="$start" -v e="$end" 'BEGIN { printf "%.2f s  (no /usr/bin/time for memory)\n", e - s }'
+  fi
+}
+
+FAILED=0
+
+# compare NAME INPUT-ARGS... : runs both tools with the same arguments.
+compare() {
+  local name=$1
+  shift
+  printf "%-28s sort:   " "$name"
+  measure "$WORK/out.sort" sort "$@"
+  printf "%-28s lsort:  " ""
+  measure "$WORK/out.lsort" "$LSORT" "$@"
+  if cmp -s "$WORK/out.sort" "$WORK/out.lsort"; then
+    echo "                             outputs match"
+  else
+    echo "                             OUTPUTS DIFFER"
+    FAILED=1
+  fi
+}
+
+compare "numbers -n" -n "$WORK/numbers"
+compare "numbers -n -r -u" -n -r -u "$WORK/numbers"
+compare "numbers as text" "$WORK/numbers"
+compare "big numbers -n" -n "$WORK/bignumbers"
+compare "words" "$WORK/words"
+compare "words -k2,2 -s" -k2,2 -s "$WORK/words"
+compare "words -k4 -n" -k4 -n "$WORK/words"
+compare "words -k3,3 -u" -k3,3 -u "$WORK/words"
+compare "numbers -n -m" -n -m "$WORK/part1" "$WORK/part2"
+compare "numbers -n -S 16M" -n -S 16M "$WORK/numbers"
+
+# As with sort, -o may name one of the inputs.
+printf "%-28s " "numbers -n -o onto input"
+cp "$WORK/numbers" "$WORK/in-place"
+"$LSORT" -n -o "$WORK/in-place" "$WORK/in-place"
+if cmp -s "$WORK/in-place" "$WORK/numbers.sorted.a"; then
+  echo "outputs match"
+else
+  echo "OUTPUTS DIFFER"
+  FAILED=1
+fi
+
+echo
+echo "lsort algorithms on numbers -n:"
+for algorithm in recursive iterative inplace; do
+  printf "%-28s " "$algorithm"
+  measure "$WORK/out.lsort" "$LSORT" -a "$algorithm" -n "$WORK/numbers"
+  cmp -s "$WORK/out.lsort" "$WORK/numbers.sorted.a" || { echo "  OUTPUT DIFFERS"; FAILED=1; }
+done
+
+exit $FAILED
@@ -0,0 +1,111 @@
+
+// Tests for the benchmark input generators in bench/BenchData.h.
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../bench/BenchData.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// Whether a < b between items exactly when a < b between keys.
+template <typename T>
+static bool keepsKeyOrder(const std::vector<std::uint64_t>& keys) {
+  for (std::size_t i = 1; i < keys.size(); i++) {
+    T a = BenchValue<T>::fromKey(keys[i - 1]);
+    T b = BenchValue<T>::fromKey(keys[i]);
+    if ((a < b) != (keys[i - 1] < keys[i]) || (b < a) != (keys[i] < keys[i - 1])) return false;
+  }
+  return true;
+}
+
+TEST_CASE("Testing BenchData: Inputs are reproducible", "[weight=1]") {
+  for (BenchShape shape : allBenchShapes()) {
+    INFO(benchShapeName(shape));
+    std::vector<std::uint64_t> keys = generateBenchKeys(shape, 5000, 7);
+    REQUIRE(keys.size() == 5000);
+    REQUIRE(keys == generateBenchKeys(shape, 5000, 7));
+    REQUIRE(generateBenchKeys(shape, 0, 7).empty());
+    REQUIRE(generateBenchKeys(shape, 1, 7).size() == 1);
+  }
+  REQUIRE(generateBenchKeys(BenchShape::Uniform, 100, 7) != generateBenchKeys(BenchShape::Uniform, 100, 8));
+
+  // Fixed values, so that a change in the generator is noticed.
+  std::vector<std::uint64_t> uniform = generateBenchKeys(BenchShape::Uniform, 3, 1);
+  std::mt19937_64 rng(1);
+  for (std::uint64_t key : uniform) {
+    REQUIRE(key == rng() % (std::uint64_t(1) << 31));
+  }
+}
+
+TEST_CASE("Testing BenchData: Shapes", "[weight=1]") {
+  const long long n = 10000;
+
+  std::vector<std::uint64_t> sorted = generateBenchKeys(BenchShape::Sorted, n, 1);
+  REQUIRE(std::is_sorted(sorted.begin(), sorted.end()));
+  std::vector<std::uint64_t> reverse = generateBenchKeys(BenchShape::Reverse, n, 1);
+  REQUIRE(std::is_sorted(reverse.rbegin(), reverse.rend()));
+  REQUIRE(reverse.front() == n - 1);
+
+  std::vector<std::uint64_t> nearly = generateBenchKeys(BenchShape::NearlySorted, n, 1, 10);
+  long long misplaced = 0;
+  for (long long i = 0; i < n; i++) {
+    if (nearly[i] != static_cast<std::uint64_t>(i)) misplaced++;
+  }
+  REQUIRE(misplaced > 0);
+  REQUIRE(misplaced <= 20);
+
+  std::vector<std::uint64_t> saw = generateBenchKeys(BenchShape::Sawtooth, n, 1, 4);
+  int descents = 0;
+  for (long long i = 1; i < n; i++) {
+    if (saw[i] < saw[i - 1]) descents++;
+  }
+  REQUIRE(descents == 3);
+
+  std::vector<std::uint64_t> pipe = generateBenchKeys(BenchShape::OrganPipe, 6, 1);
+  REQUIRE(pipe == std::vector<std::uint64_t>({1, 2, 3, 3, 2, 1}));
+
+  std::vector<std::uint64_t> few = generateBenchKeys(BenchShape::FewUnique, n, 1, 5);
+  REQUIRE(std::set<std::uint64_t>(few.begin(), few.end()).size() == 5);
+
+  std::vector<std::uint64_t> equal = generateBenchKeys(BenchShape::AllEqual, n, 1);
+  REQUIRE(std::set<std::uint64_t>(equal.begin(), equal.end()).size() == 1);
+
+  // Zipf with exponent 1: the most common key appears about twice as often
+  // as the second most common one.
+  std::vector<std::uint64_t> zipf = generateBenchKeys(BenchShape::Zipfian, 100000, 1);
+  std::map<std::uint64_t, int> counts;
+  for (std::uint64_t key : zipf) counts[key]++;
+  std::vector<int> frequencies;
+  for (const auto& entry : counts) frequencies.push_back(entry.second);
+  std::sort(frequencies.rbegin(), frequencies.rend());
+  REQUIRE(frequencies[0] > 1.6 * frequencies[1]);
+  REQUIRE(frequencies[0] < 2.4 * frequencies[1]);
+
+  // Runs: a permutation of 0..n-1 made of 3 ascending runs.
+  std::vector<std::uint64_t> runs = generateBenchKeys(BenchShape::Runs, 9, 1, 3);
+  REQUIRE(runs == std::vector<std::uint64_t>({0, 3, 6, 1, 4, 7, 2, 5, 8}));
+}
+
+TEST_CASE("Testing BenchData: Item types keep key order", "[weight=1]") {
+  std::vector<std::uint64_t> keys = generateBenchKeys(BenchShape::Uniform, 2000, 3);
+  keys.push_back(0);
+  keys.push_back((std::uint64_t(1) << 31) - 1);
+  keys.push_back(0);
+  REQUIRE(keepsKeyOrder<int>(keys));
+  REQUIRE(keepsKeyOrder<std::uint64_t>(keys));
+  REQUIRE(keepsKeyOrder<double>(keys));
+  REQUIRE(keepsKeyOrder<std::string>(keys));
+  REQUIRE(keepsKeyOrder<WideBenchRecord>(keys));
+
+  LinkedList<std::string> list = generateBenchList<std::string>(BenchShape::Reverse, 100, 1);
+  REQUIRE(list.size() == 100);
+  REQUIRE(list.front() == "key-0000000099");
+  REQUIRE(list.mergeSort().isSorted());
+}
@@ -0,0 +1,258 @@
+
+// Tests for ConcurrentLinkedQueue and EpochReclamation.
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../ConcurrentLinkedQueue.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// The baseline: a LinkedList used as a FIFO behind one mutex.
+template <typename T>
+class MutexLinkedListQueue {
+public:
+  void pushBack(const T& newData) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    list_.pushBack(newData);
+  }
+
+  bool popFront(T& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (list_.empty()) return false;
+    out = list_.front();
+    list_.popFront();
+    return true;
+  }
+
+private:
+  std::mutex mutex_;
+  LinkedList<T> list_;
+};
+
+// Half of the threads push opsPerProducer items each while the other half
+// pop until everything has been consumed. Returns millions of items per
+// second through the queue.
+template <typename QueueType>
+static double queueThroughput(int numThreads, int opsPerProducer) {
+  int producers = numThreads / 2 > 0 ? numThreads / 2 : 1;
+  int consumers = numThreads - producers > 0 ? numThreads - producers : 1;
+  long long total = static_cast<long long>(producers) * opsPerProducer;
+
+  QueueType queue;
+  std::atomic<long long> consumed(0);
+  std::vector<std::thread> threads;
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < opsPerProducer; i++) {
+        queue.pushBack(i);
+      }
+    });
+  }
+  for (int c = 0; c < consumers; c++) {
+    threads.emplace_back([&] {
+      int item = 0;
+      while (consumed.load(std::memory_order_relaxed) < total) {
+        if (queue.popFront(item)) {
+          consumed.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  auto stop_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> dur_ms = stop_time - start_time;
+  return total / dur_ms.count() / 1000.0;
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: MPMC queue throughput", "[weight=0][.][bench]") {
+
+  constexpr int TOTAL_OPS = 400000;
+
+  std::cout << std::endl << "Queue throughput in M items/s (" << std::thread::hardware_concurrency()
+    << " hardware threads):" << std::endl;
+  std::cout << "threads  mutex+LinkedList  ConcurrentLinkedQueue" << std::endl;
+  for (int threads = 1; threads <= 32; threads *= 2) {
+    int producers = threads / 2 > 0 ? threads / 2 : 1;
+    int opsPerProducer = TOTAL_OPS / producers;
+    double locked = queueThroughput<MutexLinkedListQueue<int>>(threads, opsPerProducer);
+    double lockFree = queueThroughput<ConcurrentLinkedQueue<int>>(threads, opsPerProducer);
+    std::cout << threads << "\t " << locked << "\t\t   " << lockFree << std::endl;
+  }
+}
+
+// ========================================================================
+// Tests: ConcurrentLinkedQueue
+// ========================================================================
+
+TEST_CASE("Testing ConcurrentLinkedQueue: Single thread FIFO order", "[weight=1]") {
+  ConcurrentLinkedQueue<std::string> queue;
+  std::string item;
+  REQUIRE(queue.empty());
+  REQUIRE(!queue.popFront(item));
+
+  for (int i = 0; i < 1000; i++) {
+    queue.pushBack(std::to_string(i));
+  }
+  REQUIRE(!queue.empty());
+  for (int i = 0; i < 1000; i++) {
+    REQUIRE(queue.popFront(item));
+    REQUIRE(item == std::to_string(i));
+  }
+  REQUIRE(!queue.popFront(item));
+  REQUIRE(queue.empty());
+
+  // Leave a few items behind for the destructor to clean up.
+  queue.pushBack("left");
+  queue.pushBack("over");
+}
+
+// An item that counts how many of it are alive.
+struct LiveQueueItem {
+  static std::atomic<int> live;
+  int value;
+  LiveQueueItem(int v = 0) : value(v) { live++; }
+  LiveQueueItem(const LiveQueueItem& other) : value(other.value) { live++; }
+  LiveQueueItem& operator=(const LiveQueueItem& other) = default;
+  ~LiveQueueItem() { live--; }
+};
+std::atomic<int> LiveQueueItem::live(0);
+
+TEST_CASE("Testing ConcurrentLinkedQueue: Every item is destroyed", "[weight=1]") {
+  LiveQueueItem::live = 0;
+  {
+    ConcurrentLinkedQueue<LiveQueueItem> queue;
+    for (int i = 0; i < 100; i++) {
+      queue.pushBack(LiveQueueItem(i));
+    }
+    LiveQueueItem item;
+    for (int i = 0; i < 60; i++) {
+      REQUIRE(queue.popFront(item));
+      REQUIRE(item.value == i);
+    }
+  }
+  // Retired sentinels are freed once the epoch moves on.
+  for (int i = 0; i < 10; i++) {
+    EpochReclamation::collect();
+  }
+  REQUIRE(LiveQueueItem::live == 0);
+}
+
+TEST_CASE("Testing ConcurrentLinkedQueue: Many producers and consumers", "[weight=1]") {
+  constexpr int PRODUCERS = 4;
+  constexpr int CONSUMERS = 4;
+  constexpr int ITEMS_PER_PRODUCER = 20000;
+
+  ConcurrentLinkedQueue<int> queue;
+  std::vector<std::vector<int>> received(CONSUMERS);
+  std::atomic<int> consumed(0);
+  std::vector<std::thread> threads;
+
+  for (int p = 0; p < PRODUCERS; p++) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+        queue.pushBack(p * ITEMS_PER_PRODUCER + i);
+      }
+    });
+  }
+  for (int c = 0; c < CONSUMERS; c++) {
+    threads.emplace_back([&, c] {
+      int item = 0;
+      while (consumed.load() < PRODUCERS * ITEMS_PER_PRODUCER) {
+        if (queue.popFront(item)) {
+          received[c].push_back(item);
+          consumed++;
+        }
+        else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  SECTION("Checking that every item arrived exactly once") {
+    std::vector<int> seen(PRODUCERS * ITEMS_PER_PRODUCER, 0);
+    for (const auto& items : received) {
+      for (int item : items) {
+        seen[item]++;
+      }
+    }
+    for (int count : seen) {
+      REQUIRE(count == 1);
+    }
+    REQUIRE(queue.empty());
+  }
+
+  SECTION("Checking that each consumer saw each producer's items in order") {
+    for (const auto& items : received) {
+      std::vector<int> last(PRODUCERS, -1);
+      for (int item : items) {
+        int producer = item / ITEMS_PER_PRODUCER;
+        REQUIRE(item > last[producer]);
+        last[producer] = item;
+      }
+    }
+  }
+}
+
+// ========================================================================
+// Tests: EpochReclamation
+// ========================================================================
+
+static std::atomic<int> epochTestFreed(0);
+static void epochTestDeleter(void* ptr) {
+  delete static_cast<int*>(ptr);
+  epochTestFreed++;
+}
+
+TEST_CASE("Testing EpochReclamation: Retired objects wait for readers", "[weight=1]") {
+  epochTestFreed = 0;
+  std::atomic<bool> readerPinned(false);
+  std::atomic<bool> readerRelease(false);
+
+  std::thread reader([&] {
+    EpochGuard guard;
+    readerPinned = true;
+    while (!readerRelease) {
+      std::this_thread::yield();
+    }
+  });
+  while (!readerPinned) {
+    std::this_thread::yield();
+  }
+
+  EpochReclamation::retire(new int(1), &epochTestDeleter);
+  for (int i = 0; i < 10; i++) {
+    EpochReclamation::collect();
+  }
+  // The reader is still pinned, so the epoch can't move far enough.
+  REQUIRE(epochTestFreed == 0);
+
+  readerRelease = true;
+  reader.join();
+  for (int i = 0; i < 10; i++) {
+    EpochReclamation::collect();
+  }
+  REQUIRE(epochTestFreed == 1);
+}
@@ -0,0 +1,240 @@
+
+// Tests for ConcurrentSortedList.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../ConcurrentSortedList.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// Collects the current contents of a ConcurrentSortedList.
+template <typename T>
+static std::vector<T> sortedListContents(const ConcurrentSortedList<T>& list) {
+  std::vector<T> items;
+  list.forEach([&](const T& item) { items.push_back(item); });
+  return items;
+}
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// The baseline: one LinkedList that every thread inserts into under a mutex.
+template <typename T>
+class MutexSortedLinkedList {
+public:
+  void insertOrdered(const T& newData) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    list_.insertOrdered(newData);
+  }
+
+private:
+  std::mutex mutex_;
+  LinkedList<T> list_;
+};
+
+// numThreads threads each insert insertsPerThread random keys from
+// [0, keyRange) into one shared list. Returns millions of inserts per second.
+template <typename ListType>
+static double sortedInsertThroughput(int numThreads, int insertsPerThread, int keyRange) {
+  ListType list;
+  std::vector<std::thread> threads;
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (int t = 0; t < numThreads; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t + 1);
+      std::uniform_int_distribution<int> keys(0, keyRange - 1);
+      for (int i = 0; i < insertsPerThread; i++) {
+        list.insertOrdered(keys(rng));
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  auto stop_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> dur_ms = stop_time - start_time;
+  return static_cast<double>(numThreads) * insertsPerThread / dur_ms.count() / 1000.0;
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: Concurrent insertOrdered", "[weight=0][.][bench]") {
+
+  // The list ends up this long, so each insert walks about half of it.
+  constexpr int TOTAL_INSERTS = 8000;
+
+  std::cout << std::endl << "insertOrdered throughput in M inserts/s (" << std::thread::hardware_concurrency()
+    << " hardware threads):" << std::endl;
+  std::cout << "keys\tthreads  mutex+LinkedList  ConcurrentSortedList" << std::endl;
+  for (int keyRange : {16, 1024, 1 << 20}) {
+    for (int threads = 1; threads <= 8; threads *= 2) {
+      int insertsPerThread = TOTAL_INSERTS / threads;
+      double locked = sortedInsertThroughput<MutexSortedLinkedList<int>>(threads, insertsPerThread, keyRange);
+      double lockFree = sortedInsertThroughput<ConcurrentSortedList<int>>(threads, insertsPerThread, keyRange);
+      std::cout << keyRange << "\t" << threads << "\t " << locked << "\t\t   " << lockFree << std::endl;
+    }
+  }
+}
+
+// ========================================================================
+// Tests
+// ========================================================================
+
+TEST_CASE("Testing ConcurrentSortedList: Matches LinkedList::insertOrdered", "[weight=1]") {
+  ConcurrentSortedList<int> list;
+  LinkedList<int> expected;
+  REQUIRE(list.empty());
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> keys(0, 50);
+  for (int i = 0; i < 500; i++) {
+    int key = keys(rng);
+    list.insertOrdered(key);
+    expected.insertOrdered(key);
+  }
+
+  REQUIRE(list.size() == 500);
+  std::vector<int> items = sortedListContents(list);
+  std::vector<int> expectedItems;
+  for (const auto* cur = expected.getHeadPtr(); cur; cur = cur->next) {
+    expectedItems.push_back(cur->data);
+  }
+  REQUIRE(items == expectedItems);
+}
+
+// Compares by key only, so that equal items can be told apart.
+struct KeyedItem {
+  int key;
+  int id;
+  bool operator<(const KeyedItem& other) const { return key < other.key; }
+};
+
+TEST_CASE("Testing ConcurrentSortedList: Equal items keep insertion order", "[weight=1]") {
+  ConcurrentSortedList<KeyedItem> list;
+  for (int id = 0; id < 30; id++) {
+    list.insertOrdered(KeyedItem{id % 3, id});
+  }
+  std::vector<KeyedItem> items = sortedListContents(list);
+  REQUIRE(items.size() == 30);
+  for (std::size_t i = 1; i < items.size(); i++) {
+    REQUIRE(items[i - 1].key <= items[i].key);
+    if (items[i - 1].key == items[i].key) {
+      REQUIRE(items[i - 1].id < items[i].id);
+    }
+  }
+
+  // erase removes the first of the equal items.
+  REQUIRE(list.erase(KeyedItem{1, -1}));
+  items = sortedListContents(list);
+  REQUIRE(items[10].key == 1);
+  REQUIRE(items[10].id == 4);
+}
+
+TEST_CASE("Testing ConcurrentSortedList: erase and contains", "[weight=1]") {
+  ConcurrentSortedList<std::string> list;
+  list.insertOrdered("c");
+  list.insertOrdered("a");
+  list.insertOrdered("b");
+  list.insertOrdered("b");
+
+  REQUIRE(list.contains("a"));
+  REQUIRE(list.contains("b"));
+  REQUIRE(!list.contains("d"));
+
+  REQUIRE(list.erase("b"));
+  REQUIRE(list.contains("b"));
+  REQUIRE(list.erase("b"));
+  REQUIRE(!list.contains("b"));
+  REQUIRE(!list.erase("b"));
+  REQUIRE(!list.erase("z"));
+
+  REQUIRE(list.size() == 2);
+  REQUIRE(sortedListContents(list) == std::vector<std::string>({"a", "c"}));
+
+  REQUIRE(list.erase("a"));
+  REQUIRE(list.erase("c"));
+  REQUIRE(list.empty());
+  REQUIRE(sortedListContents(list).empty());
+}
+
+TEST_CASE("Testing ConcurrentSortedList: Concurrent inserts", "[weight=1]") {
+  constexpr int THREADS = 4;
+  constexpr int INSERTS_PER_THREAD = 2000;
+
+  ConcurrentSortedList<int> list;
+  std::vector<std::vector<int>> inserted(THREADS);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t + 7);
+      std::uniform_int_distribution<int> keys(0, 200);
+      for (int i = 0; i < INSERTS_PER_THREAD; i++) {
+        int key = keys(rng);
+        list.insertOrdered(key);
+        inserted[t].push_back(key);
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  std::vector<int> expected;
+  for (const auto& keys : inserted) {
+    expected.insert(expected.end(), keys.begin(), keys.end());
+  }
+  std::sort(expected.begin(), expected.end());
+
+  REQUIRE(list.size() == THREADS * INSERTS_PER_THREAD);
+  REQUIRE(sortedListContents(list) == expected);
+}
+
+TEST_CASE("Testing ConcurrentSortedList: Concurrent inserts and erases", "[weight=1]") {
+  constexpr int THREADS = 4;
+  constexpr int KEYS_PER_THREAD = 2000;
+
+  // Thread t owns the keys equal to t modulo THREADS, inserts all of them,
+  // and erases every other one, while the others do the same next to it.
+  ConcurrentSortedList<int> list;
+  std::atomic<int> failedErases(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < KEYS_PER_THREAD; i++) {
+        list.insertOrdered(i * THREADS + t);
+        if (i % 2 == 1 && !list.erase((i - 1) * THREADS + t)) {
+          failedErases++;
+        }
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  REQUIRE(failedErases == 0);
+  std::vector<int> expected;
+  for (int i = 0; i < KEYS_PER_THREAD; i++) {
+    if (i % 2 == 1) {
+      for (int t = 0; t < THREADS; t++) {
+        expected.push_back(i * THREADS + t);
+      }
+    }
+  }
+  REQUIRE(list.size() == static_cast<int>(expected.size()));
+  REQUIRE(sortedListContents(list) == expected);
+  for (int key : expected) {
+    REQUIRE(list.contains(key));
+  }
+  REQUIRE(!list.contains(0));
+}
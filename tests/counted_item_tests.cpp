@@ -0,0 +1,72 @@
+
+// Tests for the operation counting wrapper in CountedItem.h.
+
+#include <sstream>
+#include <utility>
+
+#include "../CountedItem.h"
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+TEST_CASE("Testing Counted: Each operation is counted once", "[weight=1]") {
+  Counted<int> a = 1;
+  Counted<int> b = 2;
+
+  CountedOps ops = measureCountedOps([&] {
+    REQUIRE(a < b);
+    REQUIRE(a <= b);
+    REQUIRE(b > a);
+    REQUIRE(b >= a);
+    REQUIRE_FALSE(a == b);
+    REQUIRE(a != b);
+  });
+  REQUIRE(ops.comparisons == 6);
+  REQUIRE(ops.copies == 0);
+
+  ops = measureCountedOps([&] {
+    Counted<int> c = a;
+    Counted<int> d = std::move(c);
+    c = d;
+    d = std::move(b);
+    REQUIRE(d.value() == 2);
+  });
+  REQUIRE(ops.comparisons == 0);
+  REQUIRE(ops.copies == 1);
+  REQUIRE(ops.moves == 1);
+  REQUIRE(ops.copyAssignments == 1);
+  REQUIRE(ops.moveAssignments == 1);
+
+  // Making an item from a plain value isn't counted.
+  ops = measureCountedOps([] { Counted<int> e(5); });
+  REQUIRE(ops.copies == 0);
+  REQUIRE(ops.moves == 0);
+}
+
+TEST_CASE("Testing Counted: Counting list algorithms", "[weight=1]") {
+  LinkedList<Counted<int>> left;
+  LinkedList<Counted<int>> right;
+  for (int i = 0; i < 3; i++) {
+    left.pushBack(2 * i + 1);
+    right.pushBack(2 * i + 2);
+  }
+
+  // merge compares until one side runs out: 1<2, 3<2, 3<4, 5<4, 5<6.
+  LinkedList<Counted<int>> merged;
+  CountedOps ops = measureCountedOps([&] { merged = left.merge(right); });
+  REQUIRE(ops.comparisons == 5);
+  REQUIRE(merged.size() == 6);
+  REQUIRE(ops.copies >= 6);
+
+  std::ostringstream text;
+  merged.print(text);
+  REQUIRE(text.str() == "[(1)(2)(3)(4)(5)(6)]");
+
+  // A merge sort makes at most n ceil(log2 n) comparisons.
+  LinkedList<Counted<int>> list;
+  for (int i = 0; i < 64; i++) list.pushBack((i * 37) % 64);
+  ops = measureCountedOps([&] { REQUIRE(list.mergeSortRecursive().isSorted()); });
+  REQUIRE(ops.comparisons > 64 + 63);
+  REQUIRE(ops.comparisons <= 64 * 6 + 63);
+}
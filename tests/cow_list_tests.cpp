@@ -0,0 +1,214 @@
+
+// Tests for CowLinkedList.
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../CowLinkedList.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// A HeapNodeAllocator that counts the nodes it allocates.
+class CountingNodeAllocator {
+public:
+  static std::atomic<long long> nodesAllocated;
+  static constexpr bool releasesInBulk = false;
+
+  template <typename NodeT>
+  void* allocate() {
+    nodesAllocated++;
+    return ::operator new(sizeof(NodeT));
+  }
+
+  template <typename NodeT>
+  void deallocate(NodeT* node) {
+    ::operator delete(node);
+  }
+
+  void release() {}
+};
+std::atomic<long long> CountingNodeAllocator::nodesAllocated(0);
+
+using CountedList = LinkedList<int, CountingNodeAllocator>;
+using CountedCowList = CowLinkedList<int, CountingNodeAllocator>;
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// Runs work() and prints its time and the list nodes it allocated.
+template <typename Work>
+static void reportAllocations(const std::string& label, Work work) {
+  CountingNodeAllocator::nodesAllocated = 0;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  work();
+  auto stop_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> dur_ms = stop_time - start_time;
+  std::cout << label << "\t" << dur_ms.count() << " ms\t" << CountingNodeAllocator::nodesAllocated << " nodes" << std::endl;
+}
+
+// The main.cpp pattern: walk a list of lists, taking a copy of each inner
+// list with "auto list = nodePtr->data;" and only reading it.
+template <typename InnerList>
+static long long readCopies(const LinkedList<InnerList>& lists, int passes) {
+  long long sum = 0;
+  for (int pass = 0; pass < passes; pass++) {
+    for (const auto* nodePtr = lists.getHeadPtr(); nodePtr; nodePtr = nodePtr->next) {
+      auto list = nodePtr->data;
+      sum += list.size() + list.front() + list.back();
+    }
+  }
+  return sum;
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: Copy-on-write copies", "[weight=0][.][bench]") {
+
+  constexpr int LISTS = 100;
+  constexpr int ITEMS = 200;
+  constexpr int PASSES = 20;
+  constexpr int MUTATIONS = 200000;
+
+  LinkedList<CountedList> plainLists;
+  LinkedList<CountedCowList> cowLists;
+  for (int i = 0; i < LISTS; i++) {
+    CountedList inner;
+    for (int j = 0; j < ITEMS; j++) {
+      inner.pushBack(i * ITEMS + j);
+    }
+    plainLists.pushBack(inner);
+    cowLists.pushBack(CountedCowList(inner));
+  }
+
+  std::cout << std::endl << "Read-only copies of " << LISTS << " lists of " << ITEMS << " items, "
+    << PASSES << " passes:" << std::endl;
+  long long plainSum = 0;
+  long long cowSum = 0;
+  reportAllocations("LinkedList     ", [&] { plainSum = readCopies(plainLists, PASSES); });
+  reportAllocations("CowLinkedList  ", [&] { cowSum = readCopies(cowLists, PASSES); });
+  REQUIRE(plainSum == cowSum);
+
+  // The overhead on mutations of an unshared list is one reference count
+  // check per call.
+  std::cout << MUTATIONS << " pushBack/popFront pairs on an unshared list:" << std::endl;
+  reportAllocations("LinkedList     ", [&] {
+    CountedList list;
+    for (int i = 0; i < MUTATIONS; i++) {
+      list.pushBack(i);
+      list.popFront();
+    }
+  });
+  reportAllocations("CowLinkedList  ", [&] {
+    CountedCowList list;
+    for (int i = 0; i < MUTATIONS; i++) {
+      list.pushBack(i);
+      list.popFront();
+    }
+  });
+}
+
+// ========================================================================
+// Tests
+// ========================================================================
+
+TEST_CASE("Testing CowLinkedList: Copies share nodes until mutated", "[weight=1]") {
+  CountedList original;
+  for (int i = 0; i < 10; i++) {
+    original.pushBack(i);
+  }
+
+  CountingNodeAllocator::nodesAllocated = 0;
+  CountedCowList a(original);
+  REQUIRE(CountingNodeAllocator::nodesAllocated == 10);
+  CountedCowList b = a;
+  CountedCowList c;
+  c = b;
+  REQUIRE(CountingNodeAllocator::nodesAllocated == 10);
+  REQUIRE(a.isShared());
+  REQUIRE(&a.get() == &c.get());
+  REQUIRE(b == a);
+  REQUIRE(b.size() == 10);
+  REQUIRE(b.front() == 0);
+  REQUIRE(b.back() == 9);
+  REQUIRE(CountingNodeAllocator::nodesAllocated == 10);
+
+  // The first mutation clones; the others don't see it.
+  b.pushBack(10);
+  REQUIRE(CountingNodeAllocator::nodesAllocated == 21);
+  REQUIRE(!b.isShared());
+  REQUIRE(b.size() == 11);
+  REQUIRE(a.size() == 10);
+  REQUIRE(c.get() == original);
+  b.popFront();
+  b.popBack();
+  REQUIRE(CountingNodeAllocator::nodesAllocated == 21);
+  REQUIRE(b != a);
+
+  std::stringstream out;
+  out << a;
+  REQUIRE(out.str() == "[(0)(1)(2)(3)(4)(5)(6)(7)(8)(9)]");
+}
+
+TEST_CASE("Testing CowLinkedList: insertOrdered and clear", "[weight=1]") {
+  CowLinkedList<int> a;
+  for (int i : {1, 3, 5}) {
+    a.pushBack(i);
+  }
+  CowLinkedList<int> b = a;
+  b.insertOrdered(4);
+  REQUIRE(a.get().size() == 3);
+  REQUIRE(b.isSorted());
+  REQUIRE(b.size() == 4);
+
+  // Clearing a shared copy starts a new list without cloning.
+  CowLinkedList<int> c = a;
+  c.clear();
+  REQUIRE(c.empty());
+  REQUIRE(!c.isShared());
+  REQUIRE(a.size() == 3);
+  REQUIRE(!a.isShared());
+  a.clear();
+  REQUIRE(a.empty());
+
+  // edit() gives full access to the LinkedList.
+  CowLinkedList<int> d = b;
+  d.edit() = d.get().mergeSort();
+  d.edit().popFront();
+  REQUIRE(d.size() == 3);
+  REQUIRE(b.size() == 4);
+}
+
+TEST_CASE("Testing CowLinkedList: Copies mutated on several threads", "[weight=1]") {
+  constexpr int THREADS = 4;
+  CowLinkedList<int> original;
+  for (int i = 0; i < 100; i++) {
+    original.pushBack(i);
+  }
+
+  std::vector<int> finalSizes(THREADS);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; t++) {
+    threads.emplace_back([&, t] {
+      CowLinkedList<int> mine = original;
+      for (int i = 0; i < 1000; i++) {
+        CowLinkedList<int> snapshot = mine;
+        mine.pushBack(i);
+        if (snapshot.size() + 1 != mine.size()) return;
+      }
+      finalSizes[t] = mine.size();
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  for (int size : finalSizes) {
+    REQUIRE(size == 1100);
+  }
+  REQUIRE(original.size() == 100);
+}
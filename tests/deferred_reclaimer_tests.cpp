@@ -0,0 +1,207 @@
+
+// Tests for deferred node deallocation with DeferredNodeReclaimer.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// An item type that counts how many instances have been destroyed and how
+// many are still alive. (The background reclaimer destroys items on its own
+// thread, hence the atomics.)
+struct DestructionCounter {
+  static std::atomic<int> destroyed;
+  static std::atomic<int> live;
+  int value;
+  DestructionCounter() : value(0) { live++; }
+  DestructionCounter(int v) : value(v) { live++; }
+  DestructionCounter(const DestructionCounter& other) : value(other.value) { live++; }
+  DestructionCounter& operator=(const DestructionCounter& other) {
+    value = other.value;
+    return *this;
+  }
+  ~DestructionCounter() {
+    destroyed++;
+    live--;
+  }
+  bool operator<(const DestructionCounter& other) const { return value < other.value; }
+  bool operator<=(const DestructionCounter& other) const { return value <= other.value; }
+  bool operator!=(const DestructionCounter& other) const { return value != other.value; }
+};
+std::atomic<int> DestructionCounter::destroyed(0);
+std::atomic<int> DestructionCounter::live(0);
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// Simulates a request handler that builds, sorts and drops a temporary list,
+// and returns the latency of each request in microseconds.
+static std::vector<double> runRequests(int numRequests, int listSize, DeferredNodeReclaimer* reclaimer, std::size_t reclaimPerIdle) {
+  std::vector<double> latencies;
+  latencies.reserve(numRequests);
+  for (int r = 0; r < numRequests; r++) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    {
+      LinkedList<int> input;
+      for (int i = listSize; i > 0; i--) {
+        input.pushBack((i * 7919) % listSize);
+      }
+      LinkedList<int> sorted = input.mergeSort();
+      if (sorted.size() != listSize) std::cout << "WARNING: List size didn't match!" << std::endl;
+    }
+    auto stop_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::micro> dur_us = stop_time - start_time;
+    latencies.push_back(dur_us.count());
+
+    // Between requests, the incremental reclaimer gets a bounded slice of work.
+    if (reclaimer && reclaimPerIdle) reclaimer->reclaimSome(reclaimPerIdle);
+  }
+  return latencies;
+}
+
+static void reportLatencies(const char* label, std::vector<double> latencies) {
+  std::sort(latencies.begin(), latencies.end());
+  auto pct = [&](double p) { return latencies[static_cast<std::size_t>(p * (latencies.size() - 1))]; };
+  std::cout << label << ": p50 " << pct(0.50) << "us, p99 " << pct(0.99)
+    << "us, max " << latencies.back() << "us" << std::endl;
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: Request latency with deferred list destruction", "[weight=0][.][bench]") {
+
+  constexpr int NUM_REQUESTS = 200;
+  constexpr int LIST_SIZE = 20000;
+
+  std::cout << std::endl << "Latency of " << NUM_REQUESTS << " requests that each sort a list of "
+    << LIST_SIZE << " items:" << std::endl;
+
+  reportLatencies("Synchronous free", runRequests(NUM_REQUESTS, LIST_SIZE, nullptr, 0));
+
+  {
+    DeferredNodeReclaimer reclaimer(DeferredNodeReclaimer::Mode::Background);
+    ScopedDeferredFree deferred(reclaimer);
+    reportLatencies("Background reclaimer", runRequests(NUM_REQUESTS, LIST_SIZE, nullptr, 0));
+  }
+
+  {
+    DeferredNodeReclaimer reclaimer(DeferredNodeReclaimer::Mode::Incremental);
+    ScopedDeferredFree deferred(reclaimer);
+    reportLatencies("Incremental reclaimer", runRequests(NUM_REQUESTS, LIST_SIZE, &reclaimer, 1 << 20));
+    auto stats = reclaimer.stats();
+    std::cout << "Incremental reclaimer left " << stats.pendingNodes << " nodes ("
+      << stats.pendingBytes << " bytes) pending" << std::endl;
+  }
+}
+
+// ========================================================================
+// Tests: DeferredNodeReclaimer
+// ========================================================================
+
+TEST_CASE("Testing DeferredNodeReclaimer: Incremental mode", "[weight=1]") {
+  DestructionCounter::destroyed = 0;
+  DeferredNodeReclaimer reclaimer(DeferredNodeReclaimer::Mode::Incremental, 1000, DeferredNodeReclaimer::Backpressure::Block, 10);
+
+  {
+    ScopedDeferredFree deferred(reclaimer);
+    LinkedList<DestructionCounter> l;
+    for (int i = 0; i < 100; i++) {
+      l.pushBack(i);
+    }
+    DestructionCounter::destroyed = 0;
+    l.clear();
+    REQUIRE(l.empty());
+    REQUIRE(l.size() == 0);
+    REQUIRE(DestructionCounter::destroyed == 0);
+  }
+
+  SECTION("Checking that the detached chain is reported as pending") {
+    auto stats = reclaimer.stats();
+    REQUIRE(stats.pendingChains == 1);
+    REQUIRE(stats.pendingNodes == 100);
+    REQUIRE(stats.pendingBytes == 100 * sizeof(LinkedList<DestructionCounter>::Node));
+  }
+
+  SECTION("Checking that reclaimSome frees at most the given number of nodes") {
+    REQUIRE(reclaimer.reclaimSome(30) == 30);
+    REQUIRE(DestructionCounter::destroyed == 30);
+    REQUIRE(reclaimer.stats().pendingNodes == 70);
+    reclaimer.drain();
+    REQUIRE(DestructionCounter::destroyed == 100);
+    REQUIRE(reclaimer.stats().pendingNodes == 0);
+    REQUIRE(reclaimer.stats().pendingBytes == 0);
+    REQUIRE(reclaimer.stats().pendingChains == 0);
+  }
+}
+
+TEST_CASE("Testing DeferredNodeReclaimer: Short lists are freed directly", "[weight=1]") {
+  DeferredNodeReclaimer reclaimer(DeferredNodeReclaimer::Mode::Incremental, 1000, DeferredNodeReclaimer::Backpressure::Block, 10);
+  ScopedDeferredFree deferred(reclaimer);
+  {
+    LinkedList<int> l;
+    for (int i = 0; i < 5; i++) {
+      l.pushBack(i);
+    }
+  }
+  REQUIRE(reclaimer.stats().submittedChains == 0);
+}
+
+TEST_CASE("Testing DeferredNodeReclaimer: Backpressure", "[weight=1]") {
+  DestructionCounter::destroyed = 0;
+  DeferredNodeReclaimer reclaimer(DeferredNodeReclaimer::Mode::Incremental, 150, DeferredNodeReclaimer::Backpressure::FreeInline, 10);
+  ScopedDeferredFree deferred(reclaimer);
+  for (int round = 0; round < 2; round++) {
+    LinkedList<DestructionCounter> l;
+    for (int i = 0; i < 100; i++) {
+      l.pushBack(i);
+    }
+    DestructionCounter::destroyed = 0;
+  }
+  // The second list didn't fit in the queue, so it was freed right away.
+  REQUIRE(DestructionCounter::destroyed == 100);
+  auto stats = reclaimer.stats();
+  REQUIRE(stats.pendingNodes == 100);
+  REQUIRE(stats.inlineFreedNodes == 100);
+}
+
+TEST_CASE("Testing DeferredNodeReclaimer: Background mode", "[weight=1]") {
+  int liveBefore = DestructionCounter::live;
+  std::uint64_t submitted = 0;
+  {
+    DeferredNodeReclaimer reclaimer(DeferredNodeReclaimer::Mode::Background, 500, DeferredNodeReclaimer::Backpressure::Block, 10);
+    ScopedDeferredFree deferred(reclaimer);
+    for (int round = 0; round < 20; round++) {
+      LinkedList<DestructionCounter> l;
+      for (int i = 0; i < 100; i++) {
+        l.pushBack(i);
+      }
+      LinkedList<DestructionCounter> sorted = l.mergeSort();
+      REQUIRE(sorted.isSorted());
+    }
+    submitted = reclaimer.stats().submittedChains;
+  }
+  // Every node that was submitted has been freed by the time the reclaimer
+  // is destroyed, so all the items have been destroyed too.
+  REQUIRE(submitted > 0);
+  REQUIRE(DestructionCounter::live == liveBefore);
+}
+
+TEST_CASE("Testing DeferredNodeReclaimer: Nested lists", "[weight=1]") {
+  DeferredNodeReclaimer reclaimer(DeferredNodeReclaimer::Mode::Background, 1000, DeferredNodeReclaimer::Backpressure::Block, 2);
+  ScopedDeferredFree deferred(reclaimer);
+  LinkedList<int> l;
+  for (int i = 100; i > 0; i--) {
+    l.pushBack(i);
+  }
+  auto lists = l.explode();
+  REQUIRE(lists.size() == 100);
+  auto sorted = l.mergeSortIterative();
+  REQUIRE(sorted.isSorted());
+  REQUIRE(sorted.assertPrevLinks());
+}
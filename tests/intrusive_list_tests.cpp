@@ -0,0 +1,197 @@
+
+// Tests for IntrusiveLinkedList.
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../IntrusiveLinkedList.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// A 256-byte record type that carries its own list links.
+struct IntrusiveRecord {
+  int key;
+  int seq;
+  char payload[232];
+  IntrusiveListHook<IntrusiveRecord> hook;
+
+  IntrusiveRecord() : key(0), seq(0) {}
+  IntrusiveRecord(int k, int s) : key(k), seq(s) {
+    std::memset(payload, k & 0xff, sizeof(payload));
+  }
+  bool operator<(const IntrusiveRecord& other) const { return key < other.key; }
+  bool operator<=(const IntrusiveRecord& other) const { return key <= other.key; }
+  bool operator!=(const IntrusiveRecord& other) const { return key != other.key || seq != other.seq; }
+};
+
+using RecordList = IntrusiveLinkedList<IntrusiveRecord, &IntrusiveRecord::hook>;
+
+static std::vector<int> keysOf(const RecordList& l) {
+  std::vector<int> keys;
+  for (const IntrusiveRecord* cur = l.getHeadPtr(); cur; cur = RecordList::next(cur)) {
+    keys.push_back(cur->key);
+  }
+  return keys;
+}
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: Sorting 256-byte records", "[weight=0][.][bench]") {
+
+  constexpr int LIST_SIZE = 100000;
+
+  std::cout << std::endl << "Sorting " << LIST_SIZE << " records of " << sizeof(IntrusiveRecord)
+    << " bytes:" << std::endl;
+
+  std::vector<IntrusiveRecord> storage;
+  storage.reserve(LIST_SIZE);
+  for (int i = 0; i < LIST_SIZE; i++) {
+    storage.emplace_back((i * 7919) % LIST_SIZE, i);
+  }
+
+  {
+    LinkedList<IntrusiveRecord> list;
+    for (const IntrusiveRecord& r : storage) {
+      list.pushBack(r);
+    }
+    auto start_time = std::chrono::high_resolution_clock::now();
+    LinkedList<IntrusiveRecord> sorted = list.mergeSort();
+    auto stop_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> dur_ms = stop_time - start_time;
+    if (!sorted.isSorted()) std::cout << "WARNING: mergeSort result not sorted." << std::endl;
+    std::cout << "LinkedList<Record>::mergeSort(): " << dur_ms.count() << "ms" << std::endl;
+  }
+
+  {
+    RecordList list;
+    for (IntrusiveRecord& r : storage) {
+      list.pushBack(r);
+    }
+    auto start_time = std::chrono::high_resolution_clock::now();
+    list.mergeSort();
+    auto stop_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> dur_ms = stop_time - start_time;
+    if (!list.isSorted()) std::cout << "WARNING: mergeSort result not sorted." << std::endl;
+    std::cout << "IntrusiveLinkedList<Record>::mergeSort(): " << dur_ms.count() << "ms" << std::endl;
+  }
+}
+
+// ========================================================================
+// Tests: IntrusiveLinkedList
+// ========================================================================
+
+TEST_CASE("Testing IntrusiveLinkedList: Push and pop", "[weight=1]") {
+  std::vector<IntrusiveRecord> records;
+  for (int i = 0; i < 5; i++) {
+    records.emplace_back(i, i);
+  }
+  RecordList l;
+  l.pushBack(records[2]);
+  l.pushBack(records[3]);
+  l.pushFront(records[1]);
+  l.pushFront(records[0]);
+  l.pushBack(records[4]);
+
+  SECTION("Checking that the items are linked in place") {
+    REQUIRE(keysOf(l) == std::vector<int>({0, 1, 2, 3, 4}));
+    REQUIRE(l.getHeadPtr() == &records[0]);
+    REQUIRE(l.getTailPtr() == &records[4]);
+    REQUIRE(l.assertPrevLinks());
+    REQUIRE(l.assertCorrectSize());
+  }
+
+  SECTION("Checking that pops unlink and return the items") {
+    REQUIRE(l.popFront() == &records[0]);
+    REQUIRE(l.popBack() == &records[4]);
+    REQUIRE(records[0].hook.next == nullptr);
+    REQUIRE(records[4].hook.prev == nullptr);
+    REQUIRE(l.size() == 3);
+    REQUIRE(l.assertPrevLinks());
+    l.erase(records[2]);
+    REQUIRE(keysOf(l) == std::vector<int>({1, 3}));
+    REQUIRE(l.popFront() == &records[1]);
+    REQUIRE(l.popFront() == &records[3]);
+    REQUIRE(l.popFront() == nullptr);
+    REQUIRE(l.empty());
+    REQUIRE(l.getTailPtr() == nullptr);
+  }
+}
+
+TEST_CASE("Testing IntrusiveLinkedList: insertOrdered", "[weight=1]") {
+  std::vector<IntrusiveRecord> records = {
+    IntrusiveRecord(5, 0), IntrusiveRecord(1, 1), IntrusiveRecord(9, 2),
+    IntrusiveRecord(5, 3), IntrusiveRecord(-3, 4), IntrusiveRecord(12, 5)
+  };
+  RecordList l;
+  for (IntrusiveRecord& r : records) {
+    l.insertOrdered(r);
+  }
+  REQUIRE(keysOf(l) == std::vector<int>({-3, 1, 5, 5, 9, 12}));
+  // The later 5 goes after the earlier one, before the first greater item.
+  REQUIRE(RecordList::next(&records[0]) == &records[3]);
+  REQUIRE(l.assertPrevLinks());
+  REQUIRE(l.assertCorrectSize());
+}
+
+TEST_CASE("Testing IntrusiveLinkedList: merge", "[weight=1]") {
+  std::vector<IntrusiveRecord> records;
+  for (int i = 0; i < 10; i++) {
+    records.emplace_back(i / 2, i);
+  }
+  RecordList left;
+  RecordList right;
+  for (int i = 0; i < 10; i++) {
+    if (i % 3 == 0) left.pushBack(records[i]);
+    else right.pushBack(records[i]);
+  }
+  left.merge(right);
+
+  REQUIRE(right.empty());
+  REQUIRE(right.size() == 0);
+  REQUIRE(left.size() == 10);
+  REQUIRE(left.isSorted());
+  REQUIRE(left.assertPrevLinks());
+  REQUIRE(left.assertCorrectSize());
+  // Equal keys keep the items from the left list first.
+  REQUIRE(RecordList::next(&records[0]) == &records[1]);
+  REQUIRE(RecordList::next(&records[6]) == &records[7]);
+}
+
+TEST_CASE("Testing IntrusiveLinkedList: mergeSort", "[weight=1]") {
+  std::vector<IntrusiveRecord> records;
+  for (int i = 0; i < 1001; i++) {
+    records.emplace_back((i * 37) % 101, i);
+  }
+  RecordList l;
+  for (IntrusiveRecord& r : records) {
+    l.pushBack(r);
+  }
+  l.mergeSort();
+
+  SECTION("Checking that the list is sorted and consistent") {
+    REQUIRE(l.isSorted());
+    REQUIRE(l.size() == 1001);
+    REQUIRE(l.assertPrevLinks());
+    REQUIRE(l.assertCorrectSize());
+  }
+
+  SECTION("Checking that the sort is stable") {
+    for (const IntrusiveRecord* cur = l.getHeadPtr(); RecordList::next(cur); cur = RecordList::next(cur)) {
+      const IntrusiveRecord* next = RecordList::next(cur);
+      if (cur->key == next->key) REQUIRE(cur->seq < next->seq);
+    }
+  }
+
+  SECTION("Checking that the records themselves didn't move") {
+    for (int i = 0; i < 1001; i++) {
+      REQUIRE(records[i].seq == i);
+    }
+  }
+}
@@ -0,0 +1,106 @@
+
+// Tests for the latency histograms in bench/LatencyHistogram.h.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../bench/LatencyHistogram.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+TEST_CASE("Testing LatencyHistogram: Buckets cover every value with bounded error", "[weight=1]") {
+  using H = LatencyHistogram;
+  REQUIRE(H::bucketOf(0) == 0);
+  REQUIRE(H::bucketOf(UINT64_MAX) == H::BUCKETS - 1);
+  REQUIRE(H::bucketHighest(H::BUCKETS - 1) == UINT64_MAX);
+
+  // The buckets are contiguous, and each is at most 1/64th of its values wide.
+  for (std::size_t i = 0; i + 1 < H::BUCKETS; i++) {
+    REQUIRE(H::bucketHighest(i) + 1 == H::bucketLowest(i + 1));
+    std::uint64_t width = H::bucketHighest(i) - H::bucketLowest(i);
+    REQUIRE(width <= H::bucketLowest(i) / 64);
+  }
+
+  std::vector<std::uint64_t> values = {1, 127, 128, 129, 1000, 123456789, std::uint64_t(1) << 40, UINT64_MAX - 1};
+  for (std::uint64_t v : values) {
+    std::size_t bucket = H::bucketOf(v);
+    REQUIRE(H::bucketLowest(bucket) <= v);
+    REQUIRE(v <= H::bucketHighest(bucket));
+  }
+}
+
+TEST_CASE("Testing LatencyHistogram: Percentiles, merging and export", "[weight=1]") {
+  LatencyHistogram histogram;
+  REQUIRE(histogram.count() == 0);
+  REQUIRE(histogram.percentile(50) == 0);
+
+  for (std::uint64_t v = 1; v <= 10000; v++) histogram.record(v);
+  REQUIRE(histogram.count() == 10000);
+  REQUIRE(histogram.minimum() == 1);
+  REQUIRE(histogram.maximum() == 10000);
+  REQUIRE(histogram.percentile(100) == 10000);
+  REQUIRE(histogram.percentile(0) == 1);
+  // Within the bucket error of the true percentiles.
+  REQUIRE(histogram.percentile(50) >= 5000);
+  REQUIRE(histogram.percentile(50) <= 5000 + 5000 / 64);
+  REQUIRE(histogram.percentile(99.9) >= 9990);
+  REQUIRE(histogram.mean() == Approx(5000.5).epsilon(0.01));
+
+  LatencyHistogram other;
+  other.record(1000000);
+  histogram.merge(other);
+  REQUIRE(histogram.count() == 10001);
+  REQUIRE(histogram.maximum() == 1000000);
+  REQUIRE(histogram.minimum() == 1);
+  REQUIRE(histogram.percentile(100) == 1000000);
+
+  std::FILE* file = std::tmpfile();
+  REQUIRE(file != nullptr);
+  histogram.writePercentiles(file);
+  std::rewind(file);
+  char line[256];
+  std::vector<std::string> lines;
+  while (std::fgets(line, sizeof(line), file)) lines.push_back(line);
+  std::fclose(file);
+  REQUIRE(lines.size() > 10);
+  REQUIRE(lines[0].find("Percentile") != std::string::npos);
+  REQUIRE(lines[lines.size() - 2].find("Total count    =        10001") != std::string::npos);
+
+  histogram.reset();
+  REQUIRE(histogram.count() == 0);
+  REQUIRE(histogram.maximum() == 0);
+}
+
+TEST_CASE("Testing LatencyRecorder: Threads record separately and merge", "[weight=1]") {
+  LatencyRecorder recorder;
+  // Catch assertions aren't thread-safe, so the threads only report back.
+  std::atomic<int> ownHistograms(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&recorder, &ownHistograms, t] {
+      for (int i = 0; i < 1000; i++) recorder.record(static_cast<std::uint64_t>(t * 1000 + i));
+      // Each thread keeps getting its own histogram.
+      if (recorder.local().count() == 1000) ownHistograms++;
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  REQUIRE(ownHistograms == 4);
+
+  LatencyHistogram total;
+  recorder.snapshot(total);
+  REQUIRE(total.count() == 4000);
+  REQUIRE(total.minimum() == 0);
+  REQUIRE(total.maximum() == 3999);
+
+  // A second recorder on this thread doesn't share the first one's
+  // histograms.
+  recorder.record(5);
+  LatencyRecorder second;
+  second.record(7);
+  second.snapshot(total);
+  REQUIRE(total.count() == 1);
+}
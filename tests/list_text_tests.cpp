@@ -0,0 +1,371 @@
+
+// Tests for the buffered print() path and the text parser in ListText.h.
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../ListText.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// A file name in /tmp that no other test process will use.
+static std::string tempTextPath(const std::string& name) {
+  return "/tmp/linked_list_" + std::to_string(::getpid()) + "_" + name;
+}
+
+// What print() used to do for every list: one operator<< call per piece.
+template <typename T, typename Alloc>
+static std::ostream& printThroughStream(std::ostream& os, const LinkedList<T, Alloc>& list) {
+  os << "[";
+  for (const auto* cur = list.getHeadPtr(); cur; cur = cur->next) {
+    os << "(" << cur->data << ")";
+  }
+  os << "]";
+  return os;
+}
+
+// print() and printThroughStream() on two streams set up by configure.
+template <typename T, typename Configure>
+static void requireSameText(const LinkedList<T>& list, Configure configure) {
+  std::ostringstream fast;
+  std::ostringstream slow;
+  configure(fast);
+  configure(slow);
+  fast << list;
+  printThroughStream(slow, list);
+  REQUIRE(fast.str() == slow.str());
+}
+
+template <typename T>
+static void requireSameText(const LinkedList<T>& list) {
+  requireSameText(list, [](std::ostream&) {});
+}
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+static double millisecondsSince(std::chrono::high_resolution_clock::time_point start_time) {
+  std::chrono::duration<double, std::milli> dur_ms = std::chrono::high_resolution_clock::now() - start_time;
+  return dur_ms.count();
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+//
+// The list size defaults to 10M items and can be set with LIST_BENCH_ITEMS.
+TEST_CASE("Benchmark: Text print and parse", "[weight=0][.][bench]") {
+
+  long long items = 10000000;
+  if (const char* env = std::getenv("LIST_BENCH_ITEMS")) items = std::atoll(env);
+
+  LinkedList<int> list;
+  for (long long i = 0; i < items; i++) {
+    list.pushBack(static_cast<int>((i * 2654435761u) % 2000000000) - 1000000000);
+  }
+  std::string printedPath = tempTextPath("bench_printed.txt");
+  std::string linesPath = tempTextPath("bench_lines.txt");
+
+  std::cout << std::endl << "Text for " << items << " ints:" << std::endl;
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::ofstream out(printedPath);
+    printThroughStream(out, list);
+    out.close();
+    std::cout << "print, operator<< per piece\t" << millisecondsSince(start_time) << " ms" << std::endl;
+  }
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::ofstream out(printedPath);
+    out << list;
+    out.close();
+    std::cout << "print, buffered\t\t\t" << millisecondsSince(start_time) << " ms" << std::endl;
+  }
+  {
+    std::ofstream out(linesPath);
+    for (const auto* cur = list.getHeadPtr(); cur; cur = cur->next) {
+      out << cur->data << "\n";
+    }
+  }
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    LinkedList<int> parsed;
+    std::ifstream in(printedPath);
+    char open;
+    char close;
+    int value;
+    in >> open;
+    while (in >> open && open == '(' && in >> value >> close) {
+      parsed.pushBack(value);
+    }
+    std::cout << "parse [(..)], operator>>\t" << millisecondsSince(start_time) << " ms" << std::endl;
+    REQUIRE(parsed == list);
+  }
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    LinkedList<int> parsed;
+    loadListText(printedPath, parsed);
+    std::cout << "parse [(..)], loadListText\t" << millisecondsSince(start_time) << " ms" << std::endl;
+    REQUIRE(parsed == list);
+  }
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    LinkedList<int> parsed;
+    std::ifstream in(linesPath);
+    int value;
+    while (in >> value) {
+      parsed.pushBack(value);
+    }
+    std::cout << "parse lines, operator>>\t\t" << millisecondsSince(start_time) << " ms" << std::endl;
+    REQUIRE(parsed == list);
+  }
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    LinkedList<int, ArenaNodeAllocator> parsed;
+    loadListText(linesPath, parsed);
+    std::cout << "parse lines, loadListText arena\t" << millisecondsSince(start_time) << " ms" << std::endl;
+    REQUIRE(parsed.size() == list.size());
+  }
+
+  std::remove(printedPath.c_str());
+  std::remove(linesPath.c_str());
+}
+
+// ========================================================================
+// Tests
+// ========================================================================
+
+TEST_CASE("Testing ListText: Buffered print matches operator<<", "[weight=1]") {
+  SECTION("ints") {
+    LinkedList<int> list;
+    requireSameText(list);
+    for (int i : {0, 1, -1, 9, 10, 99, 100, -12345, 2147483647, INT_MIN}) {
+      list.pushBack(i);
+    }
+    requireSameText(list);
+    std::ostringstream out;
+    out << list;
+    REQUIRE(out.str() == "[(0)(1)(-1)(9)(10)(99)(100)(-12345)(2147483647)(-2147483648)]");
+  }
+
+  SECTION("other integer types") {
+    LinkedList<long long> wide;
+    wide.pushBack(std::numeric_limits<long long>::min());
+    wide.pushBack(std::numeric_limits<long long>::max());
+    requireSameText(wide);
+    LinkedList<unsigned long long> unsignedWide;
+    unsignedWide.pushBack(std::numeric_limits<unsigned long long>::max());
+    unsignedWide.pushBack(0);
+    requireSameText(unsignedWide);
+    LinkedList<short> narrow;
+    narrow.pushBack(-32768);
+    requireSameText(narrow);
+    LinkedList<bool> flags;
+    flags.pushBack(true);
+    flags.pushBack(false);
+    requireSameText(flags);
+  }
+
+  SECTION("floating point") {
+    LinkedList<double> list;
+    for (double d : {0.0, -0.0, 1.5, 1e-300, 123456789.0, 3.14159265358979, -2.5e20,
+                     std::numeric_limits<double>::infinity()}) {
+      list.pushBack(d);
+    }
+    requireSameText(list);
+    requireSameText(list, [](std::ostream& os) { os << std::setprecision(17); });
+    requireSameText(list, [](std::ostream& os) { os << std::setprecision(0); });
+
+    LinkedList<float> floats;
+    floats.pushBack(0.1f);
+    floats.pushBack(-7.25f);
+    requireSameText(floats);
+  }
+
+  SECTION("custom stream flags use operator<<") {
+    LinkedList<int> list;
+    for (int i : {10, 255, -3}) {
+      list.pushBack(i);
+    }
+    requireSameText(list, [](std::ostream& os) { os << std::hex << std::showbase; });
+    requireSameText(list, [](std::ostream& os) { os << std::showpos; });
+    LinkedList<double> doubles;
+    doubles.pushBack(1.0);
+    requireSameText(doubles, [](std::ostream& os) { os << std::fixed; });
+  }
+
+  SECTION("a locale with its own punctuation uses operator<<") {
+    // Groups digits in threes with '.', and uses ',' as the decimal point.
+    struct GermanPunct : std::numpunct<char> {
+      char do_thousands_sep() const override { return '.'; }
+      char do_decimal_point() const override { return ','; }
+      std::string do_grouping() const override { return "\3"; }
+    };
+    auto imbue = [](std::ostream& os) { os.imbue(std::locale(std::locale::classic(), new GermanPunct())); };
+    LinkedList<int> list;
+    list.pushBack(1234567);
+    requireSameText(list, imbue);
+    LinkedList<double> doubles;
+    doubles.pushBack(2.5);
+    requireSameText(doubles, imbue);
+
+    std::ostringstream out;
+    imbue(out);
+    out << list << doubles;
+    REQUIRE(out.str() == "[(1.234.567)][(2,5)]");
+  }
+
+  SECTION("a failed stream gets nothing") {
+    LinkedList<int> list;
+    list.pushBack(1);
+    list.pushBack(2);
+    std::ostringstream out;
+    out.setstate(std::ios_base::failbit);
+    out << list;
+    REQUIRE(out.str() == "");
+    requireSameText(list, [](std::ostream& os) { os.setstate(std::ios_base::failbit); });
+  }
+
+  SECTION("a tied stream is flushed first") {
+    // A stream buffer that counts how often it is flushed.
+    struct CountingBuffer : std::stringbuf {
+      int syncs = 0;
+      int sync() override {
+        syncs++;
+        return 0;
+      }
+    };
+    CountingBuffer tiedBuffer;
+    std::ostream tied(&tiedBuffer);
+    std::ostringstream out;
+    out.tie(&tied);
+    LinkedList<int> list;
+    list.pushBack(1);
+    out << list;
+    REQUIRE(tiedBuffer.syncs >= 1);
+    REQUIRE(out.str() == "[(1)]");
+  }
+
+  SECTION("the buffer is reused") {
+    const char* data = ListTextBuffer::forThread().data();
+    LinkedList<int> longList;
+    for (int i = 0; i < 20000; i++) {
+      longList.pushBack(i);
+    }
+    requireSameText(longList);
+    LinkedList<int> shortList;
+    shortList.pushBack(7);
+    std::ostringstream out;
+    out << shortList;
+    REQUIRE(out.str() == "[(7)]");
+    REQUIRE(ListTextBuffer::forThread().data() == data);
+    REQUIRE(ListTextBuffer::forThread().size() == 0);
+  }
+
+  SECTION("longer than the buffer") {
+    LinkedList<long long> list;
+    for (long long i = 0; i < 100000; i++) {
+      list.pushBack(i * 1000003 - 50000000000LL);
+    }
+    requireSameText(list);
+  }
+}
+
+TEST_CASE("Testing ListText: parseList", "[weight=1]") {
+  LinkedList<int> list;
+  for (int i : {3, -1, 4, 1, -5, 9, INT_MIN, INT_MAX}) {
+    list.pushBack(i);
+  }
+  std::ostringstream printed;
+  printed << list;
+
+  LinkedList<int> parsed;
+  parsed.pushBack(42);
+  parseList(printed.str(), parsed);
+  REQUIRE(parsed == list);
+
+  parseList(std::string("3\n-1\n4 1\t-5\r\n+9\n-2147483648\n2147483647\n"), parsed);
+  REQUIRE(parsed == list);
+
+  parseList(std::string("  [ ( 3)(-1 )\n(4)(1)(-5)(9)(-2147483648)(2147483647) ]\n"), parsed);
+  REQUIRE(parsed == list);
+
+  parseList(std::string("[]"), parsed);
+  REQUIRE(parsed.empty());
+  parsed.pushBack(1);
+  parseList(std::string(" \n "), parsed);
+  REQUIRE(parsed.empty());
+
+  LinkedList<double> doubles;
+  for (double d : {0.5, -1e-7, 6.02214076e23}) {
+    doubles.pushBack(d);
+  }
+  std::ostringstream printedDoubles;
+  printedDoubles << std::setprecision(17) << doubles;
+  LinkedList<double> parsedDoubles;
+  parseList(printedDoubles.str(), parsedDoubles);
+  REQUIRE(parsedDoubles == doubles);
+
+  LinkedList<bool> flags;
+  parseList(std::string("[(1)(0)]"), flags);
+  REQUIRE(flags.size() == 2);
+  REQUIRE(flags.front());
+}
+
+TEST_CASE("Testing ListText: parseList rejects bad text", "[weight=1]") {
+  LinkedList<int> parsed;
+  for (const char* bad : {"[(1)(2)", "[(1)(2]", "[(1)x]", "[(1)] 2", "1 2 x", "1 2-", "[(--1)]",
+                          "2147483648", "-2147483649", "99999999999999999999", "(1)", "1.5"}) {
+    parsed.pushBack(7);
+    REQUIRE_THROWS_AS(parseList(std::string(bad), parsed), std::runtime_error);
+    REQUIRE(parsed.empty());
+  }
+
+  LinkedList<short> narrow;
+  REQUIRE_THROWS_AS(parseList(std::string("40000"), narrow), std::runtime_error);
+  LinkedList<unsigned> positive;
+  REQUIRE_THROWS_AS(parseList(std::string("-1"), positive), std::runtime_error);
+  LinkedList<double> doubles;
+  REQUIRE_THROWS_AS(parseList(std::string("1e999"), doubles), std::runtime_error);
+  REQUIRE_THROWS_AS(parseList(std::string("1.5.2"), doubles), std::runtime_error);
+
+  REQUIRE_THROWS_AS(loadListText(tempTextPath("missing.txt"), parsed), std::runtime_error);
+}
+
+TEST_CASE("Testing ListText: loadListText", "[weight=1]") {
+  std::string path = tempTextPath("load.txt");
+  LinkedList<int> list;
+  for (int i = 0; i < 200000; i++) {
+    list.pushBack(i * 7 - 100000);
+  }
+  {
+    std::ofstream out(path);
+    out << list << "\n";
+  }
+
+  LinkedList<int, ArenaNodeAllocator> loaded;
+  loadListText(path, loaded);
+  REQUIRE(loaded.size() == list.size());
+  REQUIRE(loaded.isSorted());
+  REQUIRE(loaded.assertPrevLinks());
+  REQUIRE(loaded.front() == -100000);
+  REQUIRE(loaded.back() == 199999 * 7 - 100000);
+
+  { std::ofstream out(path); }
+  loadListText(path, loaded);
+  REQUIRE(loaded.empty());
+
+  std::remove(path.c_str());
+}
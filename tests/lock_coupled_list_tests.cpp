@@ -0,0 +1,297 @@
+
+// Tests for LockCoupledList.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../LockCoupledList.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// Collects the current contents of a LockCoupledList.
+template <typename T>
+static std::vector<T> lockCoupledContents(LockCoupledList<T>& list) {
+  std::vector<T> items;
+  list.forEach([&](const T& item) { items.push_back(item); });
+  return items;
+}
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// The baseline: a LinkedList with one mutex around every operation.
+template <typename T>
+class GlobalMutexLinkedList {
+public:
+  void pushBack(const T& newData) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    list_.pushBack(newData);
+  }
+
+  void insertOrdered(const T& newData) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    list_.insertOrdered(newData);
+  }
+
+  bool popFront(T& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (list_.empty()) return false;
+    out = list_.front();
+    list_.popFront();
+    return true;
+  }
+
+  bool popBack(T& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (list_.empty()) return false;
+    out = list_.back();
+    list_.popBack();
+    return true;
+  }
+
+  bool contains(const T& item) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto* cur = list_.getHeadPtr(); cur; cur = cur->next) {
+      if (!(item < cur->data) && !(cur->data < item)) return true;
+    }
+    return false;
+  }
+
+private:
+  std::mutex mutex_;
+  LinkedList<T> list_;
+};
+
+// Each thread runs opsPerThread operations on one shared sorted list of about
+// INITIAL_ITEMS keys: 70% contains, 10% insertOrdered, 10% popFront and 10%
+// popBack. Returns millions of operations per second.
+template <typename ListType>
+static double mixedThroughput(int numThreads, int opsPerThread) {
+  constexpr int INITIAL_ITEMS = 500;
+  constexpr int KEY_RANGE = 1000;
+
+  ListType list;
+  for (int i = 0; i < INITIAL_ITEMS; i++) {
+    list.pushBack(i * KEY_RANGE / INITIAL_ITEMS);
+  }
+
+  std::vector<std::thread> threads;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (int t = 0; t < numThreads; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t + 1);
+      std::uniform_int_distribution<int> keys(0, KEY_RANGE - 1);
+      std::uniform_int_distribution<int> kind(0, 9);
+      int item = 0;
+      for (int i = 0; i < opsPerThread; i++) {
+        int op = kind(rng);
+        if (op < 7) list.contains(keys(rng));
+        else if (op == 7) list.insertOrdered(keys(rng));
+        // Put the popped item back so the list keeps its length.
+        else if (op == 8) { if (list.popFront(item)) list.insertOrdered(item); }
+        else { if (list.popBack(item)) list.insertOrdered(item); }
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  auto stop_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> dur_ms = stop_time - start_time;
+  return static_cast<double>(numThreads) * opsPerThread / dur_ms.count() / 1000.0;
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: Mixed read/write workload", "[weight=0][.][bench]") {
+
+  constexpr int TOTAL_OPS = 8000;
+
+  std::cout << std::endl << "Mixed workload throughput in M ops/s (" << std::thread::hardware_concurrency()
+    << " hardware threads):" << std::endl;
+  std::cout << "threads  mutex+LinkedList  LockCoupledList" << std::endl;
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    double global = mixedThroughput<GlobalMutexLinkedList<int>>(threads, TOTAL_OPS / threads);
+    double coupled = mixedThroughput<LockCoupledList<int>>(threads, TOTAL_OPS / threads);
+    std::cout << threads << "\t " << global << "\t\t   " << coupled << std::endl;
+  }
+}
+
+// ========================================================================
+// Tests
+// ========================================================================
+
+TEST_CASE("Testing LockCoupledList: Single thread operations", "[weight=1]") {
+  LockCoupledList<std::string> list;
+  std::string item;
+  REQUIRE(list.empty());
+  REQUIRE(!list.popFront(item));
+  REQUIRE(!list.popBack(item));
+
+  list.pushBack("b");
+  list.pushFront("a");
+  list.pushBack("d");
+  list.insertOrdered("c");
+  list.insertOrdered("e");
+  REQUIRE(list.size() == 5);
+  REQUIRE(lockCoupledContents(list) == std::vector<std::string>({"a", "b", "c", "d", "e"}));
+  REQUIRE(list.contains("c"));
+  REQUIRE(!list.contains("f"));
+  REQUIRE(list.toLinkedList().size() == 5);
+
+  REQUIRE(list.popFront(item));
+  REQUIRE(item == "a");
+  REQUIRE(list.popBack(item));
+  REQUIRE(item == "e");
+  REQUIRE(list.size() == 3);
+
+  list.clear();
+  REQUIRE(list.empty());
+  REQUIRE(!list.popBack(item));
+
+  // Leave a few items behind for the destructor to clean up.
+  list.pushBack("left");
+  list.pushBack("over");
+}
+
+TEST_CASE("Testing LockCoupledList: insertOrdered matches LinkedList", "[weight=1]") {
+  LockCoupledList<int> list;
+  LinkedList<int> expected;
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> keys(0, 40);
+  for (int i = 0; i < 300; i++) {
+    int key = keys(rng);
+    list.insertOrdered(key);
+    expected.insertOrdered(key);
+  }
+  REQUIRE(list.toLinkedList() == expected);
+  REQUIRE(list.isSorted());
+}
+
+TEST_CASE("Testing LockCoupledList: sort and merge", "[weight=1]") {
+  LockCoupledList<int> list;
+  LockCoupledList<int> other;
+  std::vector<int> all;
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> keys(0, 1000);
+  for (int i = 0; i < 257; i++) {
+    int key = keys(rng);
+    list.pushBack(key);
+    all.push_back(key);
+  }
+  for (int i = 0; i < 100; i++) {
+    int key = keys(rng);
+    other.pushFront(key);
+    all.push_back(key);
+  }
+
+  list.sort();
+  REQUIRE(list.isSorted());
+  other.sort();
+  list.merge(other);
+  REQUIRE(other.empty());
+  REQUIRE(lockCoupledContents(other).empty());
+  std::sort(all.begin(), all.end());
+  REQUIRE(list.size() == static_cast<int>(all.size()));
+  REQUIRE(lockCoupledContents(list) == all);
+
+  // Both lists must still work normally afterwards.
+  int item = 0;
+  REQUIRE(list.popBack(item));
+  REQUIRE(item == all.back());
+  other.pushBack(1);
+  REQUIRE(other.popFront(item));
+  REQUIRE(item == 1);
+}
+
+TEST_CASE("Testing LockCoupledList: Concurrent pushes and pops at both ends", "[weight=1]") {
+  constexpr int PRODUCERS = 3;
+  constexpr int ITEMS_PER_PRODUCER = 5000;
+  constexpr int TOTAL = PRODUCERS * ITEMS_PER_PRODUCER;
+
+  LockCoupledList<int> list;
+  std::vector<std::vector<int>> received(2);
+  std::atomic<int> consumed(0);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < PRODUCERS; p++) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+        if (i % 2) list.pushBack(p * ITEMS_PER_PRODUCER + i);
+        else list.pushFront(p * ITEMS_PER_PRODUCER + i);
+      }
+    });
+  }
+  for (int c = 0; c < 2; c++) {
+    threads.emplace_back([&, c] {
+      int item = 0;
+      while (consumed.load() < TOTAL) {
+        bool popped = (c == 0) ? list.popFront(item) : list.popBack(item);
+        if (popped) {
+          received[c].push_back(item);
+          consumed++;
+        }
+        else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  std::vector<int> seen(TOTAL, 0);
+  for (const auto& items : received) {
+    for (int item : items) {
+      seen[item]++;
+    }
+  }
+  for (int count : seen) {
+    REQUIRE(count == 1);
+  }
+  REQUIRE(list.empty());
+}
+
+TEST_CASE("Testing LockCoupledList: Concurrent inserts, readers and sorts", "[weight=1]") {
+  constexpr int WRITERS = 3;
+  constexpr int INSERTS_PER_WRITER = 1500;
+
+  LockCoupledList<int> list;
+  std::atomic<bool> done(false);
+  std::atomic<int> unsortedReads(0);
+  std::vector<std::thread> threads;
+  for (int w = 0; w < WRITERS; w++) {
+    threads.emplace_back([&, w] {
+      std::mt19937 rng(w + 11);
+      std::uniform_int_distribution<int> keys(0, 300);
+      for (int i = 0; i < INSERTS_PER_WRITER; i++) {
+        list.insertOrdered(keys(rng));
+        if (i % 500 == 0) list.sort();
+      }
+    });
+  }
+  threads.emplace_back([&] {
+    while (!done) {
+      if (!list.isSorted()) unsortedReads++;
+      std::this_thread::yield();
+    }
+  });
+  for (int w = 0; w < WRITERS; w++) {
+    threads[w].join();
+  }
+  done = true;
+  threads.back().join();
+
+  REQUIRE(unsortedReads == 0);
+  REQUIRE(list.size() == WRITERS * INSERTS_PER_WRITER);
+  REQUIRE(static_cast<int>(lockCoupledContents(list).size()) == WRITERS * INSERTS_PER_WRITER);
+  REQUIRE(list.isSorted());
+}
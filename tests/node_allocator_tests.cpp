@@ -0,0 +1,253 @@
+
+// Tests for the LinkedList node allocator policies and the clear() paths.
+
+#include <string>
+#include <chrono>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../HugePageArena.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// The way clear() used to work: pop the tail until the list is empty.
+template <typename T, typename Alloc>
+static void clearByPopBack(LinkedList<T, Alloc>& list) {
+  while (!list.empty()) {
+    list.popBack();
+  }
+}
+
+template <typename ListType, typename Item, typename ClearFunc>
+static double timeTeardown(int listSize, const Item& item, ClearFunc clearFunc) {
+  ListType list;
+  for (int i = 0; i < listSize; i++) {
+    list.pushBack(item);
+  }
+  auto start_time = std::chrono::high_resolution_clock::now();
+  clearFunc(list);
+  auto stop_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> dur_ms = stop_time - start_time;
+  if (!list.empty()) std::cout << "WARNING: list was not emptied!" << std::endl;
+  return dur_ms.count();
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: Tearing down large lists", "[weight=0][.][bench]") {
+
+  constexpr int LIST_SIZE = 2000000;
+  const int ITEM = 42;
+  const std::string STRING_ITEM(40, 'x');
+
+  using HeapList = LinkedList<int>;
+  using ArenaList = LinkedList<int, ArenaNodeAllocator>;
+  using HeapStringList = LinkedList<std::string>;
+  using ArenaStringList = LinkedList<std::string, ArenaNodeAllocator>;
+
+  std::cout << std::endl << "Tearing down a list of " << LIST_SIZE << " items:" << std::endl;
+
+  std::cout << "int, heap nodes, popBack loop: "
+    << timeTeardown<HeapList>(LIST_SIZE, ITEM, [](HeapList& l) { clearByPopBack(l); }) << "ms" << std::endl;
+  std::cout << "int, heap nodes, clear():      "
+    << timeTeardown<HeapList>(LIST_SIZE, ITEM, [](HeapList& l) { l.clear(); }) << "ms" << std::endl;
+  std::cout << "int, arena nodes, popBack loop: "
+    << timeTeardown<ArenaList>(LIST_SIZE, ITEM, [](ArenaList& l) { clearByPopBack(l); }) << "ms" << std::endl;
+  std::cout << "int, arena nodes, clear():      "
+    << timeTeardown<ArenaList>(LIST_SIZE, ITEM, [](ArenaList& l) { l.clear(); }) << "ms" << std::endl;
+
+  std::cout << "std::string, heap nodes, popBack loop: "
+    << timeTeardown<HeapStringList>(LIST_SIZE, STRING_ITEM, [](HeapStringList& l) { clearByPopBack(l); }) << "ms" << std::endl;
+  std::cout << "std::string, heap nodes, clear():      "
+    << timeTeardown<HeapStringList>(LIST_SIZE, STRING_ITEM, [](HeapStringList& l) { l.clear(); }) << "ms" << std::endl;
+  std::cout << "std::string, arena nodes, clear():     "
+    << timeTeardown<ArenaStringList>(LIST_SIZE, STRING_ITEM, [](ArenaStringList& l) { l.clear(); }) << "ms" << std::endl;
+
+  std::cout << "With an arena and a trivially destructible item type, clear() doesn't visit the nodes at all." << std::endl;
+}
+
+template <typename ListType>
+static void timeLargeListWork(const char* label, int listSize) {
+  ListType list;
+  for (int i = listSize; i > 0; i--) {
+    list.pushBack((i * 7919) % listSize);
+  }
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  long long sum = 0;
+  for (auto* cur = list.getHeadPtr(); cur; cur = cur->next) {
+    sum += cur->data;
+  }
+  auto stop_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> traverse_ms = stop_time - start_time;
+
+  start_time = std::chrono::high_resolution_clock::now();
+  ListType sorted = list.mergeSort();
+  stop_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> sort_ms = stop_time - start_time;
+
+  if (!sorted.isSorted()) std::cout << "WARNING: mergeSort result not sorted." << std::endl;
+  if (sum) std::cout << label << ": traversal " << traverse_ms.count() << "ms, mergeSort "
+    << sort_ms.count() << "ms" << std::endl;
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+// For the dTLB side of the story, run it under
+// "perf stat -e dTLB-load-misses ./test [hugepages]".
+TEST_CASE("Benchmark: Huge-page backed arenas", "[weight=0][.][bench][hugepages]") {
+
+  constexpr int LIST_SIZE = 500000;
+
+  std::cout << std::endl << "Traversing and sorting a list of " << LIST_SIZE << " items:" << std::endl;
+  timeLargeListWork<LinkedList<int>>("Heap nodes", LIST_SIZE);
+  timeLargeListWork<LinkedList<int, ArenaNodeAllocator>>("Arena nodes", LIST_SIZE);
+  timeLargeListWork<LinkedList<int, HugePageArenaNodeAllocator>>("Huge-page arena nodes", LIST_SIZE);
+
+  HugePageStats& stats = hugePageStats();
+  std::cout << "Huge-page arena blocks: " << stats.hugetlbBlocks << " with MAP_HUGETLB ("
+    << stats.hugetlbPages << " huge pages), " << stats.transparentBlocks << " with MADV_HUGEPAGE, "
+    << stats.plainBlocks << " on ordinary pages" << std::endl;
+
+  LinkedList<int, HugePageArenaNodeAllocator> list;
+  for (int i = 0; i < LIST_SIZE; i++) {
+    list.pushBack(i);
+  }
+  std::cout << "A list of " << LIST_SIZE << " items in a huge-page arena is backed by "
+    << hugePageBytesInUse(list.allocator()) / HUGE_PAGE_BYTES << " huge pages right now" << std::endl;
+}
+
+// ========================================================================
+// Tests: clear
+// ========================================================================
+
+TEST_CASE("Testing clear: Heap nodes", "[weight=1]") {
+  LinkedList<int> l;
+  for (int i = 0; i < 100; i++) {
+    l.pushBack(i);
+  }
+  l.clear();
+
+  SECTION("Checking that the list is empty") {
+    REQUIRE(l.empty());
+    REQUIRE(l.size() == 0);
+    REQUIRE(l.getHeadPtr() == nullptr);
+    REQUIRE(l.getTailPtr() == nullptr);
+  }
+
+  SECTION("Checking that the list can be reused") {
+    l.pushBack(1);
+    l.pushFront(0);
+    REQUIRE(l.size() == 2);
+    REQUIRE(l.assertPrevLinks());
+    REQUIRE(l.assertCorrectSize());
+  }
+}
+
+TEST_CASE("Testing clear: Arena nodes with non-trivial item type", "[weight=1]") {
+  LinkedList<std::string, ArenaNodeAllocator> l;
+  for (int i = 0; i < 1000; i++) {
+    l.pushBack(std::string(40, 'a' + (i % 26)));
+  }
+  l.clear();
+
+  REQUIRE(l.empty());
+  REQUIRE(l.size() == 0);
+  REQUIRE(l.allocator().blockCount() == 0);
+
+  l.pushBack("x");
+  REQUIRE(l.front() == "x");
+  REQUIRE(l.assertPrevLinks());
+}
+
+// ========================================================================
+// Tests: ArenaNodeAllocator
+// ========================================================================
+
+TEST_CASE("Testing ArenaNodeAllocator: Push, pop and reuse", "[weight=1]") {
+  LinkedList<int, ArenaNodeAllocator> l(ArenaNodeAllocator(1024));
+  for (int i = 0; i < 500; i++) {
+    l.pushBack(i);
+  }
+
+  SECTION("Checking that several blocks were used") {
+    REQUIRE(l.allocator().blockCount() > 1);
+    REQUIRE(l.assertPrevLinks());
+    REQUIRE(l.assertCorrectSize());
+  }
+
+  SECTION("Checking that freed nodes are reused") {
+    auto* oldHead = l.getHeadPtr();
+    l.popFront();
+    l.pushBack(500);
+    REQUIRE(l.getTailPtr() == oldHead);
+    REQUIRE(l.back() == 500);
+  }
+
+  SECTION("Checking that copies get their own arena with the same block size") {
+    auto copy = l;
+    REQUIRE(copy == l);
+    REQUIRE(copy.allocator().blockBytes() == 1024);
+    REQUIRE(copy.getHeadPtr() != l.getHeadPtr());
+  }
+}
+
+TEST_CASE("Testing ArenaNodeAllocator: Sorting", "[weight=1]") {
+  LinkedList<int, ArenaNodeAllocator> l;
+  for (int i = 50; i > 0; i--) {
+    l.pushFront(i);
+    l.pushBack(i);
+  }
+  auto sorted = l.mergeSort();
+  REQUIRE(sorted.isSorted());
+  REQUIRE(sorted.size() == l.size());
+  REQUIRE(sorted == l.insertionSort());
+  REQUIRE(sorted == l.mergeSortIterative());
+  REQUIRE(sorted.assertPrevLinks());
+}
+
+// ========================================================================
+// Tests: HugePageArenaNodeAllocator
+// ========================================================================
+
+TEST_CASE("Testing HugePageArenaNodeAllocator: Blocks are whole huge pages", "[weight=1]") {
+  HugePageStats& stats = hugePageStats();
+  std::size_t blocksBefore = stats.hugetlbBlocks + stats.transparentBlocks + stats.plainBlocks;
+
+  LinkedList<int, HugePageArenaNodeAllocator> l;
+  for (int i = 100000; i > 0; i--) {
+    l.pushBack(i);
+  }
+
+  SECTION("Checking that every mapped block was counted, whichever way it was mapped") {
+    std::size_t blocksAfter = stats.hugetlbBlocks + stats.transparentBlocks + stats.plainBlocks;
+    std::size_t mappedBlocks = 0;
+    l.allocator().forEachBlock([&](const void* block, std::size_t bytes) {
+      if (bytes >= HUGE_PAGE_BYTES) {
+        mappedBlocks++;
+        REQUIRE(bytes % HUGE_PAGE_BYTES == 0);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(block) % HUGE_PAGE_BYTES == 0);
+      }
+    });
+    REQUIRE(mappedBlocks > 0);
+    REQUIRE(blocksAfter - blocksBefore == mappedBlocks);
+  }
+
+  SECTION("Checking that the list works as usual") {
+    auto sorted = l.mergeSort();
+    REQUIRE(sorted.isSorted());
+    REQUIRE(sorted.size() == l.size());
+    REQUIRE(sorted.assertPrevLinks());
+    l.clear();
+    REQUIRE(l.empty());
+    REQUIRE(l.allocator().blockCount() == 0);
+  }
+
+  SECTION("Checking that the huge page report is in whole huge pages") {
+    REQUIRE(hugePageBytesInUse(l.allocator()) % HUGE_PAGE_BYTES == 0);
+  }
+}
@@ -0,0 +1,61 @@
+
+// Tests for the perf_event_open counters in bench/PerfCounters.h. Which
+// events exist depends on the machine, so these only check what every
+// machine can promise: a reading for every event, an explanation for the
+// ones that could not be opened, and sensible counts for the events that are there.
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "../bench/PerfCounters.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+static const PerfCounterReading* findReading(const std::vector<PerfCounterReading>& readings, const std::string& name) {
+  for (const PerfCounterReading& reading : readings) {
+    if (name == reading.name) return &reading;
+  }
+  return nullptr;
+}
+
+TEST_CASE("Testing PerfCounters: Missing events are explained, present ones count", "[weight=1]") {
+  PerfCounters counters;
+  REQUIRE(counters.read().size() == PerfCounters::eventNames().size());
+
+  const std::size_t pageSize = 4096;
+  const std::size_t pages = 64;
+  counters.start();
+  char* memory = static_cast<char*>(::mmap(nullptr, pages * pageSize, PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  REQUIRE(memory != MAP_FAILED);
+  for (std::size_t page = 0; page < pages; page++) memory[page * pageSize] = 1;
+  counters.stop();
+  ::munmap(memory, pages * pageSize);
+
+  std::vector<PerfCounterReading> readings = counters.read();
+  // Events named in error() could not be opened, so they never count.
+  // (An opened event may still miss a short run when the kernel
+  // multiplexes, so the converse doesn't hold.)
+  for (const PerfCounterReading& reading : readings) {
+    if (counters.error().find(reading.name) != std::string::npos) REQUIRE(!reading.available);
+  }
+  if (!counters.available()) {
+    REQUIRE(!counters.error().empty());
+    return;
+  }
+
+  // Touching fresh anonymous pages faults each one in.
+  const PerfCounterReading* faults = findReading(readings, "page_faults");
+  REQUIRE(faults != nullptr);
+  if (faults->available) REQUIRE(faults->count >= pages / 2);
+
+  const PerfCounterReading* instructions = findReading(readings, "instructions");
+  REQUIRE(instructions != nullptr);
+  if (instructions->available) REQUIRE(instructions->count >= pages);
+
+  // A stopped counter doesn't move.
+  REQUIRE(counters.read()[0].count == readings[0].count);
+}
@@ -0,0 +1,226 @@
+
+// Tests for PersistentList.
+
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../PersistentList.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// Counts how many times items are copied, which for both list types is the
+// number of nodes they allocate.
+struct CopyCountingItem {
+  static long long copies;
+  int value;
+  CopyCountingItem(int v) : value(v) {}
+  CopyCountingItem(const CopyCountingItem& other) : value(other.value) { copies++; }
+  CopyCountingItem& operator=(const CopyCountingItem& other) {
+    value = other.value;
+    copies++;
+    return *this;
+  }
+  bool operator<(const CopyCountingItem& other) const { return value < other.value; }
+  bool operator<=(const CopyCountingItem& other) const { return value <= other.value; }
+  bool operator==(const CopyCountingItem& other) const { return value == other.value; }
+};
+long long CopyCountingItem::copies = 0;
+
+template <typename ListType>
+static std::vector<int> persistentContents(const ListType& list) {
+  std::vector<int> items;
+  for (const auto* cur = list.getHeadPtr(); cur; cur = cur->next) {
+    items.push_back(cur->data);
+  }
+  return items;
+}
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// Runs work() and prints its time and the item copies it made.
+template <typename Work>
+static void reportCopies(const std::string& label, Work work) {
+  CopyCountingItem::copies = 0;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  work();
+  auto stop_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> dur_ms = stop_time - start_time;
+  std::cout << label << "\t" << dur_ms.count() << " ms\t" << CopyCountingItem::copies << " copies" << std::endl;
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: Copy-heavy list patterns", "[weight=0][.][bench]") {
+
+  constexpr int N = 4000;
+  constexpr int SNAPSHOTS = 500;
+
+  std::mt19937 rng(1);
+  LinkedList<CopyCountingItem> linked;
+  for (int i = 0; i < N; i++) {
+    linked.pushBack(CopyCountingItem(static_cast<int>(rng() % 100000)));
+  }
+  PersistentList<CopyCountingItem> persistent = PersistentList<CopyCountingItem>::fromLinkedList(linked);
+
+  std::cout << std::endl << "Copy-heavy patterns on " << N << " items:" << std::endl;
+
+  reportCopies("LinkedList      mergeSortRecursive", [&] {
+    REQUIRE(linked.mergeSortRecursive().isSorted());
+  });
+  reportCopies("PersistentList  mergeSortRecursive", [&] {
+    REQUIRE(persistent.mergeSortRecursive().isSorted());
+  });
+  reportCopies("LinkedList      mergeSortIterative", [&] {
+    REQUIRE(linked.mergeSortIterative().isSorted());
+  });
+  reportCopies("PersistentList  mergeSortIterative", [&] {
+    REQUIRE(persistent.mergeSortIterative().isSorted());
+  });
+
+  // Keep a snapshot of the list after each of a series of pushFronts, as
+  // undo histories and versioned configurations do.
+  reportCopies("LinkedList      snapshots", [&] {
+    LinkedList<LinkedList<CopyCountingItem>> history;
+    LinkedList<CopyCountingItem> current = linked;
+    for (int i = 0; i < SNAPSHOTS; i++) {
+      current.pushFront(CopyCountingItem(i));
+      history.pushBack(current);
+    }
+    REQUIRE(history.back().size() == N + SNAPSHOTS);
+  });
+  reportCopies("PersistentList  snapshots", [&] {
+    LinkedList<PersistentList<CopyCountingItem>> history;
+    PersistentList<CopyCountingItem> current = persistent;
+    for (int i = 0; i < SNAPSHOTS; i++) {
+      current = current.pushFront(CopyCountingItem(i));
+      history.pushBack(current);
+    }
+    REQUIRE(history.back().size() == N + SNAPSHOTS);
+  });
+}
+
+// ========================================================================
+// Tests
+// ========================================================================
+
+TEST_CASE("Testing PersistentList: Versions share nodes", "[weight=1]") {
+  PersistentList<int> empty;
+  REQUIRE(empty.empty());
+  REQUIRE(empty.popFront().empty());
+
+  PersistentList<int> a = empty.pushFront(3).pushFront(2).pushFront(1);
+  PersistentList<int> b = a.pushFront(0);
+  PersistentList<int> c = a.popFront();
+
+  REQUIRE(persistentContents(a) == std::vector<int>({1, 2, 3}));
+  REQUIRE(persistentContents(b) == std::vector<int>({0, 1, 2, 3}));
+  REQUIRE(persistentContents(c) == std::vector<int>({2, 3}));
+  REQUIRE(b.getHeadPtr()->next == a.getHeadPtr());
+  REQUIRE(c.getHeadPtr() == a.getHeadPtr()->next);
+  a.assertCorrectSize();
+  b.assertCorrectSize();
+  c.assertCorrectSize();
+
+  // Copies only bump the reference count.
+  PersistentList<int> copy = a;
+  REQUIRE(copy.getHeadPtr() == a.getHeadPtr());
+  REQUIRE(a.headUseCount() == 3);
+  REQUIRE(copy == a);
+  copy = empty;
+  REQUIRE(a.headUseCount() == 2);
+
+  REQUIRE(a.pushBack(4).toLinkedList().size() == 4);
+  REQUIRE(a.front() == 1);
+  REQUIRE_THROWS(empty.front());
+
+  std::stringstream out;
+  out << a;
+  REQUIRE(out.str() == "[(1)(2)(3)]");
+  // The same text as the other list types print for the same items.
+  std::stringstream linked;
+  linked << a.toLinkedList();
+  REQUIRE(out.str() == linked.str());
+}
+
+TEST_CASE("Testing PersistentList: insertOrdered and merge share suffixes", "[weight=1]") {
+  PersistentList<int> list;
+  for (int i : {9, 7, 5, 3, 1}) {
+    list = list.pushFront(i);
+  }
+  PersistentList<int> inserted = list.insertOrdered(4);
+  REQUIRE(persistentContents(inserted) == std::vector<int>({1, 3, 4, 5, 7, 9}));
+  REQUIRE(persistentContents(list) == std::vector<int>({1, 3, 5, 7, 9}));
+  // The nodes from 5 onwards are the original ones.
+  REQUIRE(inserted.getHeadPtr()->next->next->next == list.getHeadPtr()->next->next);
+
+  PersistentList<int> small;
+  small = small.pushFront(2);
+  PersistentList<int> merged = small.merge(list);
+  REQUIRE(persistentContents(merged) == std::vector<int>({1, 2, 3, 5, 7, 9}));
+  REQUIRE(merged.getHeadPtr()->next->next == list.getHeadPtr()->next);
+  merged.assertCorrectSize();
+}
+
+TEST_CASE("Testing PersistentList: splitHalves and explode", "[weight=1]") {
+  LinkedList<int> linked;
+  for (int i = 1; i <= 5; i++) {
+    linked.pushBack(i);
+  }
+  PersistentList<int> list = PersistentList<int>::fromLinkedList(linked);
+
+  PersistentList<PersistentList<int>> halves = list.splitHalves();
+  REQUIRE(halves.size() == 2);
+  LinkedList<LinkedList<int>> expectedHalves = linked.splitHalves();
+  REQUIRE(halves.front().toLinkedList() == expectedHalves.front());
+  REQUIRE(halves.popFront().front().toLinkedList() == expectedHalves.back());
+  // The right half is the original list's tail.
+  REQUIRE(halves.popFront().front().getHeadPtr() == list.getHeadPtr()->next->next->next);
+
+  PersistentList<PersistentList<int>> singles = list.explode();
+  REQUIRE(singles.size() == 5);
+  int expected = 1;
+  for (const auto* cur = singles.getHeadPtr(); cur; cur = cur->next) {
+    REQUIRE(cur->data.size() == 1);
+    REQUIRE(cur->data.front() == expected++);
+  }
+}
+
+TEST_CASE("Testing PersistentList: mergeSort matches LinkedList", "[weight=1]") {
+  std::mt19937 rng(9);
+  for (int n : {0, 1, 2, 3, 17, 256, 1001}) {
+    LinkedList<int> linked;
+    for (int i = 0; i < n; i++) {
+      linked.pushBack(static_cast<int>(rng() % 50));
+    }
+    PersistentList<int> list = PersistentList<int>::fromLinkedList(linked);
+    LinkedList<int> expected = linked.mergeSort();
+
+    PersistentList<int> recursive = list.mergeSortRecursive();
+    PersistentList<int> iterative = list.mergeSortIterative();
+    REQUIRE(recursive.toLinkedList() == expected);
+    REQUIRE(iterative.toLinkedList() == expected);
+    REQUIRE(recursive.isSorted());
+    recursive.assertCorrectSize();
+    iterative.assertCorrectSize();
+    // The input version is unchanged.
+    REQUIRE(list.toLinkedList() == linked);
+  }
+}
+
+TEST_CASE("Testing PersistentList: Long lists are freed without recursion", "[weight=1]") {
+  PersistentList<int> list;
+  for (int i = 0; i < 1000000; i++) {
+    list = list.pushFront(i);
+  }
+  PersistentList<int> tail = list.popFront().popFront();
+  list = PersistentList<int>();
+  REQUIRE(tail.size() == 999998);
+  REQUIRE(tail.headUseCount() == 1);
+}
@@ -0,0 +1,240 @@
+
+// Tests for the binary list file format in ListSerialization.h.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include <unistd.h>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../ListSerialization.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// A file name in /tmp that no other test process will use.
+static std::string tempListPath(const std::string& name) {
+  return "/tmp/linked_list_" + std::to_string(::getpid()) + "_" + name;
+}
+
+struct SerializedPoint {
+  int x;
+  short y;
+  bool operator<(const SerializedPoint& other) const { return x < other.x; }
+};
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+static double millisecondsSince(std::chrono::high_resolution_clock::time_point start_time) {
+  std::chrono::duration<double, std::milli> dur_ms = std::chrono::high_resolution_clock::now() - start_time;
+  return dur_ms.count();
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+//
+// The list size defaults to 10M items; set LIST_BENCH_ITEMS=100000000 for
+// the 100M-item run (that needs about 8 GB of memory for the heap and arena
+// lists together).
+TEST_CASE("Benchmark: Startup from text vs binary list files", "[weight=0][.][bench]") {
+
+  long long items = 10000000;
+  if (const char* env = std::getenv("LIST_BENCH_ITEMS")) items = std::atoll(env);
+
+  std::string textPath = tempListPath("bench.txt");
+  std::string binPath = tempListPath("bench.bin");
+  {
+    LinkedList<int> source;
+    std::ofstream text(textPath);
+    for (long long i = 0; i < items; i++) {
+      int value = static_cast<int>(i * 7);
+      source.pushBack(value);
+      text << value << "\n";
+    }
+    auto start_time = std::chrono::high_resolution_clock::now();
+    saveList(source, binPath);
+    std::cout << std::endl << "Startup with " << items << " sorted ints:" << std::endl;
+    std::cout << "saveList\t\t\t" << millisecondsSince(start_time) << " ms" << std::endl;
+  }
+
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    LinkedList<int> list;
+    std::ifstream text(textPath);
+    int value;
+    while (text >> value) {
+      list.pushBack(value);
+    }
+    std::cout << "text parse + pushBack\t\t" << millisecondsSince(start_time) << " ms" << std::endl;
+    REQUIRE(list.size() == items);
+  }
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    LinkedList<int> list;
+    loadList(binPath, list);
+    std::cout << "loadList (heap nodes)\t\t" << millisecondsSince(start_time) << " ms" << std::endl;
+    REQUIRE(list.size() == items);
+  }
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    LinkedList<int, ArenaNodeAllocator> list;
+    loadList(binPath, list);
+    std::cout << "loadList (arena, one block)\t" << millisecondsSince(start_time) << " ms" << std::endl;
+    REQUIRE(list.size() == items);
+  }
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    LinkedList<int, ArenaNodeAllocator> list;
+    loadList(binPath, list, false);
+    std::cout << "loadList (arena, no checksum)\t" << millisecondsSince(start_time) << " ms" << std::endl;
+  }
+  {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    MappedListView<int> view(binPath);
+    long long sum = 0;
+    for (int value : view) {
+      sum += value;
+    }
+    std::cout << "MappedListView + full scan\t" << millisecondsSince(start_time) << " ms" << std::endl;
+    REQUIRE(view.isSorted());
+    REQUIRE(sum == 7 * (items - 1) * items / 2);
+  }
+
+  std::remove(textPath.c_str());
+  std::remove(binPath.c_str());
+}
+
+// ========================================================================
+// Tests
+// ========================================================================
+
+TEST_CASE("Testing ListSerialization: Round trip", "[weight=1]") {
+  std::string path = tempListPath("roundtrip.bin");
+
+  SECTION("ints, sorted") {
+    LinkedList<int> list;
+    for (int i = 0; i < 100000; i++) {
+      list.pushBack(i / 3);
+    }
+    saveList(list, path);
+
+    LinkedList<int> loaded;
+    loaded.pushBack(-1);
+    loadList(path, loaded);
+    REQUIRE(loaded == list);
+    REQUIRE(loaded.assertCorrectSize());
+    REQUIRE(loaded.assertPrevLinks());
+
+    MappedListView<int> view(path);
+    REQUIRE(view.size() == 100000);
+    REQUIRE(view.isSorted());
+    REQUIRE(view.checksumMatches());
+    REQUIRE(view.equals(list));
+    REQUIRE(view.front() == 0);
+    REQUIRE(view.back() == 33333);
+    REQUIRE(view[4] == 1);
+  }
+
+  SECTION("structs, unsorted") {
+    LinkedList<SerializedPoint> list;
+    std::mt19937 rng(2);
+    for (int i = 0; i < 1001; i++) {
+      list.pushBack(SerializedPoint{static_cast<int>(rng() % 1000), static_cast<short>(i)});
+    }
+    saveList(list, path);
+
+    LinkedList<SerializedPoint> loaded;
+    loadList(path, loaded);
+    REQUIRE(loaded.size() == 1001);
+    MappedListView<SerializedPoint> view(path);
+    REQUIRE(!view.isSorted());
+    REQUIRE(view.equals(loaded));
+    REQUIRE(view.equals(list));
+  }
+
+  SECTION("empty list") {
+    LinkedList<int> list;
+    saveList(list, path);
+    LinkedList<int> loaded;
+    loaded.pushBack(5);
+    loadList(path, loaded);
+    REQUIRE(loaded.empty());
+    MappedListView<int> view(path);
+    REQUIRE(view.empty());
+    REQUIRE(view.begin() == view.end());
+    REQUIRE(view.isSorted());
+    REQUIRE_THROWS(view.front());
+  }
+
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Testing ListSerialization: Arena load uses one block", "[weight=1]") {
+  std::string path = tempListPath("arena.bin");
+  LinkedList<int> list;
+  for (int i = 0; i < 50000; i++) {
+    list.pushBack(i);
+  }
+  saveList(list, path);
+
+  LinkedList<int, ArenaNodeAllocator> loaded;
+  loadList(path, loaded);
+  REQUIRE(loaded.allocator().blockCount() == 1);
+  REQUIRE(loaded.size() == 50000);
+  REQUIRE(loaded.isSorted());
+  REQUIRE(loaded.assertPrevLinks());
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Testing ListSerialization: Bad files are rejected", "[weight=1]") {
+  std::string path = tempListPath("bad.bin");
+  LinkedList<int> list;
+  for (int i = 0; i < 1000; i++) {
+    list.pushBack(i);
+  }
+  LinkedList<int> loaded;
+
+  SECTION("missing file") {
+    REQUIRE_THROWS_AS(loadList(tempListPath("missing.bin"), loaded), std::runtime_error);
+  }
+
+  SECTION("wrong item size") {
+    saveList(list, path);
+    LinkedList<long long> wrongType;
+    REQUIRE_THROWS_AS(loadList(path, wrongType), std::runtime_error);
+  }
+
+  SECTION("not a list file") {
+    std::ofstream(path) << "this is not a list file, but it is long enough to hold a header......";
+    REQUIRE_THROWS_AS(loadList(path, loaded), std::runtime_error);
+  }
+
+  SECTION("truncated file") {
+    saveList(list, path);
+    REQUIRE(::truncate(path.c_str(), sizeof(ListFileHeader) + 10) == 0);
+    REQUIRE_THROWS_AS(loadList(path, loaded), std::runtime_error);
+    REQUIRE_THROWS_AS(MappedListView<int>(path), std::runtime_error);
+  }
+
+  SECTION("corrupted item") {
+    saveList(list, path);
+    {
+      std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(sizeof(ListFileHeader) + 123);
+      file.put(42);
+    }
+    REQUIRE_THROWS_AS(loadList(path, loaded), std::runtime_error);
+    // Without the check, the file loads as it is.
+    loadList(path, loaded, false);
+    REQUIRE(loaded.size() == 1000);
+    REQUIRE(!MappedListView<int>(path).checksumMatches());
+  }
+
+  std::remove(path.c_str());
+}
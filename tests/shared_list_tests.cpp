@@ -0,0 +1,253 @@
+
+// Tests for SharedList.
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../SharedList.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// Counts live instances, to check that old versions are freed.
+struct VersionedItem {
+  static std::atomic<int> live;
+  int value;
+  VersionedItem(int v) : value(v) { live++; }
+  VersionedItem(const VersionedItem& other) : value(other.value) { live++; }
+  VersionedItem& operator=(const VersionedItem& other) = default;
+  ~VersionedItem() { live--; }
+  bool operator<(const VersionedItem& other) const { return value < other.value; }
+};
+std::atomic<int> VersionedItem::live(0);
+
+template <typename ListType>
+static long long sumList(const ListType& list) {
+  long long sum = 0;
+  for (const auto* cur = list.getHeadPtr(); cur; cur = cur->next) {
+    sum += cur->data;
+  }
+  return sum;
+}
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// The baseline: every reader takes the mutex and copies the list, then reads
+// its private copy.
+class MutexCopySharedList {
+public:
+  explicit MutexCopySharedList(const LinkedList<int>& initial) : list_(initial) {}
+
+  long long readSum() {
+    LinkedList<int> copy;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      copy = list_;
+    }
+    return sumList(copy);
+  }
+
+  void replace(const LinkedList<int>& newVersion) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    list_ = newVersion;
+  }
+
+private:
+  std::mutex mutex_;
+  LinkedList<int> list_;
+};
+
+class RcuSharedList {
+public:
+  explicit RcuSharedList(const LinkedList<int>& initial) : shared_(initial) {}
+
+  long long readSum() {
+    return shared_.read([](const LinkedList<int>& list) { return sumList(list); });
+  }
+
+  void replace(const LinkedList<int>& newVersion) {
+    shared_.replace(newVersion);
+  }
+
+private:
+  SharedList<int> shared_;
+};
+
+// numReaders threads sum the list readsPerReader times each, while one
+// writer publishes a new version every WRITE_INTERVAL reads. Returns
+// millions of list reads per second.
+template <typename SharedType>
+static double readThroughput(int numReaders, int readsPerReader) {
+  constexpr int LIST_SIZE = 1000;
+  constexpr int WRITE_INTERVAL = 100;
+
+  LinkedList<int> versions[2];
+  for (int i = 0; i < LIST_SIZE; i++) {
+    versions[0].pushBack(i);
+    versions[1].pushFront(i);
+  }
+  SharedType shared(versions[0]);
+  std::atomic<long long> readsDone(0);
+  std::atomic<bool> stop(false);
+  std::atomic<long long> badSums(0);
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  std::thread writer([&] {
+    long long nextWrite = WRITE_INTERVAL;
+    int version = 0;
+    while (!stop) {
+      if (readsDone.load(std::memory_order_relaxed) >= nextWrite) {
+        version = 1 - version;
+        shared.replace(versions[version]);
+        nextWrite += WRITE_INTERVAL;
+      }
+      std::this_thread::yield();
+    }
+  });
+  std::vector<std::thread> readers;
+  for (int r = 0; r < numReaders; r++) {
+    readers.emplace_back([&] {
+      for (int i = 0; i < readsPerReader; i++) {
+        if (shared.readSum() != LIST_SIZE * (LIST_SIZE - 1) / 2) badSums++;
+        readsDone.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+  for (std::thread& t : readers) {
+    t.join();
+  }
+  auto stop_time = std::chrono::high_resolution_clock::now();
+  stop = true;
+  writer.join();
+
+  REQUIRE(badSums == 0);
+  std::chrono::duration<double, std::milli> dur_ms = stop_time - start_time;
+  return static_cast<double>(numReaders) * readsPerReader / dur_ms.count() / 1000.0;
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: Read-mostly shared list", "[weight=0][.][bench]") {
+
+  constexpr int TOTAL_READS = 6400;
+
+  std::cout << std::endl << "Reads of a 1000-item list in M reads/s, one writer ("
+    << std::thread::hardware_concurrency() << " hardware threads):" << std::endl;
+  std::cout << "readers  mutex+copy  SharedList" << std::endl;
+  for (int readers : {1, 4, 16, 64}) {
+    double copying = readThroughput<MutexCopySharedList>(readers, TOTAL_READS / readers);
+    double rcu = readThroughput<RcuSharedList>(readers, TOTAL_READS / readers);
+    std::cout << readers << "\t " << copying << "\t     " << rcu << std::endl;
+  }
+}
+
+// ========================================================================
+// Tests
+// ========================================================================
+
+TEST_CASE("Testing SharedList: Views keep their version", "[weight=1]") {
+  LinkedList<int> initial;
+  initial.pushBack(3);
+  initial.pushBack(1);
+  initial.pushBack(2);
+  SharedList<int> shared(initial);
+  REQUIRE(shared.version() == 0);
+
+  SharedList<int>::ReadView before(shared);
+  shared.update([](LinkedList<int>& list) { list = list.mergeSort(); });
+  std::vector<int> batch = {0, 5, 2};
+  shared.insertOrdered(batch.begin(), batch.end());
+  REQUIRE(shared.version() == 2);
+
+  // The old view still sees the unsorted version.
+  REQUIRE(*before == initial);
+
+  SharedList<int>::ReadView after(shared);
+  REQUIRE(after->size() == 6);
+  REQUIRE(after->isSorted());
+  REQUIRE(shared.read([](const LinkedList<int>& list) { return list.front(); }) == 0);
+}
+
+TEST_CASE("Testing SharedList: Old versions are freed after readers leave", "[weight=1]") {
+  VersionedItem::live = 0;
+  {
+    LinkedList<VersionedItem> initial;
+    for (int i = 0; i < 10; i++) {
+      initial.pushBack(VersionedItem(i));
+    }
+    SharedList<VersionedItem> shared(initial);
+    initial.clear();
+    REQUIRE(VersionedItem::live == 10);
+
+    std::atomic<bool> readerPinned(false);
+    std::atomic<bool> readerRelease(false);
+    std::atomic<int> readerSize(0);
+    std::thread reader([&] {
+      SharedList<VersionedItem>::ReadView view(shared);
+      readerPinned = true;
+      while (!readerRelease) {
+        std::this_thread::yield();
+      }
+      readerSize = view->size();
+    });
+    while (!readerPinned) {
+      std::this_thread::yield();
+    }
+
+    for (int i = 0; i < 5; i++) {
+      shared.update([](LinkedList<VersionedItem>& list) { list.popFront(); });
+    }
+    // The reader's version, and everything after it, must still be alive.
+    REQUIRE(VersionedItem::live >= 10);
+
+    readerRelease = true;
+    reader.join();
+    REQUIRE(readerSize == 10);
+
+    for (int i = 0; i < 5; i++) {
+      EpochReclamation::collect();
+    }
+    // Only the current version is left.
+    REQUIRE(VersionedItem::live == 5);
+  }
+  REQUIRE(VersionedItem::live == 0);
+}
+
+TEST_CASE("Testing SharedList: Concurrent readers see whole versions", "[weight=1]") {
+  constexpr int READERS = 6;
+  constexpr int UPDATES = 200;
+
+  // Every version holds 0, 1, ..., k-1 in order for some k.
+  SharedList<int> shared;
+  std::atomic<bool> done(false);
+  std::atomic<int> badReads(0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < READERS; r++) {
+    readers.emplace_back([&] {
+      while (!done) {
+        SharedList<int>::ReadView view(shared);
+        int expected = 0;
+        for (const auto* cur = view->getHeadPtr(); cur; cur = cur->next) {
+          if (cur->data != expected++) badReads++;
+        }
+        if (expected != view->size()) badReads++;
+      }
+    });
+  }
+  for (int i = 0; i < UPDATES; i++) {
+    shared.update([i](LinkedList<int>& list) { list.pushBack(i); });
+  }
+  done = true;
+  for (std::thread& t : readers) {
+    t.join();
+  }
+
+  REQUIRE(badReads == 0);
+  REQUIRE(shared.read([](const LinkedList<int>& list) { return list.size(); }) == UPDATES);
+}
@@ -0,0 +1,311 @@
+
+// Tests for SharedMemoryList.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../SharedMemoryList.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// A segment name that no other test process will use.
+static std::string tempSegmentName(const std::string& name) {
+  return "/linked_list_" + std::to_string(::getpid()) + "_" + name;
+}
+
+// Fork a child that runs work() and exits with its return value. Returns
+// the child's pid.
+template <typename Work>
+static pid_t forkChild(Work work) {
+  pid_t pid = ::fork();
+  if (pid == 0) {
+    int status = 1;
+    try {
+      status = work();
+    }
+    catch (...) {
+    }
+    ::_exit(status);
+  }
+  return pid;
+}
+
+// Wait for a child and return whether it exited with status 0.
+static bool childSucceeded(pid_t pid) {
+  int status = 0;
+  return ::waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// This process's proportional set size in KiB: private pages count in
+// full, shared pages are divided among the processes that map them.
+static long proportionalSetKb() {
+  std::ifstream rollup("/proc/self/smaps_rollup");
+  std::string key;
+  long value = 0;
+  while (rollup >> key) {
+    if (key == "Pss:") {
+      rollup >> value;
+      return value;
+    }
+    rollup.ignore(4096, '\n');
+  }
+  return 0;
+}
+
+struct WorkerReport {
+  double ms;
+  long pssKb;
+};
+
+// Run work() in each of PROCESSES children at once, and collect how long
+// each took and how much its proportional set size grew.
+template <typename Work>
+static std::vector<WorkerReport> runWorkers(int processes, Work work) {
+  std::vector<pid_t> pids;
+  std::vector<int> fds;
+  for (int p = 0; p < processes; p++) {
+    int pipeFds[2];
+    REQUIRE(::pipe(pipeFds) == 0);
+    pids.push_back(forkChild([&] {
+      ::close(pipeFds[0]);
+      long pssBefore = proportionalSetKb();
+      auto start_time = std::chrono::high_resolution_clock::now();
+      bool ok = work();
+      std::chrono::duration<double, std::milli> dur_ms = std::chrono::high_resolution_clock::now() - start_time;
+      // Give the other workers time to map the same pages, so that the
+      // shared ones are divided between all of them.
+      ::usleep(200000);
+      WorkerReport report = {dur_ms.count(), proportionalSetKb() - pssBefore};
+      bool written = ::write(pipeFds[1], &report, sizeof(report)) == sizeof(report);
+      return (ok && written) ? 0 : 1;
+    }));
+    ::close(pipeFds[1]);
+    fds.push_back(pipeFds[0]);
+  }
+  std::vector<WorkerReport> reports;
+  for (int p = 0; p < processes; p++) {
+    WorkerReport report = {0, 0};
+    REQUIRE(::read(fds[p], &report, sizeof(report)) == sizeof(report));
+    ::close(fds[p]);
+    REQUIRE(childSucceeded(pids[p]));
+    reports.push_back(report);
+  }
+  return reports;
+}
+
+static void printWorkers(const std::string& label, const std::vector<WorkerReport>& reports) {
+  double maxMs = 0;
+  long totalKb = 0;
+  for (const WorkerReport& r : reports) {
+    if (r.ms > maxMs) maxMs = r.ms;
+    totalKb += r.pssKb;
+  }
+  std::cout << label << "\t" << maxMs << " ms\t" << totalKb / 1024 << " MiB total" << std::endl;
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: Shared-memory list across processes", "[weight=0][.][bench]") {
+
+  constexpr int PROCESSES = 8;
+  constexpr int ITEMS = 2000000;
+
+  std::string name = tempSegmentName("bench");
+  SharedMemoryList<int>::unlink(name);
+  auto start_time = std::chrono::high_resolution_clock::now();
+  {
+    SharedMemoryList<int> shared(name, ITEMS);
+    for (int i = 0; i < ITEMS; i++) {
+      shared.pushBack(i);
+    }
+  }
+  std::chrono::duration<double, std::milli> build_ms = std::chrono::high_resolution_clock::now() - start_time;
+
+  std::cout << std::endl << PROCESSES << " processes each needing a sorted list of " << ITEMS << " ints"
+    << " (the shared one took " << build_ms.count() << " ms to build once):" << std::endl;
+  std::cout << "\t\t\tslowest\tmemory" << std::endl;
+
+  printWorkers("private LinkedList each", runWorkers(PROCESSES, [] {
+    LinkedList<int> local;
+    for (int i = 0; i < ITEMS; i++) {
+      local.pushBack(i);
+    }
+    return local.isSorted();
+  }));
+  printWorkers("attach only\t", runWorkers(PROCESSES, [&] {
+    SharedMemoryList<int> shared(name);
+    return shared.size() == ITEMS;
+  }));
+  printWorkers("attach + isSorted\t", runWorkers(PROCESSES, [&] {
+    SharedMemoryList<int> shared(name);
+    return shared.isSorted();
+  }));
+
+  SharedMemoryList<int>::unlink(name);
+}
+
+// ========================================================================
+// Tests
+// ========================================================================
+
+TEST_CASE("Testing SharedMemoryList: Two mappings in one process", "[weight=1]") {
+  std::string name = tempSegmentName("mappings");
+  SharedMemoryList<int>::unlink(name);
+  {
+    SharedMemoryList<int> created(name, 100);
+    REQUIRE(created.isOwner());
+    REQUIRE(created.empty());
+    REQUIRE_THROWS_AS(SharedMemoryList<int>(name, 100), std::runtime_error);
+
+    for (int i : {10, 30, 50}) {
+      created.pushBack(i);
+    }
+    created.insertOrdered(20);
+    created.insertOrdered(0);
+    created.insertOrdered(60);
+
+    // The second mapping is at a different address but sees the same list.
+    SharedMemoryList<int> attached(name);
+    REQUIRE(!attached.isOwner());
+    REQUIRE(attached.size() == 6);
+    REQUIRE(attached.front() == 0);
+    REQUIRE(attached.isSorted());
+
+    LinkedList<int> expected;
+    for (int i : {0, 10, 20, 30, 50, 60}) {
+      expected.pushBack(i);
+    }
+    REQUIRE(attached.equals(expected));
+    REQUIRE(attached.toLinkedList() == expected);
+
+    attached.pushBack(70);
+    REQUIRE(created.size() == 7);
+    expected.pushBack(70);
+    REQUIRE(created.equals(expected));
+
+    LinkedList<int> local;
+    for (int i : {5, 30, 80}) {
+      local.pushBack(i);
+    }
+    LinkedList<int> merged = created.merge(local);
+    REQUIRE(merged.size() == 10);
+    REQUIRE(merged.isSorted());
+    REQUIRE(merged == expected.merge(local));
+
+    REQUIRE_THROWS_AS(SharedMemoryList<long long>(name), std::runtime_error);
+  }
+  SharedMemoryList<int>::unlink(name);
+  REQUIRE_THROWS_AS(SharedMemoryList<int>(name), std::runtime_error);
+}
+
+TEST_CASE("Testing SharedMemoryList: Full segment", "[weight=1]") {
+  std::string name = tempSegmentName("full");
+  SharedMemoryList<int>::unlink(name);
+  {
+    SharedMemoryList<int> list(name, 3);
+    list.pushBack(1);
+    list.pushBack(2);
+    list.insertOrdered(0);
+    REQUIRE_THROWS_AS(list.pushBack(3), std::runtime_error);
+    REQUIRE_THROWS_AS(list.insertOrdered(3), std::runtime_error);
+    REQUIRE(list.size() == 3);
+    REQUIRE(list.isSorted());
+  }
+  SharedMemoryList<int>::unlink(name);
+}
+
+TEST_CASE("Testing SharedMemoryList: Several processes append", "[weight=1]") {
+  constexpr int PROCESSES = 4;
+  constexpr int ITEMS_PER_PROCESS = 500;
+
+  std::string name = tempSegmentName("processes");
+  SharedMemoryList<int>::unlink(name);
+  {
+    SharedMemoryList<int> list(name, PROCESSES * ITEMS_PER_PROCESS);
+    std::vector<pid_t> pids;
+    for (int p = 0; p < PROCESSES; p++) {
+      pids.push_back(forkChild([&, p] {
+        SharedMemoryList<int> mine(name);
+        for (int i = 0; i < ITEMS_PER_PROCESS; i++) {
+          mine.insertOrdered((i * PROCESSES + p) * 7919 % 10007);
+          // Reading while others write must always see a sorted list.
+          if (i % 100 == 0 && !mine.isSorted()) return 1;
+        }
+        return 0;
+      }));
+    }
+    for (pid_t pid : pids) {
+      REQUIRE(childSucceeded(pid));
+    }
+    REQUIRE(list.size() == PROCESSES * ITEMS_PER_PROCESS);
+    REQUIRE(list.isSorted());
+    int count = 0;
+    list.forEach([&](const int&) { count++; });
+    REQUIRE(count == PROCESSES * ITEMS_PER_PROCESS);
+  }
+  SharedMemoryList<int>::unlink(name);
+}
+
+// Reaches into SharedMemoryList to kill a writer at a chosen point.
+struct SharedMemoryListTesting {
+  // Does the first half of pushBack, linking the item in, and then ends the
+  // process with the lock held, as a writer killed before it updates tail
+  // and size would.
+  template <typename T>
+  [[noreturn]] static void pushBackAndDie(SharedMemoryList<T>& list, const T& newData) {
+    typename SharedMemoryList<T>::WriterLock lock(&list);
+    std::uint64_t newNode = list.newNodeLocked(newData);
+    std::uint64_t tail = list.header()->tail;
+    list.node(newNode)->prev = tail;
+    if (tail) list.node(tail)->next.store(newNode, std::memory_order_release);
+    else list.header()->head.store(newNode, std::memory_order_release);
+    ::_exit(0);
+  }
+};
+
+TEST_CASE("Testing SharedMemoryList: A writer dies midway", "[weight=1]") {
+  std::string name = tempSegmentName("died");
+  SharedMemoryList<int>::unlink(name);
+  {
+    SharedMemoryList<int> list(name, 100);
+    list.pushBack(1);
+    list.pushBack(2);
+    // The child links 3 in and dies before updating tail and size.
+    pid_t pid = forkChild([&] {
+      SharedMemoryList<int> mine(name);
+      SharedMemoryListTesting::pushBackAndDie(mine, 3);
+      return 1;
+    });
+    REQUIRE(childSucceeded(pid));
+    REQUIRE(list.size() == 2);
+
+    // The next writer recovers the lock and repairs tail and size first, so
+    // 4 goes after 3 rather than after the stale tail.
+    list.pushBack(4);
+    REQUIRE(list.size() == 4);
+    LinkedList<int> expected;
+    for (int i : {1, 2, 3, 4}) {
+      expected.pushBack(i);
+    }
+    REQUIRE(list.equals(expected));
+
+    list.insertOrdered(5);
+    REQUIRE(list.size() == 5);
+    REQUIRE(list.isSorted());
+  }
+  SharedMemoryList<int>::unlink(name);
+}
@@ -0,0 +1,161 @@
+
+// Tests for the allocation accounting in ListAllocStats.h. Built into
+// test-stats, which defines LINKEDLIST_ALLOC_STATS (see the Makefile).
+
+#include "../../LinkedList.h"
+#include "../../LinkedListExercises.h"
+#include "../../NodeAllocators.h"
+
+#include "../../uiuc/catch/catch.hpp"
+
+static const std::uint64_t NODE_BYTES = sizeof(LinkedList<int>::Node);
+
+TEST_CASE("Testing ListAllocStats: Counts nodes and item copies", "[weight=1]") {
+  REQUIRE(ListAllocStats::enabled);
+
+  LinkedList<int> list;
+  ListAllocStats stats = measureListAllocs([&] {
+    for (int i = 0; i < 10; i++) list.pushBack(i);
+    list.popBack();
+    list.popFront();
+    list.insertOrdered(4);
+  });
+  REQUIRE(stats.nodeAllocations == 11);
+  REQUIRE(stats.nodeFrees == 2);
+  REQUIRE(stats.bytesAllocated == 11 * NODE_BYTES);
+  REQUIRE(stats.bytesFreed == 2 * NODE_BYTES);
+  REQUIRE(stats.itemCopies == 11);
+  REQUIRE(stats.itemAssignments == 0);
+  REQUIRE(stats.peakLiveNodes == 10);
+  REQUIRE(stats.liveNodes == 9);
+  REQUIRE(stats.peakLiveBytes == 10 * NODE_BYTES);
+  REQUIRE(stats.liveBytes == static_cast<std::int64_t>(9 * NODE_BYTES));
+
+  // Nothing is counted without a collector.
+  list.pushBack(1);
+  REQUIRE(ScopedListAllocStats::active() == nullptr);
+
+  // Destroying existing nodes drives the live count below zero, and the
+  // peak counts only nodes made inside the scope.
+  stats = measureListAllocs([&] {
+    LinkedList<int> copy = list;
+    list.clear();
+  });
+  REQUIRE(stats.nodeAllocations == 10);
+  REQUIRE(stats.nodeFrees == 20);
+  REQUIRE(stats.peakLiveNodes == 10);
+  REQUIRE(stats.liveNodes == -10);
+}
+
+TEST_CASE("Testing ListAllocStats: Collectors nest", "[weight=1]") {
+  ListAllocStats outer;
+  ListAllocStats inner;
+  {
+    ScopedListAllocStats collectOuter(outer);
+    LinkedList<int> a;
+    a.pushBack(1);
+    a.pushBack(2);
+    {
+      ScopedListAllocStats collectInner(inner);
+      LinkedList<int> b;
+      for (int i = 0; i < 5; i++) b.pushBack(i);
+    }
+    REQUIRE(ScopedListAllocStats::active() == &collectOuter);
+  }
+  REQUIRE(ScopedListAllocStats::active() == nullptr);
+
+  REQUIRE(inner.nodeAllocations == 5);
+  REQUIRE(inner.nodeFrees == 5);
+  REQUIRE(inner.peakLiveNodes == 5);
+  REQUIRE(inner.liveNodes == 0);
+
+  // The inner peak came on top of the two nodes of a.
+  REQUIRE(outer.nodeAllocations == 7);
+  REQUIRE(outer.nodeFrees == 7);
+  REQUIRE(outer.itemCopies == 7);
+  REQUIRE(outer.peakLiveNodes == 7);
+  REQUIRE(outer.liveNodes == 0);
+  REQUIRE(outer.peakLiveBytes == 7 * NODE_BYTES);
+  REQUIRE(outer.liveBytes == 0);
+}
+
+TEST_CASE("Testing ListAllocStats: Sorting and other allocators", "[weight=1]") {
+  LinkedList<int> list;
+  for (int i = 64; i > 0; i--) list.pushBack(i);
+
+  // The result survives the scope; every temporary node made on the way
+  // is freed again.
+  LinkedList<int> sorted;
+  ListAllocStats stats = measureListAllocs([&] { sorted = list.mergeSortRecursive(); });
+  REQUIRE(sorted.isSorted());
+  REQUIRE(stats.liveNodes == 64);
+  REQUIRE(stats.nodeAllocations > 64);
+  REQUIRE(stats.nodeFrees == stats.nodeAllocations - 64);
+  REQUIRE(stats.peakLiveNodes >= 128);
+
+  // An arena frees its nodes in bulk, and they still count as freed.
+  stats = measureListAllocs([] {
+    LinkedList<int, ArenaNodeAllocator> arenaList;
+    for (int i = 0; i < 100; i++) arenaList.pushBack(i);
+  });
+  REQUIRE(stats.nodeAllocations == 100);
+  REQUIRE(stats.nodeFrees == 100);
+  REQUIRE(stats.liveNodes == 0);
+}
+
+TEST_CASE("Testing ListMemoryTimeline: Live memory over time", "[weight=1]") {
+  ListMemoryTimeline timeline;
+  {
+    ScopedListMemoryTimeline record(timeline);
+    LinkedList<int> a;
+    for (int i = 0; i < 10; i++) a.pushBack(i);
+    {
+      // A second recorder sees the same changes.
+      ListMemoryTimeline inner;
+      ScopedListMemoryTimeline recordInner(inner);
+      a.popBack();
+      REQUIRE(inner.peakLiveBytes() == 0);
+      REQUIRE(inner.samples().back().liveBytes == -static_cast<std::int64_t>(NODE_BYTES));
+    }
+    REQUIRE(ScopedListMemoryTimeline::active() == &record);
+  }
+  REQUIRE(ScopedListMemoryTimeline::active() == nullptr);
+
+  REQUIRE(timeline.peakLiveBytes() == 10 * NODE_BYTES);
+  REQUIRE(timeline.peakLiveNodes() == 10);
+  // Starts and ends at zero, every step in order, when few enough.
+  const std::vector<ListMemorySample>& samples = timeline.samples();
+  REQUIRE(samples.front().liveBytes == 0);
+  REQUIRE(samples.back().liveBytes == 0);
+  REQUIRE(samples.back().liveNodes == 0);
+  REQUIRE(samples.size() >= 21);
+  for (std::size_t i = 1; i < samples.size(); i++) REQUIRE(samples[i - 1].timeMs <= samples[i].timeMs);
+}
+
+TEST_CASE("Testing ListMemoryTimeline: Stays small and keeps the peak", "[weight=1]") {
+  LinkedList<int> list;
+  for (int i = 0; i < 5000; i++) list.pushBack((i * 7919) % 5000);
+
+  ListMemoryTimeline recursive(64);
+  ListAllocStats stats;
+  {
+    ScopedListMemoryTimeline record(recursive);
+    ScopedListAllocStats collect(stats);
+    REQUIRE(list.mergeSortRecursive().isSorted());
+  }
+  REQUIRE(recursive.samples().size() <= 64);
+  REQUIRE(recursive.samples().size() >= 32);
+  REQUIRE(recursive.peakLiveBytes() == stats.peakLiveBytes);
+  REQUIRE(recursive.samples().back().liveBytes == 0);
+  for (const ListMemorySample& sample : recursive.samples()) {
+    REQUIRE(sample.liveBytes <= static_cast<std::int64_t>(recursive.peakLiveBytes()));
+  }
+
+  // The iterative sort has the whole exploded list alive at once.
+  ListMemoryTimeline iterative;
+  {
+    ScopedListMemoryTimeline record(iterative);
+    REQUIRE(list.mergeSortIterative().isSorted());
+  }
+  REQUIRE(iterative.peakLiveBytes() >= 5000 * (NODE_BYTES + sizeof(LinkedList<LinkedList<int>>::Node)));
+}
@@ -0,0 +1,175 @@
+
+// Tests for the operation recording and replay in ListOpRecorder.h. Built
+// into test-stats, which defines LINKEDLIST_RECORD (see the Makefile).
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../../LinkedList.h"
+#include "../../LinkedListExercises.h"
+#include "../../NodeAllocators.h"
+
+#include "../../uiuc/catch/catch.hpp"
+
+static std::string tempTracePath(const std::string& name) {
+  return "/tmp/linked_list_" + std::to_string(::getpid()) + "_" + name;
+}
+
+// Writes a trace of ints by hand: a header with the given item size, then
+// the operations' bytes as they are.
+static void writeRawTrace(const std::string& path, std::uint32_t elementSize, const std::vector<std::uint8_t>& ops) {
+  ListOpTraceHeader header = {};
+  std::memcpy(header.magic, ListOpTraceHeader::magicBytes(), sizeof(header.magic));
+  header.version = ListOpTraceHeader::CURRENT_VERSION;
+  header.elementSize = elementSize;
+  header.itemKind = 'i';
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  REQUIRE(file != nullptr);
+  std::fwrite(&header, sizeof(header), 1, file);
+  std::fwrite(ops.data(), 1, ops.size(), file);
+  std::fclose(file);
+}
+
+static std::vector<ListOpCode> codesOf(const ListOpTrace& trace) {
+  std::vector<ListOpCode> codes;
+  for (const ListOp& op : trace.ops()) codes.push_back(op.code);
+  return codes;
+}
+
+TEST_CASE("Testing ListOpRecorder: Records operations, not their insides", "[weight=1]") {
+  std::string path = tempTracePath("ops.trace");
+  // Made before recording, so it gets a snapshot when first used.
+  LinkedList<int> existing;
+  existing.pushBack(7);
+  existing.pushBack(3);
+  {
+    ScopedListOpRecorder<int> record(path);
+    LinkedList<int> a;
+    a.pushBack(5);
+    a.pushFront(1);
+    a.insertOrdered(3);
+    existing.popFront();
+    // The sort result is matched to the list it initializes.
+    LinkedList<int> sorted = existing.mergeSortRecursive();
+    sorted.pushBack(9);
+    LinkedList<int> merged = a.merge(sorted);
+    // Lists of other item types aren't recorded.
+    LinkedList<long> other;
+    other.pushBack(1);
+    REQUIRE(record.operationsRecorded() == 8);
+    record.finish();
+  }
+
+  ListOpTrace trace = ListOpTrace::read(path);
+  std::remove(path.c_str());
+  REQUIRE(trace.elementSize() == sizeof(int));
+  REQUIRE(trace.itemKind() == 'i');
+  std::vector<ListOpCode> expected = {
+    ListOpCode::PushBack, ListOpCode::PushFront, ListOpCode::InsertOrdered, ListOpCode::Snapshot,
+    ListOpCode::PopFront, ListOpCode::SortRecursive, ListOpCode::PushBack, ListOpCode::Merge,
+  };
+  REQUIRE(codesOf(trace) == expected);
+
+  const std::vector<ListOp>& ops = trace.ops();
+  REQUIRE(trace.item<int>(ops[2]) == 3);
+  REQUIRE(ops[2].sizeA == 2);
+  REQUIRE(ops[3].itemCount == 2);
+  REQUIRE(trace.item<int>(ops[3], 1) == 3);
+  // The sorted list is the sort's result, and is merged with a.
+  REQUIRE(ops[6].dst == ops[5].dst);
+  REQUIRE(ops[7].a == ops[0].dst);
+  REQUIRE(ops[7].b == ops[5].dst);
+  REQUIRE(ops[7].sizeA == 3);
+  REQUIRE(ops[7].sizeB == 2);
+  // The lists destroyed when the scope ended were not recorded, since
+  // finish() came first.
+}
+
+TEST_CASE("Testing ListOpReplayer: A replay rebuilds the recorded lists", "[weight=1]") {
+  std::string path = tempTracePath("replay.trace");
+  LinkedList<int> expected;
+  {
+    ScopedListOpRecorder<int> record(path);
+    LinkedList<int> queue;
+    LinkedList<int> ordered;
+    for (int i = 0; i < 200; i++) {
+      queue.pushBack((i * 37) % 101);
+      if (i % 3 == 0) queue.popFront();
+      ordered.insertOrdered((i * 53) % 97);
+    }
+    LinkedList<int> sortedQueue;
+    sortedQueue = queue.mergeSortIterative();
+    // An unused result is dropped again.
+    queue.insertionSort();
+    LinkedList<int> all = sortedQueue.merge(ordered);
+    int bulk[3] = {1000, 1001, 1002};
+    all.appendBulk(bulk, 3);
+    all.popBack();
+    expected = all;
+    record.finish();
+  }
+
+  ListOpTrace trace = ListOpTrace::read(path);
+  std::remove(path.c_str());
+  std::uint32_t last = trace.ops().back().dst;
+
+  std::size_t timed = 0;
+  ListOpReplayer<int, LinkedList<int>> heap(trace);
+  heap.run([&](const ListOp&, std::uint64_t) { timed++; });
+  REQUIRE(timed == trace.ops().size());
+  REQUIRE(heap.list(last) != nullptr);
+  REQUIRE(*heap.list(last) == expected);
+
+  ListOpReplayer<int, LinkedList<int, ArenaNodeAllocator>> arena(trace);
+  arena.run([](const ListOp&, std::uint64_t) {});
+  REQUIRE(arena.list(last)->size() == expected.size());
+  REQUIRE(arena.list(last)->front() == expected.front());
+  REQUIRE(arena.list(last)->back() == expected.back());
+
+  // The item type has to match.
+  REQUIRE_THROWS_AS((ListOpReplayer<long, LinkedList<long>>(trace)), std::runtime_error);
+  REQUIRE_THROWS_AS((ListOpReplayer<unsigned, LinkedList<unsigned>>(trace)), std::runtime_error);
+}
+
+TEST_CASE("Testing ListOpTrace: Bad traces are rejected", "[weight=1]") {
+  std::string path = tempTracePath("bad.trace");
+  {
+    ScopedListOpRecorder<int> record(path);
+    LinkedList<int> list;
+    for (int i = 0; i < 10; i++) list.pushBack(i);
+    record.finish();
+  }
+  // Each pushBack is an opcode, an id, a size and an item; cut the last
+  // item short.
+  REQUIRE(::truncate(path.c_str(), sizeof(ListOpTraceHeader) + 10 * (3 + sizeof(int)) - 1) == 0);
+  REQUIRE_THROWS_AS(ListOpTrace::read(path), std::runtime_error);
+
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  REQUIRE(file != nullptr);
+  std::fputs("not a trace at all, but long enough for a header", file);
+  std::fclose(file);
+  REQUIRE_THROWS_AS(ListOpTrace::read(path), std::runtime_error);
+
+  // A clear of list 0, then of list 1, which is fine; then of a list whose
+  // id could only come from a corrupt trace.
+  const std::uint8_t clear = static_cast<std::uint8_t>(ListOpCode::Clear);
+  std::vector<std::uint8_t> ops = {clear, 0, 0, clear, 1, 0};
+  writeRawTrace(path, sizeof(int), ops);
+  REQUIRE(ListOpTrace::read(path).listCount() == 2);
+  ops.insert(ops.end(), {clear, 0xF0, 0xFF, 0xFF, 0xFF, 0x0F, 0});
+  writeRawTrace(path, sizeof(int), ops);
+  REQUIRE_THROWS_AS(ListOpTrace::read(path), std::runtime_error);
+
+  // Items of no size can't be read.
+  const std::uint8_t pushBack = static_cast<std::uint8_t>(ListOpCode::PushBack);
+  writeRawTrace(path, 0, {pushBack, 0, 0});
+  REQUIRE_THROWS_AS(ListOpTrace::read(path), std::runtime_error);
+
+  std::remove(path.c_str());
+  REQUIRE_THROWS_AS(ListOpTrace::read(path), std::runtime_error);
+}
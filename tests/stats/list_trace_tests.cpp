@@ -0,0 +1,98 @@
+
+// Tests for the phase tracing in ListTrace.h. Built into test-stats, which
+// defines LINKEDLIST_TRACE (see the Makefile).
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "../../LinkedList.h"
+#include "../../LinkedListExercises.h"
+
+#include "../../uiuc/catch/catch.hpp"
+
+static int countOf(const std::string& text, const std::string& part) {
+  int count = 0;
+  for (std::size_t at = text.find(part); at != std::string::npos; at = text.find(part, at + 1)) count++;
+  return count;
+}
+
+static LinkedList<int> shuffledList(int size) {
+  LinkedList<int> list;
+  for (int i = 0; i < size; i++) list.pushBack((i * 7919) % size);
+  return list;
+}
+
+TEST_CASE("Testing ListTrace: A sort records balanced, nested phases", "[weight=1]") {
+  REQUIRE(ListTrace::compiledIn());
+  long long oldMinSize = ListTrace::minSize();
+  ListTrace::setMinSize(256);
+  ListTrace::clear();
+
+  LinkedList<int> list = shuffledList(1024);
+  LinkedList<int> sorted = list.mergeSortRecursive();
+  REQUIRE(sorted.isSorted());
+
+  std::ostringstream trace;
+  ListTrace::writeChromeJson(trace);
+  std::string json = trace.str();
+  REQUIRE(json.find("{\"traceEvents\": [") == 0);
+  REQUIRE(json.find("\"dropped_events\": 0") != std::string::npos);
+
+  // The sorts of 1024, 2 x 512 and 4 x 256 items are traced, each with a
+  // split and a merge; the smaller ones aren't.
+  REQUIRE(countOf(json, "\"name\": \"mergeSortRecursive\"") == 2 * 7);
+  REQUIRE(countOf(json, "\"name\": \"splitHalves\"") == 2 * 7);
+  REQUIRE(countOf(json, "\"name\": \"merge\"") == 2 * 7);
+  REQUIRE(countOf(json, "\"ph\": \"B\"") == countOf(json, "\"ph\": \"E\""));
+  // The phases nest: the split and merge of all 1024 items are inside
+  // their sort, and the sorts of 256 items are two levels down.
+  REQUIRE(countOf(json, "\"args\": {\"size\": 1024, \"depth\": 0}") == 2);
+  REQUIRE(countOf(json, "\"args\": {\"size\": 1024, \"depth\": 1}") == 4);
+  REQUIRE(json.find("\"args\": {\"size\": 256, \"depth\": 2}") != std::string::npos);
+  REQUIRE(json.find("\"depth\": 4") == std::string::npos);
+
+  // Nothing is recorded while tracing is off.
+  ListTrace::clear();
+  ListTrace::setEnabled(false);
+  list.mergeSortIterative();
+  ListTrace::setEnabled(true);
+  trace.str("");
+  ListTrace::writeChromeJson(trace);
+  REQUIRE(countOf(trace.str(), "\"ph\":") == 0);
+
+  ListTrace::setMinSize(oldMinSize);
+}
+
+TEST_CASE("Testing ListTrace: Threads get their own buffers", "[weight=1]") {
+  long long oldMinSize = ListTrace::minSize();
+  ListTrace::setMinSize(256);
+  ListTrace::clear();
+
+  // Catch assertions aren't thread-safe, so the threads only report back.
+  std::atomic<int> sorted(0);
+  std::thread first([&sorted] {
+    if (shuffledList(300).mergeSortIterative().isSorted()) sorted++;
+  });
+  std::thread second([&sorted] {
+    if (shuffledList(300).mergeSortIterative().isSorted()) sorted++;
+  });
+  first.join();
+  second.join();
+  REQUIRE(sorted == 2);
+
+  std::ostringstream trace;
+  ListTrace::writeChromeJson(trace);
+  std::string json = trace.str();
+  REQUIRE(countOf(json, "\"name\": \"mergeSortIterative\", \"cat\": \"list\", \"ph\": \"B\"") == 2);
+  REQUIRE(countOf(json, "\"name\": \"explode\", \"cat\": \"list\", \"ph\": \"E\"") == 2);
+
+  // The two sorts are on different thread ids.
+  std::size_t firstTid = json.find("\"tid\": ");
+  REQUIRE(firstTid != std::string::npos);
+  std::string tid = json.substr(firstTid, json.find(',', firstTid) - firstTid);
+  REQUIRE(countOf(json, tid + ",") < countOf(json, "\"tid\": "));
+
+  ListTrace::setMinSize(oldMinSize);
+}
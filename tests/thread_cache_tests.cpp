@@ -0,0 +1,189 @@
+
+// Tests for ThreadCachedNodeAllocator.
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "../LinkedList.h"
+#include "../LinkedListExercises.h"
+#include "../ThreadCachedNodeAllocator.h"
+
+#include "../uiuc/catch/catch.hpp"
+
+// ========================================================================
+// Benchmarks
+// ========================================================================
+
+// One thread builds lists with pushBack and hands them to another thread,
+// which destroys them. Returns the elapsed time in milliseconds.
+template <typename Alloc>
+static double timeProducerConsumer(int numLists, int listSize) {
+  using ListType = LinkedList<int, Alloc>;
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<ListType*> handoff;
+  constexpr std::size_t MAX_IN_FLIGHT = 16;
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+
+  std::thread consumer([&] {
+    for (int n = 0; n < numLists; n++) {
+      ListType* list = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [&] { return !handoff.empty(); });
+        list = handoff.front();
+        handoff.pop_front();
+      }
+      ready.notify_all();
+      delete list;
+    }
+  });
+
+  for (int n = 0; n < numLists; n++) {
+    ListType* list = new ListType();
+    for (int i = 0; i < listSize; i++) {
+      list->pushBack(i);
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ready.wait(lock, [&] { return handoff.size() < MAX_IN_FLIGHT; });
+      handoff.push_back(list);
+    }
+    ready.notify_all();
+  }
+  consumer.join();
+
+  auto stop_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> dur_ms = stop_time - start_time;
+  return dur_ms.count();
+}
+
+// This is hidden because of the [.] tag.
+// You can run it explicitly with: ./test [bench]
+TEST_CASE("Benchmark: Producer/consumer list hand-off", "[weight=0][.][bench]") {
+
+  constexpr int NUM_LISTS = 2000;
+  constexpr int LIST_SIZE = 1000;
+
+  std::cout << std::endl << "Building " << NUM_LISTS << " lists of " << LIST_SIZE
+    << " items on one thread and destroying them on another:" << std::endl;
+
+  double heap_ms = timeProducerConsumer<HeapNodeAllocator>(NUM_LISTS, LIST_SIZE);
+  std::cout << "HeapNodeAllocator: " << heap_ms << "ms ("
+    << (NUM_LISTS * static_cast<double>(LIST_SIZE)) / heap_ms / 1000.0 << "M nodes/s)" << std::endl;
+
+  double cached_ms = timeProducerConsumer<ThreadCachedNodeAllocator>(NUM_LISTS, LIST_SIZE);
+  std::cout << "ThreadCachedNodeAllocator: " << cached_ms << "ms ("
+    << (NUM_LISTS * static_cast<double>(LIST_SIZE)) / cached_ms / 1000.0 << "M nodes/s)" << std::endl;
+
+  auto stats = ThreadCachedNodeAllocator::stats<LinkedList<int, ThreadCachedNodeAllocator>::Node>();
+  std::cout << "Slabs allocated: " << stats.slabsAllocated << ", batches moved to/from the depot: "
+    << stats.batchesToDepot << "/" << stats.batchesFromDepot << std::endl;
+}
+
+// ========================================================================
+// Tests: ThreadCachedNodeAllocator
+// ========================================================================
+
+// A node type of a size that no other test uses, so the counters below
+// only see this test's activity.
+struct ThreadCacheTestItem {
+  char bytes[200];
+};
+
+TEST_CASE("Testing ThreadCachedNodeAllocator: List operations", "[weight=1]") {
+  LinkedList<int, ThreadCachedNodeAllocator> l;
+  for (int i = 300; i > 0; i--) {
+    l.pushBack(i);
+    l.pushFront(i);
+  }
+  for (int i = 0; i < 100; i++) {
+    l.popBack();
+  }
+
+  SECTION("Checking that the list is consistent") {
+    REQUIRE(l.size() == 500);
+    REQUIRE(l.assertPrevLinks());
+    REQUIRE(l.assertCorrectSize());
+  }
+
+  SECTION("Checking that sorting works") {
+    auto sorted = l.mergeSort();
+    REQUIRE(sorted.isSorted());
+    REQUIRE(sorted == l.insertionSort());
+    REQUIRE(sorted == l.mergeSortIterative());
+  }
+}
+
+TEST_CASE("Testing ThreadCachedNodeAllocator: Nodes freed on another thread are reused", "[weight=1]") {
+  using ListType = LinkedList<ThreadCacheTestItem, ThreadCachedNodeAllocator>;
+  constexpr int LIST_SIZE = 1000;
+
+  auto* list = new ListType();
+  for (int i = 0; i < LIST_SIZE; i++) {
+    list->pushBack(ThreadCacheTestItem());
+  }
+  auto before = ThreadCachedNodeAllocator::stats<ListType::Node>();
+
+  std::thread consumer([list] { delete list; });
+  consumer.join();
+
+  // The consumer's frees went to the depot a batch at a time (and the rest
+  // when the thread exited), so building the same list again needs no new
+  // slabs.
+  auto afterFree = ThreadCachedNodeAllocator::stats<ListType::Node>();
+  REQUIRE(afterFree.batchesToDepot - before.batchesToDepot >= LIST_SIZE / NodeCache<sizeof(ListType::Node)>::BATCH_NODES);
+
+  ListType again;
+  for (int i = 0; i < LIST_SIZE; i++) {
+    again.pushBack(ThreadCacheTestItem());
+  }
+  auto afterRebuild = ThreadCachedNodeAllocator::stats<ListType::Node>();
+  REQUIRE(afterRebuild.slabsAllocated == afterFree.slabsAllocated);
+  REQUIRE(afterRebuild.batchesFromDepot > afterFree.batchesFromDepot);
+}
+
+// Another size of node that no other test uses.
+struct ThreadExitTestItem {
+  char bytes[312];
+};
+
+using ThreadExitList = LinkedList<ThreadExitTestItem, ThreadCachedNodeAllocator>;
+
+// A list that grows once more when it is destroyed.
+struct GrowsAtExit {
+  ThreadExitList list;
+  int extra = 0;
+  ~GrowsAtExit() {
+    for (int i = 0; i < extra; i++) {
+      list.pushBack(ThreadExitTestItem());
+    }
+  }
+};
+
+TEST_CASE("Testing ThreadCachedNodeAllocator: Lists destroyed after the thread's cache", "[weight=1]") {
+  constexpr int LIST_SIZE = 10;
+  auto before = ThreadCachedNodeAllocator::stats<ThreadExitList::Node>();
+
+  std::thread worker([] {
+    // This is constructed before the thread's cache, which the first
+    // pushBack makes, so it is destroyed after the cache at thread exit.
+    static thread_local GrowsAtExit atExit;
+    for (int i = 0; i < LIST_SIZE; i++) {
+      atExit.list.pushBack(ThreadExitTestItem());
+    }
+    atExit.extra = LIST_SIZE;
+  });
+  worker.join();
+
+  // The cache handed its spare nodes to the depot in one batch. After that
+  // the extra nodes came from the depot, and all the list's nodes went
+  // back to it one at a time, rather than through the destroyed cache.
+  auto after = ThreadCachedNodeAllocator::stats<ThreadExitList::Node>();
+  REQUIRE(after.batchesToDepot - before.batchesToDepot == 1 + 2 * LIST_SIZE);
+  REQUIRE(after.slabsAllocated == before.slabsAllocated + 1);
+}